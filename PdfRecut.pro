@@ -4,4 +4,5 @@ CONFIG   += ordered
 SUBDIRS += \
     src/libPoDoFoExtended \
     src/libPdfRecut \
-    src/CPdfRecut
+    src/CPdfRecut \
+    src/PRBenchmarks
@@ -26,7 +26,12 @@
 #include "QsLog.h"
 #include "QsLogDest.h"
 #include <QMutex>
+#include <QWaitCondition>
+#include <QSemaphore>
 #include <QList>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QThread>
 #include <QDateTime>
 #include <QtGlobal>
 #include <cassert>
@@ -71,19 +76,158 @@ static const char* LevelToText(Level theLevel)
     }
 }
 
+//! Lock-free multiple producers / single consumer queue of messages
+//! (intrusive linked list with a stub node, D. Vyukov's algorithm).
+//! Producers never block; the consumer is the writer thread.
+class MessageQueue
+{
+public:
+    MessageQueue() :
+        head(new Node),
+        tail(head)
+    {
+    }
+    ~MessageQueue()
+    {
+        QString message;
+        while( pop(message) ) {}
+        delete tail;
+    }
+    //! Any thread.
+    void push(const QString& message)
+    {
+        Node* node = new Node;
+        node->message = message;
+        Node* prev = head.fetchAndStoreOrdered(node);
+        prev->next.fetchAndStoreRelease(node);
+    }
+    //! Consumer thread only.
+    bool pop(QString& message)
+    {
+        Node* next = tail->next.fetchAndAddAcquire(0);
+        if( !next ) {
+            return false;
+        }
+        message = next->message;
+        next->message.clear();
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        Node() : next(0) {}
+        QAtomicPointer<Node> next;
+        QString message;
+    };
+    QAtomicPointer<Node> head;
+    Node* tail;
+};
+
+//! Background thread writing queued messages to the destinations.
+class LogWriterThread : public QThread
+{
+public:
+    LogWriterThread() : stopRequested(0) {}
+    //! Wake up the thread, wait for it to write the pending messages and stop.
+    void stop();
+    //! Write pending messages (writer thread, or caller once stopped).
+    static void drain();
+
+protected:
+    virtual void run();
+
+private:
+    QAtomicInt stopRequested;
+};
+
 class LoggerImpl
 {
 public:
     LoggerImpl() :
-        level(InfoLevel)
+        level(InfoLevel),
+        writer(0),
+        capacity(0),
+        queued(0),
+        dropped(0),
+        droppedReported(0)
     {
 
     }
     QMutex logMutex;
     Level level;
     DestinationList destList;
+
+    // Asynchronous mode.
+    MessageQueue queue;
+    QAtomicPointer<LogWriterThread> writer;
+    int capacity;
+    QAtomicInt queued;
+    QAtomicInt dropped;
+    int droppedReported;
+    //! Released when the queue becomes non-empty (and on stop request): wakes the writer.
+    QSemaphore pending;
+    //! Signaled when the queue has been drained (c.f. flush).
+    QMutex flushMutex;
+    QWaitCondition flushed;
 };
 
+void LogWriterThread::stop()
+{
+    stopRequested = 1;
+    Logger::instance().d->pending.release();
+    wait();
+}
+
+void LogWriterThread::run()
+{
+    LoggerImpl* d = Logger::instance().d;
+    while( true ) {
+        // Sleeps until the queue becomes non-empty. Wake-ups coalesced before draining.
+        d->pending.acquire();
+        d->pending.tryAcquire(d->pending.available());
+        if( stopRequested ) {
+            break;
+        }
+        // Messages queued meanwhile do not wake the writer: drained until empty
+        // (a message counted may not be linked yet).
+        drain();
+        while( d->queued > 0 && !stopRequested ) {
+            yieldCurrentThread();
+            drain();
+        }
+    }
+    drain();
+}
+
+void LogWriterThread::drain()
+{
+    Logger& logger = Logger::instance();
+    LoggerImpl* d = logger.d;
+    QMutexLocker lock(&d->logMutex);
+    QString message;
+    while( d->queue.pop(message) ) {
+        d->queued.fetchAndAddRelease(-1);
+        logger.write(message);
+    }
+    // Report messages dropped since the last drain.
+    const int dropped = d->dropped;
+    if( dropped != d->droppedReported ) {
+        logger.write(QString("%1 %2 %3 log messages dropped (queue full)")
+                     .arg(LevelToText(WarnLevel), 5)
+                     .arg(QDateTime::currentDateTime().toString(fmtDateTime))
+                     .arg(dropped - d->droppedReported));
+        d->droppedReported = dropped;
+    }
+    // Wake up threads waiting in flush().
+    if( d->queued == 0 ) {
+        QMutexLocker flushLock(&d->flushMutex);
+        d->flushed.wakeAll();
+    }
+}
+
 Logger::Logger() :
     d(new LoggerImpl)
 {
@@ -91,9 +235,71 @@ Logger::Logger() :
 
 Logger::~Logger()
 {
+    setAsynchronous(false);
     delete d;
 }
 
+void Logger::setAsynchronous(bool enabled, int capacity)
+{
+    // Not to be called concurrently (logging threads may run).
+    if( enabled && !isAsynchronous() ) {
+        d->capacity = capacity;
+        LogWriterThread* writer = new LogWriterThread;
+        writer->start(QThread::LowPriority);
+        d->writer.fetchAndStoreOrdered(writer);
+    }
+    else if( !enabled && isAsynchronous() ) {
+        // Producers seeing the writer cleared write synchronously.
+        LogWriterThread* writer = d->writer.fetchAndStoreOrdered(0);
+        writer->stop();
+        delete writer;
+        // Messages pushed while stopping.
+        LogWriterThread::drain();
+        // Threads waiting in flush() see the mode disabled.
+        QMutexLocker flushLock(&d->flushMutex);
+        d->flushed.wakeAll();
+    }
+}
+
+bool Logger::isAsynchronous() const
+{
+    return d->writer.fetchAndAddAcquire(0) != 0;
+}
+
+void Logger::flush()
+{
+    // Not from the writer thread (destinations logging): it would wait for itself.
+    LogWriterThread* writer = d->writer.fetchAndAddAcquire(0);
+    if( !writer || QThread::currentThread() == writer ) {
+        return;
+    }
+    QMutexLocker flushLock(&d->flushMutex);
+    while( d->queued > 0 && isAsynchronous() ) {
+        d->flushed.wait(&d->flushMutex);
+    }
+}
+
+int Logger::droppedMessages() const
+{
+    return d->dropped;
+}
+
+void Logger::enqueue(const QString& message)
+{
+    // Bounded memory: reserve a slot first.
+    const int queued = d->queued.fetchAndAddOrdered(1);
+    if( queued >= d->capacity ) {
+        d->queued.fetchAndAddOrdered(-1);
+        d->dropped.fetchAndAddOrdered(1);
+        return;
+    }
+    d->queue.push(message);
+    // Writer woken on the empty to non-empty transition only: otherwise it is draining.
+    if( queued == 0 ) {
+        d->pending.release();
+    }
+}
+
 void Logger::addDestination(Destination* destination)
 {
     assert(destination);
@@ -121,6 +327,16 @@ void Logger::Helper::writeToLog()
                                   );
 
     Logger& logger = Logger::instance();
+    if( logger.isAsynchronous() && level != FatalLevel ) {
+        logger.enqueue(completeMessage);
+        // Writer stopped meanwhile: the message may not have been drained.
+        if( !logger.isAsynchronous() ) {
+            LogWriterThread::drain();
+        }
+        return;
+    }
+    // Synchronous: fatal messages written after the pending ones.
+    logger.flush();
     QMutexLocker lock(&logger.d->logMutex);
     logger.write(completeMessage);
 }
@@ -59,6 +59,18 @@ public:
    //! The default level is INFO
    Level loggingLevel() const;
 
+   //! Asynchronous mode: messages are pushed on a lock-free queue and
+   //! written by a background thread, woken up by a semaphore. At most
+   //! 'capacity' messages are queued, further messages are dropped (and counted).
+   //! Disabling it writes the pending messages and stops the thread.
+   //! Destinations must outlive the asynchronous mode.
+   void setAsynchronous(bool enabled, int capacity = 65536);
+   bool isAsynchronous() const;
+   //! Blocks until the queued messages have been written.
+   void flush();
+   //! Number of messages dropped since the start (queue full).
+   int droppedMessages() const;
+
    //! The helper forwards the streaming to QDebug and builds the final
    //! log message.
    class Helper
@@ -85,48 +97,56 @@ private:
    ~Logger();
 
    void write(const QString& message);
+   void enqueue(const QString& message);
 
+   friend class LogWriterThread;
    LoggerImpl* d;
 };
 
+//! Enables the asynchronous mode for its lifetime. Declare it after the
+//! destinations, so that pending messages are written before they are destroyed.
+class AsyncLoggingScope
+{
+public:
+   explicit AsyncLoggingScope(int capacity = 65536)
+   {
+      Logger::instance().setAsynchronous(true, capacity);
+   }
+   ~AsyncLoggingScope()
+   {
+      Logger::instance().setAsynchronous(false);
+   }
+};
+
 } // end namespace
 
+//! Compile-time level stripping: define QS_LOG_MIN_LEVEL (0 = trace, ..., 5 = fatal)
+//! to remove messages below this level. The condition is a constant, so the
+//! stripped messages (and their QString::arg formatting) are not compiled in.
+#ifndef QS_LOG_MIN_LEVEL
+   #define QS_LOG_MIN_LEVEL 0
+#endif
+
+#define QLOG_IMPL_(level) \
+   if( QS_LOG_MIN_LEVEL > level || QsLogging::Logger::instance().loggingLevel() > level ){} \
+   else QsLogging::Logger::Helper(level).stream()
+
 //! Logging macros: define QS_LOG_LINE_NUMBERS to get the file and line number
 //! in the log output.
 #ifndef QS_LOG_LINE_NUMBERS
-   #define QLOG_TRACE() \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::TraceLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::TraceLevel).stream()
-   #define QLOG_DEBUG() \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::DebugLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::DebugLevel).stream()
-   #define QLOG_INFO()  \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::InfoLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::InfoLevel).stream()
-   #define QLOG_WARN()  \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::WarnLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::WarnLevel).stream()
-   #define QLOG_ERROR() \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::ErrorLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::ErrorLevel).stream()
+   #define QLOG_TRACE() QLOG_IMPL_(QsLogging::TraceLevel)
+   #define QLOG_DEBUG() QLOG_IMPL_(QsLogging::DebugLevel)
+   #define QLOG_INFO()  QLOG_IMPL_(QsLogging::InfoLevel)
+   #define QLOG_WARN()  QLOG_IMPL_(QsLogging::WarnLevel)
+   #define QLOG_ERROR() QLOG_IMPL_(QsLogging::ErrorLevel)
    #define QLOG_FATAL() \
       QsLogging::Logger::Helper(QsLogging::FatalLevel).stream()
 #else
-   #define QLOG_TRACE() \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::TraceLevel ){} \
-      else  QsLogging::Logger::Helper(QsLogging::TraceLevel).stream() << __FILE__ << '@' << __LINE__
-   #define QLOG_DEBUG() \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::DebugLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::DebugLevel).stream() << __FILE__ << '@' << __LINE__
-   #define QLOG_INFO()  \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::InfoLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::InfoLevel).stream() << __FILE__ << '@' << __LINE__
-   #define QLOG_WARN()  \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::WarnLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::WarnLevel).stream() << __FILE__ << '@' << __LINE__
-   #define QLOG_ERROR() \
-      if( QsLogging::Logger::instance().loggingLevel() > QsLogging::ErrorLevel ){} \
-      else QsLogging::Logger::Helper(QsLogging::ErrorLevel).stream() << __FILE__ << '@' << __LINE__
+   #define QLOG_TRACE() QLOG_IMPL_(QsLogging::TraceLevel) << __FILE__ << '@' << __LINE__
+   #define QLOG_DEBUG() QLOG_IMPL_(QsLogging::DebugLevel) << __FILE__ << '@' << __LINE__
+   #define QLOG_INFO()  QLOG_IMPL_(QsLogging::InfoLevel) << __FILE__ << '@' << __LINE__
+   #define QLOG_WARN()  QLOG_IMPL_(QsLogging::WarnLevel) << __FILE__ << '@' << __LINE__
+   #define QLOG_ERROR() QLOG_IMPL_(QsLogging::ErrorLevel) << __FILE__ << '@' << __LINE__
    #define QLOG_FATAL() \
       QsLogging::Logger::Helper(QsLogging::FatalLevel).stream() << __FILE__ << '@' << __LINE__
 #endif
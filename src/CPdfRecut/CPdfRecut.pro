@@ -4,6 +4,7 @@
 
 QT       += core
 QT       += gui
+QT       += network
 
 TARGET = CPdfRecut
 CONFIG   += console
@@ -11,7 +12,14 @@ CONFIG   -= app_bundle
 TEMPLATE = app
 
 ### Sources !
-SOURCES += main.cpp
+SOURCES += \
+    main.cpp \
+    PRBatchProcessor.cpp \
+    PRService.cpp
+
+HEADERS += \
+    PRBatchProcessor.h \
+    PRService.h
 
 include( $$PWD/../3rdparty/QsLog/QsLog.pri )
 
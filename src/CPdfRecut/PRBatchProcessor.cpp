@@ -0,0 +1,199 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRBatchProcessor.h"
+
+#include "PRDocument.h"
+#include "PRPage.h"
+#include "PRException.h"
+
+#include "PdfeContentsStream.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+#include <QtCore>
+#include <podofo/podofo.h>
+
+using namespace PoDoFo;
+using namespace PoDoFoExtended;
+
+namespace PdfRecut {
+
+/** Task of the pool: processing of one document.
+ */
+class PRBatchProcessor::Task : public QRunnable
+{
+public:
+    Task( PRBatchProcessor* pprocessor, size_t idx ) :
+        m_pProcessor( pprocessor ), m_idx( idx ) { }
+    virtual void run() {
+        m_pProcessor->processFile( m_idx );
+    }
+private:
+    PRBatchProcessor*  m_pProcessor;
+    size_t  m_idx;
+};
+
+//************************************************************//
+//                      PRBatchProcessor                      //
+//************************************************************//
+PRBatchProcessor::PRBatchProcessor( const QString& outputDir, size_t nbJobs ) :
+    m_outputDir( outputDir ),
+    m_nbJobs( nbJobs ? nbJobs : std::max( QThread::idealThreadCount(), 1 ) ),
+    m_nbProcessed( 0 ),
+    m_wallTime( 0 )
+{
+}
+
+QStringList PRBatchProcessor::inputFiles( const QString& path )
+{
+    QStringList filenames;
+    QFileInfo info( path );
+    if( info.isDir() ) {
+        QDir dirFiles( path );
+        dirFiles.setFilter( QDir::Files | QDir::NoSymLinks );
+        dirFiles.setNameFilters( QStringList( "*.pdf" ) );
+        QFileInfoList listFiles = dirFiles.entryInfoList();
+        for( int i = 0 ; i < listFiles.size() ; ++i ) {
+            filenames << listFiles.at( i ).filePath();
+        }
+    }
+    else {
+        // List of files, one per line.
+        QFile file( path );
+        if( file.open( QIODevice::ReadOnly | QIODevice::Text ) ) {
+            QTextStream stream( &file );
+            while( !stream.atEnd() ) {
+                QString line = stream.readLine().trimmed();
+                if( !line.isEmpty() ) {
+                    filenames << line;
+                }
+            }
+        }
+    }
+    return filenames;
+}
+
+void PRBatchProcessor::process( const QStringList& filenames )
+{
+    m_results.clear();
+    m_results.resize( filenames.size() );
+    // Output names prefixed with the input index: same names in different directories.
+    int width = QString::number( filenames.size() ).size();
+    for( int i = 0 ; i < filenames.size() ; ++i ) {
+        m_results[i].filename = filenames.at( i );
+        m_results[i].outputFilename = QDir( m_outputDir ).filePath(
+                    QString( "%1_%2" ).arg( i+1, width, 10, QChar( '0' ) )
+                    .arg( QFileInfo( filenames.at( i ) ).fileName() ) );
+    }
+    m_nbProcessed = 0;
+    QDir().mkpath( m_outputDir );
+
+    // Dedicated pool: the global one is used by documents' workers
+    // (contents decoding and prefetching).
+    QElapsedTimer timer;
+    timer.start();
+    QThreadPool pool;
+    pool.setMaxThreadCount( int( m_nbJobs ) );
+    for( size_t i = 0 ; i < m_results.size() ; ++i ) {
+        pool.start( new Task( this, i ) );
+    }
+    pool.waitForDone();
+    m_wallTime = timer.elapsed();
+}
+void PRBatchProcessor::processFile( size_t idx )
+{
+    Result& result = m_results[idx];
+    QElapsedTimer timer;
+    timer.start();
+    try {
+        PRDocument document( 0 );
+        document.load( result.filename );
+        result.nbPages = document.nbPages();
+
+        // Parse and write back pages contents, one page at a time.
+        PdfeContentsStream contents;
+        for( size_t i = 0 ; i < document.nbPages() ; ++i ) {
+            PRPage* page = document.page( i );
+            contents = page->contents();
+            page->setContents( contents );
+            page->uncacheContents();
+        }
+        document.save( result.outputFilename );
+        document.clear();
+        result.success = true;
+    }
+    catch( const PRException& error ) {
+        result.error = error.description();
+    }
+    catch( const PdfError& error ) {
+        result.error = QString( "PoDoFo error: %1" ).arg( PdfError::ErrorMessage( error.GetError() ) );
+    }
+    catch( const std::exception& error ) {
+        result.error = QString( "Error: %1" ).arg( error.what() );
+    }
+    catch( ... ) {
+        result.error = QString( "Unknown error." );
+    }
+    result.time = timer.elapsed();
+
+    // Progress.
+    int nbProcessed = m_nbProcessed.fetchAndAddOrdered( 1 ) + 1;
+    QMutexLocker locker( &m_outputMutex );
+    std::cout << "[" << nbProcessed << "/" << m_results.size() << "] "
+              << QFileInfo( result.filename ).fileName().toLocal8Bit().constData()
+              << ( result.success ? " : ok (" : " : FAILED (" ) << result.time << " ms)"
+              << std::endl;
+}
+
+size_t PRBatchProcessor::nbFailures() const
+{
+    size_t nbFailures = 0;
+    for( size_t i = 0 ; i < m_results.size() ; ++i ) {
+        nbFailures += !m_results[i].success;
+    }
+    return nbFailures;
+}
+bool PRBatchProcessor::writeSummary( const QString& filename ) const
+{
+    std::ofstream ofile( filename.toLocal8Bit().constData(), std::ios_base::out | std::ios_base::trunc );
+    if( !ofile ) {
+        return false;
+    }
+    qint64 totalTime = 0;
+    size_t nbPages = 0;
+    for( size_t i = 0 ; i < m_results.size() ; ++i ) {
+        totalTime += m_results[i].time;
+        nbPages += m_results[i].nbPages;
+    }
+    ofile << "# files: " << m_results.size()
+          << ", failed: " << this->nbFailures()
+          << ", pages: " << nbPages
+          << ", jobs: " << m_nbJobs << "\n"
+          << "# wall time: " << m_wallTime << " ms"
+          << ", documents time: " << totalTime << " ms\n"
+          << "# status\ttime_ms\tpages\tfile\toutput\terror\n";
+    for( size_t i = 0 ; i < m_results.size() ; ++i ) {
+        const Result& result = m_results[i];
+        ofile << ( result.success ? "ok" : "failed" ) << "\t"
+              << result.time << "\t"
+              << result.nbPages << "\t"
+              << result.filename.toLocal8Bit().constData() << "\t"
+              << result.outputFilename.toLocal8Bit().constData() << "\t"
+              << result.error.simplified().toLocal8Bit().constData() << "\n";
+    }
+    return true;
+}
+
+}
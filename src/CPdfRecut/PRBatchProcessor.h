@@ -0,0 +1,109 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRBATCHPROCESSOR_H
+#define PRBATCHPROCESSOR_H
+
+#include <vector>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+namespace PdfRecut {
+
+//************************************************************//
+//                      PRBatchProcessor                      //
+//************************************************************//
+/** Processing of a batch of PDF documents on a pool of workers.
+ * Each document is handled by a single worker, with its own PRDocument
+ * (and thus its own FreeType library): documents are loaded, the
+ * contents of every page parsed and written back, and the document is
+ * saved in the output directory. Failures are recorded, not propagated.
+ */
+class PRBatchProcessor
+{
+public:
+    /** Result of the processing of a document.
+     */
+    struct Result
+    {
+        /// Path of the document.
+        QString  filename;
+        /// Path of the processed document (prefixed with the input index).
+        QString  outputFilename;
+        /// Processed without error?
+        bool  success;
+        /// Error description (if failed).
+        QString  error;
+        /// Processing time, in milliseconds.
+        qint64  time;
+        /// Number of pages.
+        size_t  nbPages;
+
+        Result() : success( false ), time( 0 ), nbPages( 0 ) { }
+    };
+
+public:
+    /** Create a batch processor.
+     * \param outputDir Directory where processed documents are saved.
+     * \param nbJobs Number of workers (0: number of cores).
+     */
+    PRBatchProcessor( const QString& outputDir, size_t nbJobs );
+
+    /** Input files of a path: PDF files of a directory (not recursive),
+     * or list of files (one path per line) if the path is a text file.
+     */
+    static QStringList inputFiles( const QString& path );
+
+    /** Process documents. Blocks until every document has been processed.
+     * \param filenames Paths of the documents.
+     */
+    void process( const QStringList& filenames );
+    /** Write a summary of the last batch: totals, then one line per
+     * document (status, time, pages, path, error), tab separated.
+     * \return False if the file can not be opened.
+     */
+    bool writeSummary( const QString& filename ) const;
+
+    /// Results of the last batch.
+    const std::vector<Result>& results() const  {   return m_results;   }
+    /// Number of failed documents in the last batch.
+    size_t nbFailures() const;
+    /// Wall-clock time of the last batch, in milliseconds.
+    qint64 wallTime() const     {   return m_wallTime;  }
+
+private:
+    /// Process a document (worker thread).
+    void processFile( size_t idx );
+
+    class Task;
+    friend class Task;
+
+private:
+    /// Output directory.
+    QString  m_outputDir;
+    /// Number of workers.
+    size_t  m_nbJobs;
+    /// Results (one slot per document, written by a single worker).
+    std::vector<Result>  m_results;
+    /// Number of documents processed (progress).
+    QAtomicInt  m_nbProcessed;
+    /// Mutex for progress messages.
+    QMutex  m_outputMutex;
+    /// Wall-clock time of the batch.
+    qint64  m_wallTime;
+};
+
+}
+
+#endif // PRBATCHPROCESSOR_H
@@ -0,0 +1,419 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRService.h"
+
+#include "PRDocumentLayout.h"
+#include "PRException.h"
+
+#include "PdfeFont.h"
+
+#include <stdexcept>
+
+#include <QtCore>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <podofo/podofo.h>
+
+using namespace PoDoFo;
+using namespace PoDoFoExtended;
+
+namespace PdfRecut {
+
+namespace {
+//************************************************************//
+//                        JSON (minimal)                      //
+//************************************************************//
+/** Minimal JSON reader: objects, arrays, strings, numbers, booleans
+ * and null, into QVariant (objects as QVariantMap).
+ */
+class JSONReader
+{
+public:
+    explicit JSONReader( const QString& text ) : m_text( text ), m_pos( 0 ) { }
+    /// Parse a value. Return false on syntax error.
+    bool parse( QVariant& value ) {
+        bool ok = this->parseValue( value );
+        this->skipSpaces();
+        return ok && m_pos == m_text.size();
+    }
+
+private:
+    void skipSpaces() {
+        while( m_pos < m_text.size() && m_text[m_pos].isSpace() ) {
+            ++m_pos;
+        }
+    }
+    bool parseValue( QVariant& value ) {
+        this->skipSpaces();
+        if( m_pos >= m_text.size() ) {
+            return false;
+        }
+        QChar c = m_text[m_pos];
+        if( c == '{' ) {
+            return this->parseObject( value );
+        }
+        else if( c == '[' ) {
+            return this->parseArray( value );
+        }
+        else if( c == '"' ) {
+            QString str;
+            bool ok = this->parseString( str );
+            value = str;
+            return ok;
+        }
+        else if( m_text.mid( m_pos, 4 ) == "true" ) {
+            m_pos += 4;
+            value = true;
+            return true;
+        }
+        else if( m_text.mid( m_pos, 5 ) == "false" ) {
+            m_pos += 5;
+            value = false;
+            return true;
+        }
+        else if( m_text.mid( m_pos, 4 ) == "null" ) {
+            m_pos += 4;
+            value = QVariant();
+            return true;
+        }
+        // Number.
+        int start = m_pos;
+        while( m_pos < m_text.size() &&
+               ( m_text[m_pos].isDigit() || QString( "+-.eE" ).contains( m_text[m_pos] ) ) ) {
+            ++m_pos;
+        }
+        bool ok;
+        value = m_text.mid( start, m_pos - start ).toDouble( &ok );
+        return ok;
+    }
+    bool parseObject( QVariant& value ) {
+        QVariantMap map;
+        ++m_pos;
+        this->skipSpaces();
+        if( m_pos < m_text.size() && m_text[m_pos] == '}' ) {
+            ++m_pos;
+            value = map;
+            return true;
+        }
+        while( true ) {
+            QString key;
+            QVariant item;
+            this->skipSpaces();
+            if( m_pos >= m_text.size() || m_text[m_pos] != '"' || !this->parseString( key ) ) {
+                return false;
+            }
+            this->skipSpaces();
+            if( m_pos >= m_text.size() || m_text[m_pos] != ':' ) {
+                return false;
+            }
+            ++m_pos;
+            if( !this->parseValue( item ) ) {
+                return false;
+            }
+            map.insert( key, item );
+            this->skipSpaces();
+            if( m_pos < m_text.size() && m_text[m_pos] == ',' ) {
+                ++m_pos;
+            }
+            else if( m_pos < m_text.size() && m_text[m_pos] == '}' ) {
+                ++m_pos;
+                value = map;
+                return true;
+            }
+            else {
+                return false;
+            }
+        }
+    }
+    bool parseArray( QVariant& value ) {
+        QVariantList list;
+        ++m_pos;
+        this->skipSpaces();
+        if( m_pos < m_text.size() && m_text[m_pos] == ']' ) {
+            ++m_pos;
+            value = list;
+            return true;
+        }
+        while( true ) {
+            QVariant item;
+            if( !this->parseValue( item ) ) {
+                return false;
+            }
+            list.append( item );
+            this->skipSpaces();
+            if( m_pos < m_text.size() && m_text[m_pos] == ',' ) {
+                ++m_pos;
+            }
+            else if( m_pos < m_text.size() && m_text[m_pos] == ']' ) {
+                ++m_pos;
+                value = list;
+                return true;
+            }
+            else {
+                return false;
+            }
+        }
+    }
+    bool parseString( QString& str ) {
+        ++m_pos;
+        while( m_pos < m_text.size() ) {
+            QChar c = m_text[m_pos++];
+            if( c == '"' ) {
+                return true;
+            }
+            if( c != '\\' ) {
+                str.append( c );
+                continue;
+            }
+            if( m_pos >= m_text.size() ) {
+                return false;
+            }
+            c = m_text[m_pos++];
+            switch( c.toAscii() ) {
+            case 'n':   str.append( '\n' );  break;
+            case 't':   str.append( '\t' );  break;
+            case 'r':   str.append( '\r' );  break;
+            case 'b':   str.append( '\b' );  break;
+            case 'f':   str.append( '\f' );  break;
+            case 'u': {
+                bool ok;
+                ushort code = m_text.mid( m_pos, 4 ).toUShort( &ok, 16 );
+                if( !ok ) {
+                    return false;
+                }
+                str.append( QChar( code ) );
+                m_pos += 4;
+                break;
+            }
+            default:    str.append( c );     break;
+            }
+        }
+        return false;
+    }
+
+private:
+    /// Text parsed.
+    QString  m_text;
+    /// Current position.
+    int  m_pos;
+};
+
+/// Write a JSON value (single line).
+QString toJSON( const QVariant& value )
+{
+    if( value.type() == QVariant::Map ) {
+        QVariantMap map = value.toMap();
+        QStringList items;
+        for( QVariantMap::const_iterator it = map.begin() ; it != map.end() ; ++it ) {
+            items << toJSON( it.key() ) + ": " + toJSON( it.value() );
+        }
+        return "{ " + items.join( ", " ) + " }";
+    }
+    else if( value.type() == QVariant::List ) {
+        QVariantList list = value.toList();
+        QStringList items;
+        for( int i = 0 ; i < list.size() ; ++i ) {
+            items << toJSON( list.at( i ) );
+        }
+        return "[ " + items.join( ", " ) + " ]";
+    }
+    else if( value.type() == QVariant::Bool ) {
+        return value.toBool() ? "true" : "false";
+    }
+    else if( !value.isValid() ) {
+        return "null";
+    }
+    else if( value.type() == QVariant::String ) {
+        QString str = value.toString();
+        QString escaped( "\"" );
+        for( int i = 0 ; i < str.size() ; ++i ) {
+            QChar c = str.at( i );
+            if( c == '"' || c == '\\' ) {
+                escaped += '\\';
+                escaped += c;
+            }
+            else if( c.unicode() < 0x20 ) {
+                escaped += QString( "\\u%1" ).arg( c.unicode(), 4, 16, QChar( '0' ) );
+            }
+            else {
+                escaped += c;
+            }
+        }
+        return escaped + "\"";
+    }
+    return value.toString();
+}
+}
+
+//************************************************************//
+//                          PRService                         //
+//************************************************************//
+PRService::PRService() :
+    m_document(),
+    m_nbJobs( 0 ),
+    m_quit( false )
+{
+    this->warmUp();
+}
+
+void PRService::warmUp()
+{
+    // Standard 14 fonts programs (static cache of PdfeFont).
+    for( int i = 0 ; i < 14 ; ++i ) {
+        PdfeFont::standard14FontData( PdfeFont14Standard::Enum( i ) );
+    }
+    PdfeFont::spaceCharacters();
+}
+
+int PRService::runStandardIO()
+{
+    QTextStream in( stdin );
+    QTextStream out( stdout );
+    while( !m_quit && !in.atEnd() ) {
+        QString line = in.readLine().trimmed();
+        if( line.isEmpty() ) {
+            continue;
+        }
+        out << this->processRequest( line ) << endl;
+    }
+    return 0;
+}
+int PRService::runLocalSocket( const QString& name )
+{
+    // Blocking server: jobs are sequential anyway.
+    QLocalServer server;
+    QLocalServer::removeServer( name );
+    if( !server.listen( name ) ) {
+        QTextStream( stderr ) << "Can not listen on " << name << ": "
+                              << server.errorString() << endl;
+        return 1;
+    }
+    while( !m_quit && server.waitForNewConnection( -1 ) ) {
+        QLocalSocket* psocket = server.nextPendingConnection();
+        while( !m_quit && psocket->state() == QLocalSocket::ConnectedState ) {
+            if( !psocket->canReadLine() && !psocket->waitForReadyRead( -1 ) ) {
+                break;
+            }
+            while( !m_quit && psocket->canReadLine() ) {
+                QString line = QString::fromUtf8( psocket->readLine() ).trimmed();
+                if( line.isEmpty() ) {
+                    continue;
+                }
+                psocket->write( this->processRequest( line ).toUtf8() + '\n' );
+                psocket->flush();
+            }
+        }
+        if( psocket->state() == QLocalSocket::ConnectedState ) {
+            psocket->waitForBytesWritten( -1 );
+            psocket->disconnectFromServer();
+        }
+        delete psocket;
+    }
+    return 0;
+}
+
+QString PRService::processRequest( const QString& line )
+{
+    QVariant request;
+    QVariantMap response;
+    if( !JSONReader( line ).parse( request ) || request.type() != QVariant::Map ) {
+        response["status"] = "error";
+        response["error"] = "Invalid JSON request.";
+        return toJSON( response );
+    }
+    QVariantMap job = request.toMap();
+    response["id"] = job.value( "id" );
+
+    // Commands.
+    QString command = job.value( "command" ).toString();
+    if( command == "quit" ) {
+        m_quit = true;
+        response["status"] = "ok";
+        return toJSON( response );
+    }
+    else if( command == "ping" ) {
+        response["status"] = "ok";
+        response["jobs"] = double( m_nbJobs );
+        return toJSON( response );
+    }
+    else if( !command.isEmpty() ) {
+        response["status"] = "error";
+        response["error"] = QString( "Unknown command: %1." ).arg( command );
+        return toJSON( response );
+    }
+
+    // Document job.
+    QElapsedTimer timer;
+    timer.start();
+    try {
+        this->processJob( job, response );
+        response["status"] = "ok";
+    }
+    catch( const PRException& error ) {
+        response["status"] = "error";
+        response["error"] = error.description();
+    }
+    catch( const PdfError& error ) {
+        response["status"] = "error";
+        response["error"] = QString( "PoDoFo error: %1" ).arg( PdfError::ErrorMessage( error.GetError() ) );
+    }
+    catch( const std::exception& error ) {
+        response["status"] = "error";
+        response["error"] = QString( "Error: %1" ).arg( error.what() );
+    }
+    catch( ... ) {
+        response["status"] = "error";
+        response["error"] = QString( "Unknown error." );
+    }
+    // Free the document in any case: next job starts from scratch.
+    m_document.clear();
+    ++m_nbJobs;
+    response["time_ms"] = double( timer.elapsed() );
+    return toJSON( response );
+}
+
+void PRService::processJob( const QVariantMap& job, QVariantMap& response )
+{
+    QString input = job.value( "input" ).toString();
+    QString output = job.value( "output" ).toString();
+    if( input.isEmpty() || output.isEmpty() ) {
+        throw std::invalid_argument( "job without input or output" );
+    }
+    m_document.load( input );
+    response["pages"] = double( m_document.nbPages() );
+
+    PRDocumentLayout layout;
+    if( this->buildLayout( job.value( "layout" ).toMap(), layout ) ) {
+        layout.applyToDocument( &m_document );
+    }
+    PRDocumentSaveMode::Enum mode = PRDocumentSaveMode::Full;
+    if( job.value( "saveMode" ).toString() == "incremental" ) {
+        mode = PRDocumentSaveMode::Incremental;
+    }
+    m_document.save( output, mode );
+    response["output"] = output;
+}
+bool PRService::buildLayout( const QVariantMap& params, PRDocumentLayout& layout )
+{
+    QString type = params.value( "type", "none" ).toString();
+    if( type == "none" ) {
+        return false;
+    }
+    else if( type != "split" ) {
+        throw std::invalid_argument( "unknown layout type" );
+    }
+    // Split: each page in two zones (top and bottom halves).
+    layout.initSplitPages( &m_document, params.value( "margin", 20.0 ).toDouble() );
+    return true;
+}
+
+}
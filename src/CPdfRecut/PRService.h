@@ -0,0 +1,90 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRSERVICE_H
+#define PRSERVICE_H
+
+#include "PRDocument.h"
+
+#include <QString>
+#include <QVariantMap>
+
+namespace PdfRecut {
+
+class PRDocumentLayout;
+
+//************************************************************//
+//                          PRService                         //
+//************************************************************//
+/** Resident service processing jobs sent as JSON lines, on the standard
+ * input or on a local (Unix domain) socket. The process, its caches
+ * (standard 14 fonts data, ...) and the PRDocument used for jobs (with
+ * its FreeType library) are kept between jobs.
+ *
+ * Request: { "id": ..., "input": "in.pdf", "output": "out.pdf",
+ *            "layout": { "type": "none|split", "margin": 20 },
+ *            "saveMode": "full|incremental" }
+ * or a command: { "id": ..., "command": "ping|quit" }.
+ * Response (one line per request):
+ *   { "id": ..., "status": "ok", "pages": N, "time_ms": T }
+ *   { "id": ..., "status": "error", "error": "..." }
+ */
+class PRService
+{
+public:
+    /// Create the service and warm up process-level caches.
+    PRService();
+
+    /** Process requests read on the standard input, responses written
+     * on the standard output, until end of input or "quit" command.
+     * \return Exit code.
+     */
+    int runStandardIO();
+    /** Process requests of clients connected to a local socket
+     * (one client at a time), until a "quit" command.
+     * \param name Socket name or path.
+     * \return Exit code.
+     */
+    int runLocalSocket( const QString& name );
+
+    /** Process a request.
+     * \param line JSON request.
+     * \return JSON response (single line).
+     */
+    QString processRequest( const QString& line );
+
+private:
+    /// Load data used by every document (standard 14 fonts, ...).
+    void warmUp();
+    /** Process a job: load input, apply layout, save output.
+     * \param job Job parameters.
+     * \param response Response to complete (pages, ...).
+     */
+    void processJob( const QVariantMap& job, QVariantMap& response );
+    /** Build the layout of a job.
+     * \param params Layout parameters.
+     * \param layout Layout to initialize.
+     * \return False if no layout has to be applied.
+     */
+    bool buildLayout( const QVariantMap& params, PRDocumentLayout& layout );
+
+private:
+    /// Document used by jobs (kept between jobs).
+    PRDocument  m_document;
+    /// Number of jobs processed.
+    size_t  m_nbJobs;
+    /// Stop requested?
+    bool  m_quit;
+};
+
+}
+
+#endif // PRSERVICE_H
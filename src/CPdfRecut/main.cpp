@@ -20,6 +20,8 @@
 #include "PRDocumentLayout.h"
 #include "PRDocumentTools.h"
 #include "PRRenderPage.h"
+#include "PRBatchProcessor.h"
+#include "PRService.h"
 
 #include "PRGeometry/PRGDocument.h"
 #include "PRGeometry/PRGSubDocument.h"
@@ -82,61 +84,18 @@ void pageExtract( PdfDocument& doc, int page )
     for(int i=0 ; doc.GetPageCount() > 1 ; i++)
         doc.GetPagesTree()->DeletePage(1);
 }
-void splitPagesLayout( PdfDocument& doc, PRDocumentLayout& docLayout )
+void splitPagesLayout( const PRDocument& document, PRDocumentLayout& docLayout )
 {
-    PdfPage* page;
-    PdfRect pageBox, mediaBox, bleedBox, artBox;
-    PRPageZone pageZone;
-    double delta = 20;
-
-    for( int i = 0 ; i < doc.GetPageCount() ; i++ )
-    {
-        page = doc.GetPage( i );
-
-        pageBox = page->GetCropBox();
-        mediaBox = page->GetMediaBox();
-        bleedBox = page->GetBleedBox();
-        artBox = page->GetArtBox();
-
-        /*if(i < 20)
-        {
-            cout << i << " M: " << mediaBox.GetLeft() << " / " << mediaBox.GetBottom() << " / " << mediaBox.GetWidth() << " / " << mediaBox.GetHeight() << endl;
-            cout << i << " P: " << pageBox.GetLeft() << " / " << pageBox.GetBottom() << " / " << pageBox.GetWidth() << " / " << pageBox.GetHeight() << endl;
-            cout << i << " B: " << bleedBox.GetLeft() << " / " << bleedBox.GetBottom() << " / " << bleedBox.GetWidth() << " / " << bleedBox.GetHeight() << endl;
-            cout << i << " A: " << artBox.GetLeft() << " / " << artBox.GetBottom() << " / " << artBox.GetWidth() << " / " << artBox.GetHeight() << endl;
-        }*/
-
-        if( pageBox.GetWidth() > mediaBox.GetWidth() || pageBox.GetHeight() > mediaBox.GetHeight() ) {
-            pageBox = mediaBox;
-        }
-
-        // First zone in the page
-        pageZone.indexIn = i;
-        pageZone.leftZoneOut = pageBox.GetLeft() + delta;
-        pageZone.bottomZoneOut = pageBox.GetBottom();
-        pageZone.bottomZoneOut = pageBox.GetBottom() + pageBox.GetHeight()/4;
-        pageZone.zoneIn = PdfRect(pageBox.GetLeft() + delta,
-                                  pageBox.GetBottom() + pageBox.GetHeight()/2,
-                                  pageBox.GetWidth() - 2*delta,
-                                  pageBox.GetHeight()/2 - delta );
-
-        docLayout.setPageBoxes(2*i, mediaBox, pageBox);
-        docLayout.addPageZone(2*i, pageZone);
-
-        // Second zone in the page
-        pageZone.indexIn = i;
-        pageZone.leftZoneOut = pageBox.GetLeft() + delta;
-        pageZone.bottomZoneOut = pageBox.GetBottom() + pageBox.GetHeight()/4;
-        //pageZone.bottomZoneOut = pageBox.GetBottom() + delta;
-        pageZone.zoneIn = PdfRect(pageBox.GetLeft() + delta,
-                                  pageBox.GetBottom() + delta,
-                                  pageBox.GetWidth() - 2*delta,
-                                  pageBox.GetHeight()/2 - delta );
-
-        docLayout.setPageBoxes(2*i+1, mediaBox, pageBox);
-        docLayout.addPageZone(2*i+1, pageZone);
-    }
+    // Two zones per page (top and bottom halves).
+    docLayout.initSplitPages( &document, 20.0 );
 }
+/// Directory where profiling data is written (empty: profiling disabled).
+QString profileDir;
+/// Directory of the on-disk contents cache (empty: cache disabled).
+QString contentsCacheDir;
+/// Maximum size of the on-disk contents cache, in MB.
+qint64 contentsCacheSizeMB = 256;
+
 void proceedFile( QString fileName )
 {
     // Document objects.
@@ -145,6 +104,10 @@ void proceedFile( QString fileName )
 
     QTime timeTask;
     timeTask.start();
+    // Profiling data per document.
+    PdfeProfiler& profiler = PdfeProfiler::instance();
+    PdfeProfiler::Allocations allocsStart = PdfeProfiler::threadAllocations();
+    profiler.clear();
 
     // File info
     QFileInfo infoFile( fileName );
@@ -152,7 +115,10 @@ void proceedFile( QString fileName )
 
     // Load PDF file
     document.load( fileName );
-    document.setPagesCacheSize( 30 );
+    document.cacheManager()->setBudget( 512 << 20 );
+    if( !contentsCacheDir.isEmpty() ) {
+        document.setContentsCacheDirectory( contentsCacheDir, contentsCacheSizeMB << 20 );
+    }
 
 
     // Check modifications on contents stream.
@@ -243,6 +209,18 @@ void proceedFile( QString fileName )
     document.clear();
 
     cout << " >>> Time elapsed: " << timeTask.elapsed() << " ms." << endl << endl;
+    if( profiler.isEnabled() ) {
+        if( PdfeProfiler::allocationsTracked() ) {
+            PdfeProfiler::Allocations allocs = PdfeProfiler::threadAllocations();
+            cout << " >>> Allocations (main thread): " << allocs.count - allocsStart.count
+                 << " (" << ( allocs.bytes - allocsStart.bytes ) / double( 1 << 20 ) << " MB)." << endl;
+        }
+        QDir dir( profileDir );
+        QString baseName = infoFile.completeBaseName();
+        profiler.writeJSON( dir.filePath( baseName + ".profile.json" ),
+                            infoFile.fileName().toLocal8Bit().constData() );
+        profiler.writeTrace( dir.filePath( baseName + ".trace.json" ) );
+    }
 
 
 //    std::cout << "Press RETURN to finish..." << std::endl;
@@ -257,7 +235,7 @@ void proceedFile( QString fileName )
 
     // Generate a PdfDocumentLayout
 //    cout << " >>> Generating a Pdf Document Layout..." << endl;
-//    splitPagesLayout( *document.getPoDoFoDocument(), docLayout );
+//    splitPagesLayout( document, docLayout );
 
 //    // Layout parameters.
 //    PRLayoutParameters params;
@@ -280,6 +258,44 @@ void proceedFile( QString fileName )
     //document.writePoDoFoDocument( filePath );
 }
 
+/** Batch mode: process documents concurrently.
+ * \param pathIn Directory of PDF files, or text file listing documents.
+ * \param args Options: --jobs N, --output dir, --summary file.
+ * \return Exit code (1 if some documents failed).
+ */
+int proceedBatch( QString pathIn, const QStringList& args )
+{
+    size_t nbJobs = 0;
+    QString outputDir;
+    QString summaryFilename( "./batch_summary.txt" );
+    for( int i = 0 ; i+1 < args.size() ; i += 2 ) {
+        if( args.at( i ) == "--jobs" ) {
+            nbJobs = args.at( i+1 ).toUInt();
+        }
+        else if( args.at( i ) == "--output" ) {
+            outputDir = args.at( i+1 );
+        }
+        else if( args.at( i ) == "--summary" ) {
+            summaryFilename = args.at( i+1 );
+        }
+    }
+    if( outputDir.isEmpty() ) {
+        QFileInfo infoPath( pathIn );
+        outputDir = ( infoPath.isDir() ? infoPath.absoluteFilePath() : QDir::currentPath() ) + "/recut";
+    }
+    QStringList filenames = PRBatchProcessor::inputFiles( pathIn );
+    PRBatchProcessor processor( outputDir, nbJobs );
+    processor.process( filenames );
+
+    cout << " >>> Batch: " << filenames.size() << " files, "
+         << processor.nbFailures() << " failed, "
+         << processor.wallTime() << " ms." << endl;
+    if( !processor.writeSummary( summaryFilename ) ) {
+        cerr << "Can not write batch summary: " << summaryFilename.toLocal8Bit().constData() << endl;
+    }
+    return processor.nbFailures() ? 1 : 0;
+}
+
 void proceedDir( QString dirPath )
 {
     QDir dirFiles (dirPath );
@@ -316,16 +332,58 @@ int main( int argc, char *argv[] )
 
     logger.addDestination( fileDestination.get() );
     logger.addDestination( debugDestination.get() );
+    // Messages written by a background thread (declared after destinations,
+    // so pending messages are written before they are destroyed).
+    QsLogging::AsyncLoggingScope asyncLogging;
 
     // Set Standard 14 fonts path.
     PoDoFoExtended::PdfeFont::Standard14FontsDir.setPath( "./standard14fonts" );
 
-    if( argc != 2 ) {
-        cout << "Input: file or directory to proceed..." << endl;
+    QStringList args = QCoreApplication::arguments();
+    // Batch mode: CPdfRecut --batch dir|list.txt [--jobs N] [--output dir] [--summary file]
+    if( args.size() >= 3 && args.at( 1 ) == "--batch" ) {
+        return proceedBatch( args.at( 2 ), args.mid( 3 ) );
+    }
+    // Service mode: JSON line jobs on stdin, or on a local socket.
+    if( args.size() >= 2 && args.at( 1 ) == "--serve" ) {
+        // Responses on stdout (log messages on file and stderr).
+        PRService service;
+        if( args.size() == 4 && args.at( 2 ) == "--socket" ) {
+            return service.runLocalSocket( args.at( 3 ) );
+        }
+        return service.runStandardIO();
+    }
+    // Options: pairs of arguments after the input path.
+    bool validArgs = ( args.size() >= 2 && args.size() % 2 == 0 );
+    for( int i = 2 ; validArgs && i+1 < args.size() ; i += 2 ) {
+        if( args.at( i ) == "--profile" ) {
+            profileDir = args.at( i+1 );
+        }
+        else if( args.at( i ) == "--cache" ) {
+            contentsCacheDir = args.at( i+1 );
+        }
+        else if( args.at( i ) == "--cache-size" ) {
+            contentsCacheSizeMB = args.at( i+1 ).toLongLong( &validArgs );
+            validArgs = validArgs && contentsCacheSizeMB > 0;
+        }
+        else {
+            validArgs = false;
+        }
+    }
+    if( !validArgs ) {
+        cout << "Input: file or directory to proceed... [--profile output directory]" << endl
+             << "       [--cache directory] [--cache-size MB (default: 256)]" << endl
+             << "       --batch dir|list.txt [--jobs N] [--output dir] [--summary file]" << endl
+             << "       --serve [--socket name]" << endl;
         return 0;
     }
+    // Profiling: JSON summary and Chrome trace for each document.
+    if( !profileDir.isEmpty() ) {
+        QDir().mkpath( profileDir );
+        PdfeProfiler::instance().setEnabled( true );
+    }
 
-    QString pathIn = QCoreApplication::arguments().at( 1 );
+    QString pathIn = args.at( 1 );
     if( QFileInfo( pathIn ).isDir() ) {
         proceedDir( pathIn );
     }
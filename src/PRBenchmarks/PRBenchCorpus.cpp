@@ -0,0 +1,400 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRBenchCorpus.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include <QDir>
+#include <podofo/podofo.h>
+
+using namespace PoDoFo;
+
+namespace PdfRecut {
+
+PRBenchCorpus::Parameters::Parameters() :
+    name( "default" ),
+    nbPages( 10 ),
+    nbTextOps( 200 ),
+    tjLength( 4 ),
+    nestingDepth( 1 ),
+    nbForms( 0 ),
+    formReuse( 0 ),
+    nbInlineImages( 0 ),
+    type0Font( false ),
+    type3Font( false ),
+    nbContentsParts( 1 ),
+    seed( 1 )
+{
+}
+
+unsigned int PRBenchCorpus::Random::next()
+{
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+    return m_state;
+}
+double PRBenchCorpus::Random::uniform( double a, double b )
+{
+    return a + ( b - a ) * ( this->next() / 4294967296.0 );
+}
+
+void PRBenchCorpus::generate( const Parameters& params, const QString& filename )
+{
+    Random random( params.seed );
+    PdfMemDocument document;
+
+    // Fonts and forms shared by pages.
+    PdfDictionary fonts;
+    PdfObject* pType1Font = createType1Font( &document );
+    fonts.AddKey( "F1", pType1Font->Reference() );
+    if( params.type0Font ) {
+        fonts.AddKey( "F2", createType0Font( &document )->Reference() );
+    }
+    if( params.type3Font ) {
+        fonts.AddKey( "F3", createType3Font( &document )->Reference() );
+    }
+    PdfDictionary forms;
+    for( size_t i = 0 ; i < params.nbForms ; ++i ) {
+        std::ostringstream name;
+        name << "Fm" << i;
+        forms.AddKey( name.str(), createForm( &document, pType1Font, random )->Reference() );
+    }
+
+    for( size_t i = 0 ; i < params.nbPages ; ++i ) {
+        PdfPage* ppage = document.CreatePage( PdfRect( 0.0, 0.0, 612.0, 792.0 ) );
+        PdfDictionary& resources = ppage->GetResources()->GetDictionary();
+        resources.AddKey( "Font", fonts );
+        if( params.nbForms ) {
+            resources.AddKey( "XObject", forms );
+        }
+        // Contents: operators split in several streams.
+        std::vector<std::string> operators = pageOperators( params, random );
+        size_t nbParts = std::max( params.nbContentsParts, size_t( 1 ) );
+        PdfArray contents;
+        for( size_t k = 0 ; k < nbParts ; ++k ) {
+            PdfObject* pStreamObj = document.GetObjects().CreateObject();
+            PdfStream* pstream = pStreamObj->GetStream();
+            pstream->BeginAppend();
+            size_t first = k * operators.size() / nbParts;
+            size_t last = ( k+1 ) * operators.size() / nbParts;
+            for( size_t j = first ; j < last ; ++j ) {
+                pstream->Append( operators[j].data(), operators[j].size() );
+            }
+            pstream->EndAppend();
+            contents.push_back( pStreamObj->Reference() );
+        }
+        ppage->GetObject()->GetDictionary().AddKey( "Contents", contents );
+    }
+    document.Write( filename.toLocal8Bit().data() );
+}
+QStringList PRBenchCorpus::generateCorpus( const QString& dirPath, unsigned int seed )
+{
+    QDir dir;
+    dir.mkpath( dirPath );
+    QStringList filenames;
+    std::vector<Parameters> corpus = corpusParameters( seed );
+    for( size_t i = 0 ; i < corpus.size() ; ++i ) {
+        QString filename = QDir( dirPath ).filePath( QString( "%1.pdf" )
+                                                     .arg( corpus[i].name.c_str() ) );
+        generate( corpus[i], filename );
+        filenames << filename;
+    }
+    return filenames;
+}
+std::vector<PRBenchCorpus::Parameters> PRBenchCorpus::corpusParameters( unsigned int seed )
+{
+    std::vector<Parameters> corpus;
+    Parameters params;
+    params.seed = seed;
+
+    params.name = "text";
+    params.nbTextOps = 500;
+    corpus.push_back( params );
+
+    params = Parameters();
+    params.seed = seed;
+    params.name = "tj-long";
+    params.nbTextOps = 50;
+    params.tjLength = 200;
+    corpus.push_back( params );
+
+    params = Parameters();
+    params.seed = seed;
+    params.name = "nesting";
+    params.nbTextOps = 100;
+    params.nestingDepth = 64;
+    corpus.push_back( params );
+
+    params = Parameters();
+    params.seed = seed;
+    params.name = "forms";
+    params.nbTextOps = 50;
+    params.nbForms = 8;
+    params.formReuse = 20;
+    corpus.push_back( params );
+
+    params = Parameters();
+    params.seed = seed;
+    params.name = "images";
+    params.nbTextOps = 50;
+    params.nbInlineImages = 100;
+    corpus.push_back( params );
+
+    params = Parameters();
+    params.seed = seed;
+    params.name = "fonts";
+    params.nbTextOps = 300;
+    params.type0Font = true;
+    params.type3Font = true;
+    corpus.push_back( params );
+
+    params = Parameters();
+    params.seed = seed;
+    params.name = "multipart";
+    params.nbTextOps = 300;
+    params.nbContentsParts = 8;
+    corpus.push_back( params );
+
+    return corpus;
+}
+
+PdfObject* PRBenchCorpus::createType1Font( PdfMemDocument* pdocument )
+{
+    PdfObject* pFont = pdocument->GetObjects().CreateObject( "Font" );
+    pFont->GetDictionary().AddKey( PdfName::KeySubtype, PdfName( "Type1" ) );
+    pFont->GetDictionary().AddKey( "BaseFont", PdfName( "Helvetica" ) );
+    pFont->GetDictionary().AddKey( "Encoding", PdfName( "WinAnsiEncoding" ) );
+    return pFont;
+}
+PdfObject* PRBenchCorpus::createType0Font( PdfMemDocument* pdocument )
+{
+    // Font descriptor (Helvetica metrics, not embedded).
+    PdfObject* pDescriptor = pdocument->GetObjects().CreateObject( "FontDescriptor" );
+    PdfDictionary& descriptor = pDescriptor->GetDictionary();
+    PdfArray bbox;
+    bbox.push_back( PdfVariant( pdf_int64( -166 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( -225 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( 1000 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( 931 ) ) );
+    descriptor.AddKey( "FontName", PdfName( "Helvetica" ) );
+    descriptor.AddKey( "Flags", PdfVariant( pdf_int64( 32 ) ) );
+    descriptor.AddKey( "FontBBox", bbox );
+    descriptor.AddKey( "ItalicAngle", PdfVariant( pdf_int64( 0 ) ) );
+    descriptor.AddKey( "Ascent", PdfVariant( pdf_int64( 718 ) ) );
+    descriptor.AddKey( "Descent", PdfVariant( pdf_int64( -207 ) ) );
+    descriptor.AddKey( "CapHeight", PdfVariant( pdf_int64( 718 ) ) );
+    descriptor.AddKey( "StemV", PdfVariant( pdf_int64( 88 ) ) );
+
+    // Descendant CID font.
+    PdfObject* pCIDFont = pdocument->GetObjects().CreateObject( "Font" );
+    PdfDictionary& cidFont = pCIDFont->GetDictionary();
+    PdfDictionary sysInfo;
+    sysInfo.AddKey( "Registry", PdfString( "Adobe" ) );
+    sysInfo.AddKey( "Ordering", PdfString( "Identity" ) );
+    sysInfo.AddKey( "Supplement", PdfVariant( pdf_int64( 0 ) ) );
+    cidFont.AddKey( PdfName::KeySubtype, PdfName( "CIDFontType2" ) );
+    cidFont.AddKey( "BaseFont", PdfName( "Helvetica" ) );
+    cidFont.AddKey( "CIDSystemInfo", sysInfo );
+    cidFont.AddKey( "DW", PdfVariant( pdf_int64( 556 ) ) );
+    cidFont.AddKey( "FontDescriptor", pDescriptor->Reference() );
+
+    PdfObject* pFont = pdocument->GetObjects().CreateObject( "Font" );
+    PdfArray descendants;
+    descendants.push_back( pCIDFont->Reference() );
+    pFont->GetDictionary().AddKey( PdfName::KeySubtype, PdfName( "Type0" ) );
+    pFont->GetDictionary().AddKey( "BaseFont", PdfName( "Helvetica" ) );
+    pFont->GetDictionary().AddKey( "Encoding", PdfName( "Identity-H" ) );
+    pFont->GetDictionary().AddKey( "DescendantFonts", descendants );
+    return pFont;
+}
+PdfObject* PRBenchCorpus::createType3Font( PdfMemDocument* pdocument )
+{
+    // Glyphs procedures: square (a) and triangle (b).
+    const char* procs[] = { "1000 0 d0\n100 100 800 800 re f\n",
+                            "1000 0 d0\n100 100 m 900 100 l 500 900 l h f\n" };
+    const char* names[] = { "square", "triangle" };
+    PdfDictionary charProcs;
+    PdfArray differences;
+    PdfArray widths;
+    differences.push_back( PdfVariant( pdf_int64( 'a' ) ) );
+    for( size_t i = 0 ; i < 2 ; ++i ) {
+        PdfObject* pProc = pdocument->GetObjects().CreateObject();
+        pProc->GetStream()->BeginAppend();
+        pProc->GetStream()->Append( procs[i] );
+        pProc->GetStream()->EndAppend();
+        charProcs.AddKey( names[i], pProc->Reference() );
+        differences.push_back( PdfName( names[i] ) );
+        widths.push_back( PdfVariant( pdf_int64( 1000 ) ) );
+    }
+    PdfDictionary encoding;
+    encoding.AddKey( PdfName::KeyType, PdfName( "Encoding" ) );
+    encoding.AddKey( "Differences", differences );
+
+    PdfArray bbox;
+    bbox.push_back( PdfVariant( pdf_int64( 0 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( 0 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( 1000 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( 1000 ) ) );
+    PdfArray matrix;
+    matrix.push_back( PdfVariant( 0.001 ) );
+    matrix.push_back( PdfVariant( pdf_int64( 0 ) ) );
+    matrix.push_back( PdfVariant( pdf_int64( 0 ) ) );
+    matrix.push_back( PdfVariant( 0.001 ) );
+    matrix.push_back( PdfVariant( pdf_int64( 0 ) ) );
+    matrix.push_back( PdfVariant( pdf_int64( 0 ) ) );
+
+    PdfObject* pFont = pdocument->GetObjects().CreateObject( "Font" );
+    PdfDictionary& font = pFont->GetDictionary();
+    font.AddKey( PdfName::KeySubtype, PdfName( "Type3" ) );
+    font.AddKey( "FontBBox", bbox );
+    font.AddKey( "FontMatrix", matrix );
+    font.AddKey( "CharProcs", charProcs );
+    font.AddKey( "Encoding", encoding );
+    font.AddKey( "FirstChar", PdfVariant( pdf_int64( 'a' ) ) );
+    font.AddKey( "LastChar", PdfVariant( pdf_int64( 'b' ) ) );
+    font.AddKey( "Widths", widths );
+    font.AddKey( "Resources", PdfDictionary() );
+    return pFont;
+}
+PdfObject* PRBenchCorpus::createForm( PdfMemDocument* pdocument,
+                                      PdfObject* pfont,
+                                      Random& random )
+{
+    std::ostringstream contents;
+    contents << std::fixed << std::setprecision( 2 );
+    for( size_t i = 0 ; i < 5 ; ++i ) {
+        contents << random.uniform( 0.0, 150.0 ) << " " << random.uniform( 0.0, 150.0 ) << " "
+                 << random.uniform( 10.0, 50.0 ) << " " << random.uniform( 10.0, 50.0 ) << " re\n"
+                 << ( i % 2 ? "f\n" : "S\n" );
+    }
+    contents << "BT\n/F1 8 Tf\n10 10 Td\n(Form) Tj\nET\n";
+    std::string data = contents.str();
+
+    PdfObject* pForm = pdocument->GetObjects().CreateObject( "XObject" );
+    PdfDictionary& form = pForm->GetDictionary();
+    PdfArray bbox;
+    bbox.push_back( PdfVariant( pdf_int64( 0 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( 0 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( 200 ) ) );
+    bbox.push_back( PdfVariant( pdf_int64( 200 ) ) );
+    PdfDictionary fonts;
+    fonts.AddKey( "F1", pfont->Reference() );
+    PdfDictionary resources;
+    resources.AddKey( "Font", fonts );
+    form.AddKey( PdfName::KeySubtype, PdfName( "Form" ) );
+    form.AddKey( "BBox", bbox );
+    form.AddKey( "Resources", resources );
+
+    pForm->GetStream()->BeginAppend();
+    pForm->GetStream()->Append( data.data(), data.size() );
+    pForm->GetStream()->EndAppend();
+    return pForm;
+}
+
+std::vector<std::string> PRBenchCorpus::pageOperators( const Parameters& params,
+                                                        Random& random )
+{
+    std::vector<std::string> operators;
+    std::ostringstream op;
+    op << std::fixed << std::setprecision( 2 );
+
+    // Nesting of graphics states.
+    for( size_t i = 0 ; i < params.nestingDepth ; ++i ) {
+        operators.push_back( "q\n" );
+        operators.push_back( "1 0 0 1 0.1 0.1 cm\n" );
+    }
+    // Forms XObjects.
+    for( size_t i = 0 ; i < params.nbForms ; ++i ) {
+        for( size_t j = 0 ; j < params.formReuse ; ++j ) {
+            op.str( "" );
+            op << "0.5 0 0 0.5 " << random.uniform( 0.0, 500.0 ) << " "
+               << random.uniform( 0.0, 700.0 ) << " cm\n";
+            operators.push_back( "q\n" );
+            operators.push_back( op.str() );
+            op.str( "" );
+            op << "/Fm" << i << " Do\n";
+            operators.push_back( op.str() );
+            operators.push_back( "Q\n" );
+        }
+    }
+    // Text objects, with fonts in turn.
+    std::vector<int> fonts( 1, 1 );
+    if( params.type0Font ) {
+        fonts.push_back( 2 );
+    }
+    if( params.type3Font ) {
+        fonts.push_back( 3 );
+    }
+    for( size_t i = 0 ; i < params.nbTextOps ; ++i ) {
+        int font = fonts[ i % fonts.size() ];
+        operators.push_back( "BT\n" );
+        op.str( "" );
+        op << "/F" << font << " 10 Tf\n";
+        operators.push_back( op.str() );
+        op.str( "" );
+        op << random.uniform( 20.0, 500.0 ) << " " << random.uniform( 20.0, 770.0 ) << " Td\n";
+        operators.push_back( op.str() );
+
+        op.str( "" );
+        op << "[";
+        for( size_t j = 0 ; j < params.tjLength ; ++j ) {
+            size_t length = 1 + random.uniform( 8 );
+            if( font == 2 ) {
+                // Identity-H: two-byte codes.
+                op << "<";
+                for( size_t k = 0 ; k < length ; ++k ) {
+                    op << std::hex << std::setw( 4 ) << std::setfill( '0' )
+                       << ( 0x41 + random.uniform( 26 ) ) << std::dec << std::setfill( ' ' );
+                }
+                op << ">";
+            }
+            else {
+                op << "(";
+                for( size_t k = 0 ; k < length ; ++k ) {
+                    op << char( font == 3 ? 'a' + random.uniform( 2 ) : 'a' + random.uniform( 26 ) );
+                }
+                op << ")";
+            }
+            if( j+1 < params.tjLength ) {
+                op << " " << -int( random.uniform( 300 ) ) << " ";
+            }
+        }
+        op << "] TJ\n";
+        operators.push_back( op.str() );
+        operators.push_back( "ET\n" );
+    }
+    // Inline images: 4x4 gray, binary data.
+    for( size_t i = 0 ; i < params.nbInlineImages ; ++i ) {
+        op.str( "" );
+        op << "20 0 0 20 " << random.uniform( 0.0, 590.0 ) << " "
+           << random.uniform( 0.0, 770.0 ) << " cm\n";
+        operators.push_back( "q\n" );
+        operators.push_back( op.str() );
+        std::string image( "BI /W 4 /H 4 /BPC 8 /CS /G ID " );
+        for( size_t k = 0 ; k < 16 ; ++k ) {
+            // High bytes only: no accidental EI delimiter.
+            image.push_back( char( 0x80 + random.uniform( 128 ) ) );
+        }
+        image += "\nEI\n";
+        operators.push_back( image );
+        operators.push_back( "Q\n" );
+    }
+    for( size_t i = 0 ; i < params.nestingDepth ; ++i ) {
+        operators.push_back( "Q\n" );
+    }
+    return operators;
+}
+
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRBENCHCORPUS_H
+#define PRBENCHCORPUS_H
+
+#include <string>
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+
+namespace PoDoFo {
+class PdfMemDocument;
+class PdfObject;
+}
+
+namespace PdfRecut {
+
+//************************************************************//
+//                        PRBenchCorpus                       //
+//************************************************************//
+/** Generator of synthetic PDF documents with controlled characteristics
+ * (text operators, TJ arrays, q/Q nesting, forms, inline images, fonts,
+ * multi-part contents), used as reproducible benchmark inputs.
+ * Generation is deterministic: same parameters and seed, same file.
+ */
+class PRBenchCorpus
+{
+public:
+    /** Characteristics of a generated document.
+     */
+    struct Parameters
+    {
+        /// Name of the document (file basename).
+        std::string  name;
+        /// Number of pages.
+        size_t  nbPages;
+        /// Number of text objects (BT/TJ/ET) per page.
+        size_t  nbTextOps;
+        /// Number of strings in TJ arrays.
+        size_t  tjLength;
+        /// Depth of q/Q nesting around page contents.
+        size_t  nestingDepth;
+        /// Number of form XObjects (shared by pages).
+        size_t  nbForms;
+        /// Number of times each form is drawn on a page.
+        size_t  formReuse;
+        /// Number of inline images per page.
+        size_t  nbInlineImages;
+        /// Use a Type0 font (Identity-H) for part of the text.
+        bool  type0Font;
+        /// Use a Type3 font for part of the text.
+        bool  type3Font;
+        /// Number of streams in the /Contents array of pages.
+        size_t  nbContentsParts;
+        /// Seed of the pseudo-random generator.
+        unsigned int  seed;
+
+        /// Default: 10 pages with 200 short text objects.
+        Parameters();
+    };
+
+public:
+    /** Generate a document.
+     * \param params Characteristics of the document.
+     * \param filename Path of the output PDF file.
+     */
+    static void generate( const Parameters& params, const QString& filename );
+    /** Generate the standard corpus (one document per characteristic).
+     * \param dirPath Output directory (created if necessary).
+     * \param seed Seed of the pseudo-random generator.
+     * \return Paths of the generated files.
+     */
+    static QStringList generateCorpus( const QString& dirPath, unsigned int seed );
+    /** Parameters of the standard corpus.
+     * \param seed Seed of the pseudo-random generator.
+     */
+    static std::vector<Parameters> corpusParameters( unsigned int seed );
+
+private:
+    /** Deterministic pseudo-random generator (xorshift32),
+     * independent of the platform rand().
+     */
+    class Random
+    {
+    public:
+        explicit Random( unsigned int seed ) : m_state( seed ? seed : 0x9E3779B9u ) { }
+        /// Next value.
+        unsigned int next();
+        /// Value in [0, n).
+        unsigned int uniform( unsigned int n )  {   return n ? this->next() % n : 0;    }
+        /// Value in [a, b).
+        double uniform( double a, double b );
+    private:
+        unsigned int  m_state;
+    };
+
+    /// Create a Type1 standard font (Helvetica).
+    static PoDoFo::PdfObject* createType1Font( PoDoFo::PdfMemDocument* pdocument );
+    /// Create a Type0 font (Identity-H) based on Helvetica.
+    static PoDoFo::PdfObject* createType0Font( PoDoFo::PdfMemDocument* pdocument );
+    /// Create a Type3 font with two glyphs (square and triangle).
+    static PoDoFo::PdfObject* createType3Font( PoDoFo::PdfMemDocument* pdocument );
+    /// Create a form XObject drawing a few paths and a text.
+    static PoDoFo::PdfObject* createForm( PoDoFo::PdfMemDocument* pdocument,
+                                          PoDoFo::PdfObject* pfont,
+                                          Random& random );
+    /** Generate the operators of a page.
+     * \return Vector of operators (each one a complete, newline-terminated line).
+     */
+    static std::vector<std::string> pageOperators( const Parameters& params,
+                                                   Random& random );
+};
+
+}
+
+#endif // PRBENCHCORPUS_H
@@ -0,0 +1,295 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include <QElapsedTimer>
+
+#include "PdfeProfiler.h"
+
+namespace PdfRecut {
+
+PRAllocCounters PRAllocCounters::current()
+{
+    PRAllocCounters counters;
+    PoDoFoExtended::PdfeProfiler::Allocations allocs =
+            PoDoFoExtended::PdfeProfiler::threadAllocations();
+    counters.nbAllocations = allocs.count;
+    counters.nbBytes = allocs.bytes;
+    return counters;
+}
+
+//************************************************************//
+//                         PRBenchmark                        //
+//************************************************************//
+namespace {
+/** Median of sorted times and its 95% confidence interval, from
+ * order statistics (no assumption on the times distribution).
+ */
+void medianInterval( const std::vector<double>& times,
+                     double& median, double& ciLow, double& ciHigh )
+{
+    size_t n = times.size();
+    median = ( n % 2 ) ? times[n/2] : ( times[n/2-1] + times[n/2] ) / 2;
+    double delta = 1.96 * std::sqrt( double( n ) ) / 2;
+    int low = int( std::floor( n / 2.0 - delta ) );
+    int high = int( std::ceil( n / 2.0 + delta ) );
+    ciLow = times[ std::max( low, 0 ) ];
+    ciHigh = times[ std::min( high, int( n ) - 1 ) ];
+}
+}
+
+double PRBenchmark::Result::opsPerSecond() const
+{
+    return minTime > 0.0 ? work.nbOps / minTime : 0.0;
+}
+double PRBenchmark::Result::bytesPerSecond() const
+{
+    return minTime > 0.0 ? work.nbBytes / minTime : 0.0;
+}
+
+PRBenchmark::PRBenchmark( const std::string& name ) :
+    m_name( name )
+{
+}
+PRBenchmark::~PRBenchmark()
+{
+}
+
+PRBenchmark::Result PRBenchmark::execute( size_t nbIterations, size_t nbWarmup )
+{
+    Result result;
+    result.name = m_name;
+    result.nbIterations = std::max( nbIterations, size_t( 1 ) );
+    result.minTime = std::numeric_limits<double>::max();
+
+    // Warmup: caches, lazy initialisations,...
+    for( size_t i = 0 ; i < nbWarmup ; ++i ) {
+        this->setUp();
+        this->run();
+        this->tearDown();
+    }
+    QElapsedTimer timer;
+    double totalTime = 0.0;
+    std::vector<double> times;
+    PRAllocCounters allocs;
+    for( size_t i = 0 ; i < result.nbIterations ; ++i ) {
+        this->setUp();
+        PRAllocCounters allocsStart = PRAllocCounters::current();
+        timer.start();
+        result.work = this->run();
+        double time = timer.nsecsElapsed() * 1e-9;
+        PRAllocCounters allocsEnd = PRAllocCounters::current();
+        this->tearDown();
+
+        totalTime += time;
+        times.push_back( time );
+        result.minTime = std::min( result.minTime, time );
+        allocs.nbAllocations += allocsEnd.nbAllocations - allocsStart.nbAllocations;
+        allocs.nbBytes += allocsEnd.nbBytes - allocsStart.nbBytes;
+    }
+    result.meanTime = totalTime / result.nbIterations;
+    std::sort( times.begin(), times.end() );
+    medianInterval( times, result.medianTime, result.ciLowTime, result.ciHighTime );
+    result.allocs.nbAllocations = allocs.nbAllocations / result.nbIterations;
+    result.allocs.nbBytes = allocs.nbBytes / result.nbIterations;
+    return result;
+}
+
+//************************************************************//
+//                      PRBenchmarkReport                     //
+//************************************************************//
+void PRBenchmarkReport::add( const PRBenchmark::Result& result )
+{
+    m_results.push_back( result );
+}
+void PRBenchmarkReport::writeText( std::ostream& out ) const
+{
+    out << std::left << std::setw( 40 ) << "Benchmark"
+        << std::right << std::setw( 12 ) << "min (ms)"
+        << std::setw( 12 ) << "mean (ms)"
+        << std::setw( 12 ) << "median (ms)"
+        << std::setw( 14 ) << "ops/s"
+        << std::setw( 14 ) << "MB/s"
+        << std::setw( 12 ) << "allocs"
+        << std::setw( 12 ) << "alloc MB" << std::endl;
+    out << std::fixed << std::setprecision( 2 );
+    for( size_t i = 0 ; i < m_results.size() ; ++i ) {
+        const PRBenchmark::Result& result = m_results[i];
+        out << std::left << std::setw( 40 ) << result.name
+            << std::right << std::setw( 12 ) << result.minTime * 1e3
+            << std::setw( 12 ) << result.meanTime * 1e3
+            << std::setw( 12 ) << result.medianTime * 1e3
+            << std::setw( 14 ) << result.opsPerSecond()
+            << std::setw( 14 ) << result.bytesPerSecond() / ( 1 << 20 )
+            << std::setw( 12 ) << result.allocs.nbAllocations
+            << std::setw( 12 ) << double( result.allocs.nbBytes ) / ( 1 << 20 ) << std::endl;
+    }
+}
+void PRBenchmarkReport::writeJSON( std::ostream& out, const std::string& input ) const
+{
+    // Names and paths: only escape quotes and backslashes.
+    std::string inputEsc;
+    for( size_t i = 0 ; i < input.size() ; ++i ) {
+        if( input[i] == '"' || input[i] == '\\' ) {
+            inputEsc.push_back( '\\' );
+        }
+        inputEsc.push_back( input[i] );
+    }
+    out << std::setprecision( 9 );
+    out << "{\n  \"input\": \"" << inputEsc << "\",\n  \"benchmarks\": [\n";
+    for( size_t i = 0 ; i < m_results.size() ; ++i ) {
+        const PRBenchmark::Result& result = m_results[i];
+        out << "    { \"name\": \"" << result.name << "\""
+            << ", \"iterations\": " << result.nbIterations
+            << ", \"min_s\": " << result.minTime
+            << ", \"mean_s\": " << result.meanTime
+            << ", \"median_s\": " << result.medianTime
+            << ", \"ci_low_s\": " << result.ciLowTime
+            << ", \"ci_high_s\": " << result.ciHighTime
+            << ", \"ops\": " << result.work.nbOps
+            << ", \"bytes\": " << result.work.nbBytes
+            << ", \"ops_per_s\": " << result.opsPerSecond()
+            << ", \"bytes_per_s\": " << result.bytesPerSecond()
+            << ", \"allocations\": " << result.allocs.nbAllocations
+            << ", \"bytes_allocated\": " << result.allocs.nbBytes
+            << " }" << ( i + 1 < m_results.size() ? "," : "" ) << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+//************************************************************//
+//                     PRBenchmarkBaseline                    //
+//************************************************************//
+namespace {
+/// Position of the value of a JSON key in a line (npos if not found).
+size_t jsonValuePos( const std::string& line, const char* key )
+{
+    std::string pattern = std::string( "\"" ) + key + "\":";
+    size_t pos = line.find( pattern );
+    if( pos == std::string::npos ) {
+        return pos;
+    }
+    pos = line.find_first_not_of( ' ', pos + pattern.size() );
+    return pos;
+}
+/// String value of a JSON key (no escape sequences in names).
+bool jsonString( const std::string& line, const char* key, std::string& value )
+{
+    size_t pos = jsonValuePos( line, key );
+    if( pos == std::string::npos || line[pos] != '"' ) {
+        return false;
+    }
+    size_t end = line.find( '"', pos+1 );
+    if( end == std::string::npos ) {
+        return false;
+    }
+    value = line.substr( pos+1, end-pos-1 );
+    return true;
+}
+/// Numeric value of a JSON key.
+bool jsonNumber( const std::string& line, const char* key, double& value )
+{
+    size_t pos = jsonValuePos( line, key );
+    if( pos == std::string::npos ) {
+        return false;
+    }
+    const char* pstart = line.c_str() + pos;
+    char* pend;
+    value = std::strtod( pstart, &pend );
+    return pend != pstart;
+}
+}
+
+bool PRBenchmarkBaseline::load( const QString& filename )
+{
+    // PRBenchmarkReport::writeJSON format: one benchmark per line.
+    m_entries.clear();
+    std::ifstream ifile( filename.toLocal8Bit().constData() );
+    std::string line;
+    while( std::getline( ifile, line ) ) {
+        Entry entry;
+        if( !jsonString( line, "name", entry.name ) ) {
+            continue;
+        }
+        // Older reports: minimum time only.
+        if( !jsonNumber( line, "median_s", entry.medianTime ) ) {
+            if( !jsonNumber( line, "min_s", entry.medianTime ) ) {
+                continue;
+            }
+            entry.ciLowTime = entry.ciHighTime = entry.medianTime;
+        }
+        else {
+            jsonNumber( line, "ci_low_s", entry.ciLowTime );
+            jsonNumber( line, "ci_high_s", entry.ciHighTime );
+        }
+        m_entries.push_back( entry );
+    }
+    return !m_entries.empty();
+}
+const PRBenchmarkBaseline::Entry* PRBenchmarkBaseline::entry( const std::string& name ) const
+{
+    for( size_t i = 0 ; i < m_entries.size() ; ++i ) {
+        if( m_entries[i].name == name ) {
+            return &m_entries[i];
+        }
+    }
+    return NULL;
+}
+size_t PRBenchmarkBaseline::compare( const PRBenchmarkReport& report,
+                                     double threshold,
+                                     std::ostream& out ) const
+{
+    size_t nbRegressions = 0;
+    out << std::left << std::setw( 40 ) << "Benchmark"
+        << std::right << std::setw( 14 ) << "base (ms)"
+        << std::setw( 14 ) << "median (ms)"
+        << std::setw( 10 ) << "ratio"
+        << "  status" << std::endl;
+    out << std::fixed << std::setprecision( 2 );
+
+    const std::vector<PRBenchmark::Result>& results = report.results();
+    for( size_t i = 0 ; i < results.size() ; ++i ) {
+        const PRBenchmark::Result& result = results[i];
+        const Entry* pentry = this->entry( result.name );
+        out << std::left << std::setw( 40 ) << result.name << std::right;
+        if( !pentry || pentry->medianTime <= 0.0 ) {
+            out << std::setw( 14 ) << "-"
+                << std::setw( 14 ) << result.medianTime * 1e3
+                << std::setw( 10 ) << "-" << "  new" << std::endl;
+            continue;
+        }
+        // Significant: slower than threshold and intervals not overlapping.
+        double ratio = result.medianTime / pentry->medianTime;
+        const char* status = "ok";
+        if( ratio > 1.0 + threshold && result.ciLowTime > pentry->ciHighTime ) {
+            status = "REGRESSION";
+            ++nbRegressions;
+        }
+        else if( ratio < 1.0 - threshold && result.ciHighTime < pentry->ciLowTime ) {
+            status = "improved";
+        }
+        out << std::setw( 14 ) << pentry->medianTime * 1e3
+            << std::setw( 14 ) << result.medianTime * 1e3
+            << std::setw( 10 ) << ratio
+            << "  " << status << std::endl;
+    }
+    return nbRegressions;
+}
+
+}
@@ -0,0 +1,206 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRBENCHMARK_H
+#define PRBENCHMARK_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+namespace PdfRecut {
+
+//************************************************************//
+//                      PRAllocCounters                       //
+//************************************************************//
+/** Counters of heap allocations of the calling thread, updated by the
+ * global operators new/delete of PdfeProfiler. Only counted in allocation
+ * profiling builds (qmake CONFIG+=alloc_profiling), zero otherwise.
+ */
+struct PRAllocCounters
+{
+    /// Number of allocations.
+    size_t  nbAllocations;
+    /// Number of bytes allocated.
+    size_t  nbBytes;
+
+    PRAllocCounters() : nbAllocations( 0 ), nbBytes( 0 ) { }
+    /// Current counters of the process.
+    static PRAllocCounters current();
+};
+
+//************************************************************//
+//                         PRBenchmark                        //
+//************************************************************//
+/** Base class of benchmarks. An iteration is prepared by setUp()
+ * (not timed), executed by run() (timed, allocations counted) and
+ * cleaned by tearDown() (not timed).
+ */
+class PRBenchmark
+{
+public:
+    /** Work done by an iteration.
+     */
+    struct Work
+    {
+        /// Number of operations (pages, tokens,...).
+        size_t  nbOps;
+        /// Number of bytes processed.
+        size_t  nbBytes;
+
+        Work( size_t ops = 0, size_t bytes = 0 ) : nbOps( ops ), nbBytes( bytes ) { }
+    };
+    /** Result of a benchmark.
+     */
+    struct Result
+    {
+        /// Name of the benchmark.
+        std::string  name;
+        /// Number of timed iterations.
+        size_t  nbIterations;
+        /// Minimum time of an iteration, in seconds.
+        double  minTime;
+        /// Mean time of an iteration, in seconds.
+        double  meanTime;
+        /// Median time of an iteration, in seconds.
+        double  medianTime;
+        /// 95% confidence interval of the median time (order statistics).
+        double  ciLowTime;
+        double  ciHighTime;
+        /// Work done by an iteration.
+        Work  work;
+        /// Allocations by iteration (mean).
+        PRAllocCounters  allocs;
+
+        Result() : nbIterations( 0 ), minTime( 0.0 ), meanTime( 0.0 ),
+            medianTime( 0.0 ), ciLowTime( 0.0 ), ciHighTime( 0.0 ) { }
+        /// Operations per second (minimum time).
+        double opsPerSecond() const;
+        /// Bytes per second (minimum time).
+        double bytesPerSecond() const;
+    };
+
+public:
+    /** Create a benchmark.
+     * \param name Name of the benchmark (category.name).
+     */
+    explicit PRBenchmark( const std::string& name );
+    virtual ~PRBenchmark();
+
+    /** Execute the benchmark.
+     * \param nbIterations Number of timed iterations.
+     * \param nbWarmup Number of warmup iterations (not reported).
+     * \return Result of the benchmark.
+     */
+    Result execute( size_t nbIterations, size_t nbWarmup );
+
+    /// Name of the benchmark.
+    const std::string& name() const     {   return m_name;      }
+
+protected:
+    /// Prepare an iteration (not timed).
+    virtual void setUp()        { }
+    /// Run an iteration (timed). Return the work done.
+    virtual Work run() = 0;
+    /// Clean an iteration (not timed).
+    virtual void tearDown()     { }
+
+private:
+    /// Name of the benchmark.
+    std::string  m_name;
+};
+
+//************************************************************//
+//                      PRBenchmarkReport                     //
+//************************************************************//
+/** Report of benchmark results: human-readable table and
+ * machine-readable JSON (for regression tracking).
+ */
+class PRBenchmarkReport
+{
+public:
+    /** Add a result to the report.
+     */
+    void add( const PRBenchmark::Result& result );
+    /** Write a human-readable table.
+     * \param out Output stream.
+     */
+    void writeText( std::ostream& out ) const;
+    /** Write the results in JSON.
+     * \param out Output stream.
+     * \param input Input file used by the benchmarks.
+     */
+    void writeJSON( std::ostream& out, const std::string& input ) const;
+
+    /// Results.
+    const std::vector<PRBenchmark::Result>& results() const    {   return m_results;   }
+
+private:
+    /// Results.
+    std::vector<PRBenchmark::Result>  m_results;
+};
+
+//************************************************************//
+//                     PRBenchmarkBaseline                    //
+//************************************************************//
+/** Baseline of benchmark results (JSON report written by
+ * PRBenchmarkReport::writeJSON), used as a regression gate.
+ * A benchmark regresses if its median time is slower than the baseline
+ * median by more than a threshold, and the confidence intervals of the
+ * two medians do not overlap (noise).
+ */
+class PRBenchmarkBaseline
+{
+public:
+    /** Baseline entry of a benchmark.
+     */
+    struct Entry
+    {
+        /// Name of the benchmark.
+        std::string  name;
+        /// Median time, in seconds.
+        double  medianTime;
+        /// Confidence interval of the median time.
+        double  ciLowTime;
+        double  ciHighTime;
+
+        Entry() : medianTime( 0.0 ), ciLowTime( 0.0 ), ciHighTime( 0.0 ) { }
+    };
+
+public:
+    /** Load a baseline from a JSON report.
+     * \param filename Path of the report.
+     * \return False if the file can not be read or has no benchmark.
+     */
+    bool load( const QString& filename );
+    /// Entry of a benchmark (NULL if not in the baseline).
+    const Entry* entry( const std::string& name ) const;
+
+    /** Compare a report to the baseline and write a summary.
+     * \param report Current results.
+     * \param threshold Relative slowdown tolerated (e.g. 0.1 for 10%).
+     * \param out Output stream of the summary.
+     * \return Number of regressions.
+     */
+    size_t compare( const PRBenchmarkReport& report,
+                    double threshold,
+                    std::ostream& out ) const;
+
+private:
+    /// Entries.
+    std::vector<Entry>  m_entries;
+};
+
+}
+
+#endif // PRBENCHMARK_H
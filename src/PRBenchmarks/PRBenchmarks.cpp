@@ -0,0 +1,253 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRBenchmarks.h"
+
+#include "PRException.h"
+#include "PRRenderPage.h"
+#include "PRGeometry/PRGTextPage.h"
+
+#include "PdfeStreamTokenizer.h"
+#include "PdfeContentsAnalysis.h"
+
+#include <algorithm>
+
+#include <podofo/podofo.h>
+
+#include <QDir>
+#include <QFileInfo>
+
+using namespace PoDoFo;
+using namespace PoDoFoExtended;
+
+namespace PdfRecut {
+
+namespace {
+/** Analysis with default callbacks: cost of the generic analysis.
+ */
+class PRBenchAnalysis : public PdfeContentsAnalysis
+{
+public:
+    void analyse( const PdfeContentsStream& stream ) {
+        this->analyseContents( stream );
+    }
+};
+}
+
+//************************************************************//
+//                       PRBenchDocument                      //
+//************************************************************//
+PRBenchDocument::PRBenchDocument( const std::string& name,
+                                  const QString& filename,
+                                  size_t nbPages ) :
+    PRBenchmark( name ),
+    m_filename( filename ),
+    m_nbPages( 0 ),
+    m_nbBytes( 0 )
+{
+    m_document.load( m_filename );
+    m_nbPages = std::min( nbPages, m_document.nbPages() );
+}
+void PRBenchDocument::loadStreams()
+{
+    m_streams.resize( m_nbPages );
+    m_nbBytes = 0;
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        m_streams[i].load( this->podofoPage( i ), true, true );
+        m_nbBytes += m_streams[i].dataSize();
+    }
+}
+PdfPage* PRBenchDocument::podofoPage( size_t idx )
+{
+    return m_document.pagesIndex()->page( idx );
+}
+
+//************************************************************//
+//                         Benchmarks                         //
+//************************************************************//
+PRBenchTokenizer::PRBenchTokenizer( const QString& filename, size_t nbPages ) :
+    PRBenchDocument( "parsing.tokenizer", filename, nbPages )
+{
+    this->loadStreams();
+}
+PRBenchmark::Work PRBenchTokenizer::run()
+{
+    size_t nbTokens = 0;
+    const char* pToken;
+    EPdfTokenType tokenType;
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        PdfeStreamTokenizer tokenizer( this->podofoPage( i ) );
+        while( tokenizer.GetNextToken( pToken, &tokenType ) ) {
+            ++nbTokens;
+        }
+    }
+    return Work( nbTokens, m_nbBytes );
+}
+
+PRBenchContentsLoad::PRBenchContentsLoad( const QString& filename, size_t nbPages ) :
+    PRBenchDocument( "contents.load", filename, nbPages )
+{
+    this->loadStreams();
+}
+PRBenchmark::Work PRBenchContentsLoad::run()
+{
+    size_t nbNodes = 0;
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        PdfeContentsStream stream;
+        stream.load( this->podofoPage( i ), true, true );
+        nbNodes += stream.nbNodes();
+    }
+    return Work( nbNodes, m_nbBytes );
+}
+
+PRBenchContentsCopy::PRBenchContentsCopy( const QString& filename, size_t nbPages ) :
+    PRBenchDocument( "contents.copy", filename, nbPages )
+{
+    this->loadStreams();
+}
+PRBenchmark::Work PRBenchContentsCopy::run()
+{
+    size_t nbNodes = 0;
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        PdfeContentsStream stream( m_streams[i] );
+        nbNodes += stream.nbNodes();
+    }
+    return Work( nbNodes, m_nbBytes );
+}
+
+PRBenchContentsSave::PRBenchContentsSave( const QString& filename, size_t nbPages ) :
+    PRBenchDocument( "contents.save", filename, nbPages )
+{
+    this->loadStreams();
+}
+PRBenchmark::Work PRBenchContentsSave::run()
+{
+    size_t nbNodes = 0;
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        m_streams[i].save( this->podofoPage( i ) );
+        nbNodes += m_streams[i].nbNodes();
+    }
+    return Work( nbNodes, m_nbBytes );
+}
+
+PRBenchContentsAnalysis::PRBenchContentsAnalysis( const QString& filename, size_t nbPages ) :
+    PRBenchDocument( "analysis.contents", filename, nbPages )
+{
+    this->loadStreams();
+}
+PRBenchmark::Work PRBenchContentsAnalysis::run()
+{
+    size_t nbNodes = 0;
+    PRBenchAnalysis analysis;
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        analysis.analyse( m_streams[i] );
+        nbNodes += m_streams[i].nbNodes();
+    }
+    return Work( nbNodes, m_nbBytes );
+}
+
+PRBenchDetectLines::PRBenchDetectLines( const QString& filename, size_t nbPages ) :
+    PRBenchDocument( "analysis.detectLines", filename, nbPages ),
+    m_pGDocument( NULL )
+{
+    m_pGDocument = new PRGDocument( &m_document );
+}
+PRBenchDetectLines::~PRBenchDetectLines()
+{
+    delete m_pGDocument;
+}
+void PRBenchDetectLines::setUp()
+{
+    // Fresh text data: detectLines modifies it.
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        m_pGDocument->page( i )->clearData();
+        m_pGDocument->page( i )->loadData();
+    }
+}
+PRBenchmark::Work PRBenchDetectLines::run()
+{
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        m_pGDocument->page( i )->text()->detectLines();
+    }
+    return Work( m_nbPages, 0 );
+}
+
+PRBenchTransform::PRBenchTransform( const QString& filename, size_t nbPages ) :
+    PRBenchDocument( "layout.transform", filename, nbPages )
+{
+}
+PRBenchTransform::PRBenchTransform( const std::string& name,
+                                    const QString& filename,
+                                    size_t nbPages ) :
+    PRBenchDocument( name, filename, nbPages )
+{
+}
+void PRBenchTransform::setUp()
+{
+    // Original document and layout: two zones per page.
+    m_document.load( m_filename );
+    m_layout.initSplitPages( &m_document, 20.0, m_nbPages );
+}
+PRBenchmark::Work PRBenchTransform::run()
+{
+    m_layout.applyToDocument( &m_document );
+    return Work( m_nbPages, 0 );
+}
+
+PRBenchSaveIncremental::PRBenchSaveIncremental( const QString& filename, size_t nbPages ) :
+    PRBenchTransform( "layout.saveIncremental", filename, nbPages ),
+    m_outFilename( QDir::temp().filePath( "PRBenchSaveIncremental.pdf" ) )
+{
+}
+PRBenchSaveIncremental::~PRBenchSaveIncremental()
+{
+    QFile::remove( m_outFilename );
+}
+void PRBenchSaveIncremental::setUp()
+{
+    PRBenchTransform::setUp();
+    m_layout.applyToDocument( &m_document );
+}
+PRBenchmark::Work PRBenchSaveIncremental::run()
+{
+    m_document.save( m_outFilename, PRDocumentSaveMode::Incremental );
+    return Work( m_document.nbPages(), size_t( QFileInfo( m_outFilename ).size() ) );
+}
+void PRBenchSaveIncremental::tearDown()
+{
+    // Round-trip: the file written must contain the transformed pages.
+    PRDocument document;
+    document.load( m_outFilename );
+    if( document.nbPages() != m_document.nbPages() ) {
+        throw PRException( PRExceptionCode::PRUnknown,
+                           QString( "Round-trip check failed: %1 pages saved, %2 pages read." )
+                           .arg( m_document.nbPages() ).arg( document.nbPages() ) );
+    }
+}
+
+PRBenchRender::PRBenchRender( const QString& filename, size_t nbPages ) :
+    PRBenchDocument( "render.elements", filename, nbPages )
+{
+    this->loadStreams();
+}
+PRBenchmark::Work PRBenchRender::run()
+{
+    PRRenderPage::Parameters params;
+    params.initToDefault();
+    for( size_t i = 0 ; i < m_nbPages ; ++i ) {
+        PRRenderPage renderPage( &m_document, i, &m_streams[i] );
+        renderPage.initRendering( params.resolution );
+        renderPage.renderElements( params );
+    }
+    return Work( m_nbPages, m_nbBytes );
+}
+
+}
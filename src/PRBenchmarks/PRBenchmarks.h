@@ -0,0 +1,183 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRBENCHMARKS_H
+#define PRBENCHMARKS_H
+
+#include "PRBenchmark.h"
+
+#include "PRDocument.h"
+#include "PRDocumentLayout.h"
+#include "PRGeometry/PRGDocument.h"
+
+#include "PdfeContentsStream.h"
+
+#include <vector>
+
+#include <QString>
+
+namespace PoDoFo {
+class PdfPage;
+}
+
+namespace PdfRecut {
+
+//************************************************************//
+//                       PRBenchDocument                      //
+//************************************************************//
+/** Base class of benchmarks working on the first pages of a document.
+ * The document is loaded at construction (not timed).
+ */
+class PRBenchDocument : public PRBenchmark
+{
+protected:
+    /** Load the document.
+     * \param name Name of the benchmark.
+     * \param filename Path of the PDF document.
+     * \param nbPages Maximum number of pages used.
+     */
+    PRBenchDocument( const std::string& name,
+                     const QString& filename,
+                     size_t nbPages );
+
+    /// Load the contents streams of the pages (m_streams and m_nbBytes).
+    void loadStreams();
+    /// PoDoFo page.
+    PoDoFo::PdfPage* podofoPage( size_t idx );
+
+protected:
+    /// Path of the document.
+    QString  m_filename;
+    /// Document.
+    PRDocument  m_document;
+    /// Number of pages used.
+    size_t  m_nbPages;
+    /// Contents streams of the pages (c.f. loadStreams).
+    std::vector<PoDoFoExtended::PdfeContentsStream>  m_streams;
+    /// Size of the contents streams, in bytes.
+    size_t  m_nbBytes;
+};
+
+//************************************************************//
+//                         Benchmarks                         //
+//************************************************************//
+/** Tokenization of pages contents streams (tokens/s).
+ */
+class PRBenchTokenizer : public PRBenchDocument
+{
+public:
+    PRBenchTokenizer( const QString& filename, size_t nbPages );
+protected:
+    virtual Work run();
+};
+
+/** Loading of pages contents streams (PdfeContentsStream::load).
+ */
+class PRBenchContentsLoad : public PRBenchDocument
+{
+public:
+    PRBenchContentsLoad( const QString& filename, size_t nbPages );
+protected:
+    virtual Work run();
+};
+
+/** Deep copy of pages contents streams (nodes copy).
+ */
+class PRBenchContentsCopy : public PRBenchDocument
+{
+public:
+    PRBenchContentsCopy( const QString& filename, size_t nbPages );
+protected:
+    virtual Work run();
+};
+
+/** Saving of pages contents streams into PoDoFo pages.
+ */
+class PRBenchContentsSave : public PRBenchDocument
+{
+public:
+    PRBenchContentsSave( const QString& filename, size_t nbPages );
+protected:
+    virtual Work run();
+};
+
+/** Generic analysis of pages contents streams (PdfeContentsAnalysis).
+ */
+class PRBenchContentsAnalysis : public PRBenchDocument
+{
+public:
+    PRBenchContentsAnalysis( const QString& filename, size_t nbPages );
+protected:
+    virtual Work run();
+};
+
+/** Detection of text lines (PRGTextPage::detectLines).
+ */
+class PRBenchDetectLines : public PRBenchDocument
+{
+public:
+    PRBenchDetectLines( const QString& filename, size_t nbPages );
+    virtual ~PRBenchDetectLines();
+protected:
+    virtual void setUp();
+    virtual Work run();
+private:
+    /// Geometry document.
+    PRGDocument*  m_pGDocument;
+};
+
+/** Transformation of a document with a layout splitting pages
+ * in two zones (PRDocumentLayout::transformDocument).
+ */
+class PRBenchTransform : public PRBenchDocument
+{
+public:
+    PRBenchTransform( const QString& filename, size_t nbPages );
+protected:
+    PRBenchTransform( const std::string& name, const QString& filename, size_t nbPages );
+    virtual void setUp();
+    virtual Work run();
+protected:
+    /// Document layout.
+    PRDocumentLayout  m_layout;
+};
+
+/** Incremental saving of a transformed document, followed by a
+ * round-trip check (not timed): the file written is reloaded and
+ * must have the same number of pages. Throw a PRException otherwise.
+ */
+class PRBenchSaveIncremental : public PRBenchTransform
+{
+public:
+    PRBenchSaveIncremental( const QString& filename, size_t nbPages );
+    virtual ~PRBenchSaveIncremental();
+protected:
+    virtual void setUp();
+    virtual Work run();
+    virtual void tearDown();
+private:
+    /// Output file.
+    QString  m_outFilename;
+};
+
+/** Basic rendering of pages (PRRenderPage::renderElements).
+ */
+class PRBenchRender : public PRBenchDocument
+{
+public:
+    PRBenchRender( const QString& filename, size_t nbPages );
+protected:
+    virtual Work run();
+};
+
+}
+
+#endif // PRBENCHMARKS_H
@@ -0,0 +1,203 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRBenchmark.h"
+#include "PRBenchmarks.h"
+#include "PRBenchCorpus.h"
+#include "PRException.h"
+
+#include <QsLog/QsLog.h>
+
+#include <podofo/podofo.h>
+#include <PoDoFoExtended.h>
+
+#include <QtCore>
+#include <QApplication>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace PdfRecut;
+using namespace PoDoFo;
+using namespace std;
+
+/** Run the benchmarks on a document and add results to a report.
+ * \param filename Path of the document.
+ * \param prefix Prefix of results names.
+ */
+void runBenchmarks( const QString& filename,
+                    const std::string& prefix,
+                    const QString& filter,
+                    size_t nbPages,
+                    size_t nbIterations,
+                    size_t nbWarmup,
+                    PRBenchmarkReport& report )
+{
+    // Benchmarks, from micro to macro.
+    QStringList names;
+    names << "parsing.tokenizer" << "contents.load" << "contents.copy" << "contents.save"
+          << "analysis.contents" << "analysis.detectLines" << "layout.transform"
+          << "layout.saveIncremental" << "render.elements";
+
+    for( int i = 0 ; i < names.size() ; ++i ) {
+        if( !names.at( i ).startsWith( filter ) ) {
+            continue;
+        }
+        PRBenchmark* pbench = NULL;
+        switch( i ) {
+        case 0: pbench = new PRBenchTokenizer( filename, nbPages );         break;
+        case 1: pbench = new PRBenchContentsLoad( filename, nbPages );      break;
+        case 2: pbench = new PRBenchContentsCopy( filename, nbPages );      break;
+        case 3: pbench = new PRBenchContentsSave( filename, nbPages );      break;
+        case 4: pbench = new PRBenchContentsAnalysis( filename, nbPages );  break;
+        case 5: pbench = new PRBenchDetectLines( filename, nbPages );       break;
+        case 6: pbench = new PRBenchTransform( filename, nbPages );         break;
+        case 7: pbench = new PRBenchSaveIncremental( filename, nbPages );   break;
+        case 8: pbench = new PRBenchRender( filename, nbPages );            break;
+        }
+        PRBenchmark::Result result = pbench->execute( nbIterations, nbWarmup );
+        result.name = prefix + result.name;
+        report.add( result );
+        delete pbench;
+    }
+}
+
+/** Usage: PRBenchmarks file.pdf [--pages N] [--iterations N] [--warmup N]
+ *                              [--filter prefix] [--json output.json]
+ *         PRBenchmarks --synthetic dir [--seed S] [options]
+ * Synthetic mode: generate the corpus of PRBenchCorpus in a directory
+ * and run the benchmarks on each document.
+ * Option --profile output.json: enable PdfeProfiler during benchmarks and
+ * write its summary (phases timing, and allocations per phase in
+ * allocation profiling builds).
+ * Regression gate: --baseline report.json [--threshold 0.1] compares
+ * median times to a previous JSON report (c.f. --json) and exits with
+ * code 2 if a benchmark is significantly slower than the threshold.
+ */
+int main( int argc, char *argv[] )
+{
+    QApplication a( argc, argv );
+
+    // Disable PoDoFo and QsLog messages: not part of the measures.
+    PdfError::EnableLogging( false );
+    PdfError::EnableDebug( false );
+    QsLogging::Logger::instance().setLoggingLevel( QsLogging::FatalLevel );
+    PoDoFoExtended::PdfeFont::Standard14FontsDir.setPath( "./standard14fonts" );
+
+    QStringList args = QCoreApplication::arguments();
+    if( args.size() < 2 ) {
+        cout << "Usage: PRBenchmarks file.pdf [--pages N] [--iterations N] [--warmup N] "
+             << "[--filter prefix] [--json output.json] [--profile output.json]" << endl
+             << "       PRBenchmarks --synthetic dir [--seed S] [options]" << endl
+             << "Regression gate: [--baseline report.json] [--threshold 0.1]" << endl;
+        return 1;
+    }
+    QString filename;
+    QString syntheticDir;
+    unsigned int seed = 1;
+    size_t nbPages = 10;
+    size_t nbIterations = 5;
+    size_t nbWarmup = 1;
+    QString filter;
+    QString jsonFilename;
+    QString profileFilename;
+    QString baselineFilename;
+    double threshold = 0.1;
+    int i = 1;
+    if( !args.at( 1 ).startsWith( "--" ) ) {
+        filename = args.at( 1 );
+        i = 2;
+    }
+    for( ; i+1 < args.size() ; i += 2 ) {
+        if( args.at( i ) == "--pages" ) {
+            nbPages = args.at( i+1 ).toUInt();
+        }
+        else if( args.at( i ) == "--iterations" ) {
+            nbIterations = args.at( i+1 ).toUInt();
+        }
+        else if( args.at( i ) == "--warmup" ) {
+            nbWarmup = args.at( i+1 ).toUInt();
+        }
+        else if( args.at( i ) == "--filter" ) {
+            filter = args.at( i+1 );
+        }
+        else if( args.at( i ) == "--json" ) {
+            jsonFilename = args.at( i+1 );
+        }
+        else if( args.at( i ) == "--synthetic" ) {
+            syntheticDir = args.at( i+1 );
+        }
+        else if( args.at( i ) == "--seed" ) {
+            seed = args.at( i+1 ).toUInt();
+        }
+        else if( args.at( i ) == "--profile" ) {
+            profileFilename = args.at( i+1 );
+        }
+        else if( args.at( i ) == "--baseline" ) {
+            baselineFilename = args.at( i+1 );
+        }
+        else if( args.at( i ) == "--threshold" ) {
+            threshold = args.at( i+1 ).toDouble();
+        }
+    }
+    PRBenchmarkBaseline baseline;
+    if( !baselineFilename.isEmpty() && !baseline.load( baselineFilename ) ) {
+        cerr << "Can not load baseline: " << baselineFilename.toLocal8Bit().constData() << endl;
+        return 1;
+    }
+    PoDoFoExtended::PdfeProfiler& profiler = PoDoFoExtended::PdfeProfiler::instance();
+    profiler.setEnabled( !profileFilename.isEmpty() );
+
+    PRBenchmarkReport report;
+    try {
+        if( syntheticDir.isEmpty() ) {
+            runBenchmarks( filename, "", filter, nbPages, nbIterations, nbWarmup, report );
+        }
+        else {
+            // One set of results per synthetic document: "name/benchmark".
+            QStringList corpus = PRBenchCorpus::generateCorpus( syntheticDir, seed );
+            for( int j = 0 ; j < corpus.size() ; ++j ) {
+                std::string prefix = QFileInfo( corpus.at( j ) ).completeBaseName()
+                        .toLocal8Bit().constData();
+                runBenchmarks( corpus.at( j ), prefix + "/", filter,
+                               nbPages, nbIterations, nbWarmup, report );
+            }
+            filename = QString( "synthetic:%1" ).arg( seed );
+        }
+    }
+    catch( const PRException& error ) {
+        cerr << "PdfRecut error: " << error.description().toLocal8Bit().constData() << endl;
+        return 1;
+    }
+    catch( const PdfError& error ) {
+        cerr << "PoDoFo error: " << error.what() << endl;
+        return 1;
+    }
+
+    report.writeText( cout );
+    if( !jsonFilename.isEmpty() ) {
+        std::ofstream ofile( jsonFilename.toLocal8Bit().constData(), ios_base::out | ios_base::trunc );
+        report.writeJSON( ofile, filename.toLocal8Bit().constData() );
+    }
+    if( profiler.isEnabled() ) {
+        profiler.writeJSON( profileFilename, filename.toLocal8Bit().constData() );
+    }
+    if( !baselineFilename.isEmpty() ) {
+        cout << endl;
+        size_t nbRegressions = baseline.compare( report, threshold, cout );
+        if( nbRegressions ) {
+            cout << nbRegressions << " benchmark(s) slower than the baseline." << endl;
+            return 2;
+        }
+    }
+    return 0;
+}
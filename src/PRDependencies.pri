@@ -5,6 +5,17 @@
 ### 3rd party librairies (QsLog, vmmlib, ...)
 INCLUDEPATH += $$PWD/3rdparty
 
+### Allocation profiling: global operators new/delete counting heap
+### allocations per profiler span (qmake CONFIG+=alloc_profiling).
+alloc_profiling {
+    DEFINES += PDFE_PROFILE_ALLOCATIONS
+}
+
+### Logging: messages below Info level compiled out (qmake CONFIG+=log_min_info).
+log_min_info {
+    DEFINES += QS_LOG_MIN_LEVEL=2
+}
+
 ### PoDoFo and its dependencies
 win32 {
     ### PoDoFo path
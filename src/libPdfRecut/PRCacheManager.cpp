@@ -0,0 +1,229 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRCacheManager.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace PdfRecut {
+
+PRCacheManager::PRCacheManager() :
+    m_lists( PRCacheKind::size() ),
+    m_priorities( PRCacheKind::size(), 1.0 ),
+    m_maxEntries( PRCacheKind::size(), 0 ),
+    m_statistics( PRCacheKind::size() ),
+    m_budget( DefaultBudget ),
+    m_nbBytes( 0 ),
+    m_clock( 0 ),
+    m_mutex( QMutex::Recursive )
+{
+    m_maxEntries[ PRCacheKind::Geometry ] = DefaultMaxGeometryEntries;
+}
+
+void PRCacheManager::insert( Client* pclient,
+                             PRCacheKind::Enum kind,
+                             Client* pdependency )
+{
+    QMutexLocker locker( &m_mutex );
+    ++m_clock;
+    size_t footprint = pclient->cacheFootprint();
+    QHash<Client*, Entry>::iterator it = m_entries.find( pclient );
+    if( it == m_entries.end() ) {
+        Entry entry;
+        entry.kind = kind;
+        entry.footprint = footprint;
+        entry.lastUse = m_clock;
+        entry.pdependency = pdependency;
+        m_lists[ kind ].push_back( pclient );
+        entry.itLRU = --m_lists[ kind ].end();
+        m_entries.insert( pclient, entry );
+
+        // Register as dependent (whether the dependency is cached or not).
+        if( pdependency ) {
+            std::vector<Client*>& pdependents = m_dependents[ pdependency ];
+            if( std::find( pdependents.begin(), pdependents.end(), pclient ) == pdependents.end() ) {
+                pdependents.push_back( pclient );
+            }
+        }
+        m_nbBytes += footprint;
+        m_statistics[ kind ].nbBytes += footprint;
+        ++m_statistics[ kind ].nbEntries;
+        ++m_statistics[ kind ].misses;
+    }
+    else {
+        // Update footprint.
+        Entry& entry = it.value();
+        m_nbBytes += footprint - entry.footprint;
+        m_statistics[ entry.kind ].nbBytes += footprint - entry.footprint;
+        entry.footprint = footprint;
+    }
+    this->setUsed( pclient );
+    this->clean();
+}
+void PRCacheManager::touch( Client* pclient )
+{
+    QMutexLocker locker( &m_mutex );
+    if( m_entries.contains( pclient ) ) {
+        ++m_clock;
+        ++m_statistics[ m_entries.value( pclient ).kind ].hits;
+        this->setUsed( pclient );
+    }
+}
+void PRCacheManager::remove( Client* pclient )
+{
+    QMutexLocker locker( &m_mutex );
+    QHash<Client*, Entry>::iterator it = m_entries.find( pclient );
+    if( it == m_entries.end() ) {
+        return;
+    }
+    Entry entry = it.value();
+    m_entries.erase( it );
+    m_lists[ entry.kind ].erase( entry.itLRU );
+    m_nbBytes -= entry.footprint;
+    m_statistics[ entry.kind ].nbBytes -= entry.footprint;
+    --m_statistics[ entry.kind ].nbEntries;
+
+    // Unregister from the dependency.
+    QHash<Client*, std::vector<Client*> >::iterator itDep = m_dependents.find( entry.pdependency );
+    if( entry.pdependency && itDep != m_dependents.end() ) {
+        std::vector<Client*>& pdependents = itDep.value();
+        pdependents.erase( std::remove( pdependents.begin(), pdependents.end(), pclient ),
+                           pdependents.end() );
+        if( pdependents.empty() ) {
+            m_dependents.erase( itDep );
+        }
+    }
+    // Dependents reference the data: release them (they unregister themselves).
+    std::vector<Client*> pdependents = m_dependents.value( pclient );
+    for( size_t i = 0 ; i < pdependents.size() ; ++i ) {
+        this->release( pdependents[i] );
+    }
+}
+bool PRCacheManager::contains( Client* pclient ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_entries.contains( pclient );
+}
+
+void PRCacheManager::setBudget( size_t nbBytes )
+{
+    QMutexLocker locker( &m_mutex );
+    size_t minBudget = 1 << 20;
+    m_budget = std::max( nbBytes, minBudget );
+    this->clean();
+}
+void PRCacheManager::setPriority( PRCacheKind::Enum kind, double priority )
+{
+    QMutexLocker locker( &m_mutex );
+    m_priorities[ kind ] = std::max( priority, std::numeric_limits<double>::epsilon() );
+}
+void PRCacheManager::setMaxEntries( PRCacheKind::Enum kind, size_t nbEntries )
+{
+    QMutexLocker locker( &m_mutex );
+    m_maxEntries[ kind ] = nbEntries;
+    this->clean();
+}
+size_t PRCacheManager::budget() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_budget;
+}
+double PRCacheManager::priority( PRCacheKind::Enum kind ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_priorities[ kind ];
+}
+size_t PRCacheManager::maxEntries( PRCacheKind::Enum kind ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_maxEntries[ kind ];
+}
+size_t PRCacheManager::nbBytes() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_nbBytes;
+}
+PRCacheManager::Statistics PRCacheManager::statistics( PRCacheKind::Enum kind ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_statistics[ kind ];
+}
+void PRCacheManager::resetStatistics()
+{
+    QMutexLocker locker( &m_mutex );
+    for( size_t i = 0 ; i < m_statistics.size() ; ++i ) {
+        m_statistics[i].hits = 0;
+        m_statistics[i].misses = 0;
+        m_statistics[i].evictions = 0;
+    }
+}
+
+void PRCacheManager::clean()
+{
+    // Maximum numbers of entries: LRU entries of the kind.
+    for( size_t i = 0 ; i < m_lists.size() ; ++i ) {
+        while( m_maxEntries[i] && m_lists[i].size() > m_maxEntries[i] &&
+               m_entries[ m_lists[i].front() ].lastUse != m_clock ) {
+            this->release( m_lists[i].front() );
+        }
+    }
+    while( m_nbBytes > m_budget ) {
+        // Victim: LRU entry with the largest weighted age.
+        Client* pvictim = NULL;
+        double maxAge = 0.0;
+        for( size_t i = 0 ; i < m_lists.size() ; ++i ) {
+            if( m_lists[i].empty() ) {
+                continue;
+            }
+            const Entry& entry = m_entries[ m_lists[i].front() ];
+            if( entry.lastUse == m_clock ) {
+                continue;
+            }
+            double age = ( m_clock - entry.lastUse ) / m_priorities[i];
+            if( age > maxAge ) {
+                maxAge = age;
+                pvictim = m_lists[i].front();
+            }
+        }
+        if( !pvictim ) {
+            break;
+        }
+        this->release( pvictim );
+    }
+}
+void PRCacheManager::release( Client* pclient )
+{
+    QHash<Client*, Entry>::iterator it = m_entries.find( pclient );
+    if( it == m_entries.end() ) {
+        return;
+    }
+    ++m_statistics[ it.value().kind ].evictions;
+    // Remove entry (and dependents) before releasing data.
+    this->remove( pclient );
+    pclient->cacheRelease();
+}
+void PRCacheManager::setUsed( Client* pclient )
+{
+    while( pclient ) {
+        QHash<Client*, Entry>::iterator it = m_entries.find( pclient );
+        if( it == m_entries.end() ) {
+            return;
+        }
+        Entry& entry = it.value();
+        entry.lastUse = m_clock;
+        std::list<Client*>& lru = m_lists[ entry.kind ];
+        lru.splice( lru.end(), lru, entry.itLRU );
+        pclient = entry.pdependency;
+    }
+}
+
+}
@@ -0,0 +1,197 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRCACHEMANAGER_H
+#define PRCACHEMANAGER_H
+
+#include <list>
+#include <vector>
+
+#include <QHash>
+#include <QMutex>
+
+namespace PdfRecut {
+
+namespace PRCacheKind {
+/** Kinds of data registered in the cache manager.
+ */
+enum Enum {
+    Contents = 0,   /// Pages contents streams (PRPage).
+    Geometry,       /// Pages geometry data: text, paths,... (PRGPage).
+    Streams         /// Streams decoded in advance (PdfeStreamDecoder).
+};
+/// Number of kinds of data.
+inline size_t size() {
+    static size_t size = 3;
+    return size;
+}
+}
+
+//************************************************************//
+//                       PRCacheManager                       //
+//************************************************************//
+/** Cache manager shared by the objects of a document holding data
+ * which can be released and reloaded on demand (contents streams,
+ * geometry data,...). Memory is accounted against a global byte budget.
+ *
+ * Each kind of data has its own LRU list and a priority: the entry
+ * evicted is the least recently used entry whose age, divided by the
+ * priority of its kind, is the largest. An entry can depend on another
+ * one (e.g. geometry data on contents): using the first one also
+ * refreshes its dependency, and releasing the dependency releases
+ * its dependents first.
+ *
+ * The manager is thread-safe (recursive mutex): clients may call it
+ * back from cacheRelease().
+ */
+class PRCacheManager
+{
+public:
+    /** Interface of objects registered in the cache manager.
+     */
+    class Client
+    {
+    public:
+        virtual ~Client() { }
+        /// Memory footprint of the cached data, in bytes.
+        virtual size_t cacheFootprint() const = 0;
+        /// Release cached data (eviction). The entry is already removed.
+        virtual void cacheRelease() = 0;
+    };
+
+    /** Statistics of a kind of data.
+     */
+    struct Statistics
+    {
+        /// Accesses to data already cached.
+        size_t  hits;
+        /// Data loaded into the cache.
+        size_t  misses;
+        /// Data evicted to respect the budget (dependents included).
+        size_t  evictions;
+        /// Number of entries currently cached.
+        size_t  nbEntries;
+        /// Memory footprint of cached entries, in bytes.
+        size_t  nbBytes;
+
+        Statistics() :
+            hits( 0 ), misses( 0 ), evictions( 0 ), nbEntries( 0 ), nbBytes( 0 ) { }
+    };
+
+public:
+    /** Create an empty cache manager (default budget, priorities set to 1,
+     * at most DefaultMaxGeometryEntries geometry entries).
+     */
+    PRCacheManager();
+
+    /** Insert data into the cache (miss). If already present, the footprint
+     * is updated and the entry is marked as recently used.
+     * The cache is then cleaned to respect the budget.
+     * \param pclient Object holding the data.
+     * \param kind Kind of data.
+     * \param pdependency Data the object depends on (can be NULL).
+     */
+    void insert( Client* pclient,
+                 PRCacheKind::Enum kind,
+                 Client* pdependency = NULL );
+    /** Mark data as recently used (hit). Does nothing if not cached.
+     * \param pclient Object holding the data.
+     */
+    void touch( Client* pclient );
+    /** Remove data from the cache, without releasing it. Dependents
+     * of the entry are released.
+     * \param pclient Object holding the data.
+     */
+    void remove( Client* pclient );
+    /** Is the data of an object cached?
+     */
+    bool contains( Client* pclient ) const;
+
+public:
+    /// Set global budget, in bytes (minimum: 1 MB, default: DefaultBudget).
+    void setBudget( size_t nbBytes );
+    /// Global budget, in bytes.
+    size_t budget() const;
+    /// Set the priority of a kind of data (> 0; higher: kept longer).
+    void setPriority( PRCacheKind::Enum kind, double priority );
+    /// Priority of a kind of data.
+    double priority( PRCacheKind::Enum kind ) const;
+    /// Set the maximum number of entries of a kind of data (0: unlimited).
+    void setMaxEntries( PRCacheKind::Enum kind, size_t nbEntries );
+    /// Maximum number of entries of a kind of data (0: unlimited).
+    size_t maxEntries( PRCacheKind::Enum kind ) const;
+    /// Memory footprint of cached data, in bytes.
+    size_t nbBytes() const;
+
+    /// Statistics of a kind of data.
+    Statistics statistics( PRCacheKind::Enum kind ) const;
+    /// Reset counters (hits, misses and evictions).
+    void resetStatistics();
+
+public:
+    /// Default global budget, in bytes (256 MB).
+    static const size_t DefaultBudget = size_t( 256 ) << 20;
+    /// Default maximum number of geometry entries.
+    static const size_t DefaultMaxGeometryEntries = 10;
+
+private:
+    /** Release entries until the budget and the maximum numbers of entries
+     * are respected. Entries used by the last operation are never released.
+     */
+    void clean();
+    /** Remove an entry and release its data and the data of its dependents.
+     * \param pclient Object holding the data.
+     */
+    void release( Client* pclient );
+    /// Set an entry as the most recently used one (and its dependency).
+    void setUsed( Client* pclient );
+
+private:
+    /// Cache entry.
+    struct Entry {
+        /// Kind of data.
+        PRCacheKind::Enum  kind;
+        /// Memory footprint.
+        size_t  footprint;
+        /// Last use (manager clock).
+        size_t  lastUse;
+        /// Dependency (can be NULL).
+        Client*  pdependency;
+        /// Position in the LRU list of its kind.
+        std::list<Client*>::iterator  itLRU;
+    };
+    /// Cache entries.
+    QHash<Client*, Entry>  m_entries;
+    /// LRU lists (least recently used first), one per kind.
+    std::vector< std::list<Client*> >  m_lists;
+    /// Dependents of objects, cached or not (dependency links are kept
+    /// when the dependency is released and cached again).
+    QHash<Client*, std::vector<Client*> >  m_dependents;
+    /// Priorities of kinds.
+    std::vector<double>  m_priorities;
+    /// Maximum numbers of entries of kinds.
+    std::vector<size_t>  m_maxEntries;
+    /// Statistics of kinds.
+    std::vector<Statistics>  m_statistics;
+
+    /// Global budget.
+    size_t  m_budget;
+    /// Memory footprint of cached data.
+    size_t  m_nbBytes;
+    /// Manager clock (incremented at every operation).
+    size_t  m_clock;
+    /// Manager mutex (recursive).
+    mutable QMutex  m_mutex;
+};
+
+}
+
+#endif // PRCACHEMANAGER_H
@@ -21,6 +21,8 @@
 #include "PdfeFontType1.h"
 #include "PdfeFontType3.h"
 #include "PdfeUtils.h"
+#include "PdfeMappedFile.h"
+#include "PdfeProfiler.h"
 
 #include <QtCore>
 #include <podofo/podofo.h>
@@ -37,30 +39,38 @@ namespace PdfRecut {
 //                         PRDocument                         //
 //************************************************************//
 PRDocument::PRDocument( QObject* parent ) :
-    QObject( parent )
+    QObject( parent ),
+    m_podofoMutex( QMutex::Recursive ),
+    m_streamDecoderClient( &m_streamDecoder ),
+    m_pagePrefetcher( this )
 {
     m_filename = QString();
     m_podofoDocument = NULL;
+    m_loadMode = PRDocumentLoadMode::Memory;
+    m_mappedFile = NULL;
+    m_pagesTreeDirty = false;
+    m_podofoModified = false;
     // Initialize freetype library.
     if( FT_Init_FreeType( &m_ftLibrary ) ) {
         throw PRException( PRExceptionCode::FreeType,
                            tr( "Can not initialize FreeType library." ),
                            true );
     }
-    // Default cache size.
-    m_pagesCacheSize = std::numeric_limits<size_t>::max();
+    // Default cache size and prefetch depth.
+    m_prefetchDepth = 2;
 }
 PRDocument::~PRDocument()
 {
     this->clear();
 }
 
-void PRDocument::load( const QString& filename )
+void PRDocument::load( const QString& filename, PRDocumentLoadMode::Enum mode )
 {
+    PDFE_PROFILE_SCOPE( "document.load" );
     // Clear document.
     this->clear();
     // Load PoDoFo document.
-    this->loadPoDoFoDocument( filename );
+    this->loadPoDoFoDocument( filename, mode );
     // Load pages.
     this->loadPages();
 
@@ -69,14 +79,21 @@ void PRDocument::load( const QString& filename )
 //    emit methodProgress( methodTitle, 0.0 );
 //    emit methodProgress( methodTitle, 1.0 );
 }
-void PRDocument::save( const QString& filename )
+void PRDocument::save( const QString& filename, PRDocumentSaveMode::Enum mode )
 {
+    PDFE_PROFILE_SCOPE( "document.save" );
     // Write down PoDoFo document.
     QString suffix( "_PdfRecut" );
+    if( mode == PRDocumentSaveMode::Incremental &&
+            this->writePoDoFoUpdate( filename, suffix ) ) {
+        return;
+    }
     this->writePoDoFoDocument( filename, suffix );
 }
 void PRDocument::clear()
 {
+    // Pending background loadings first (use PoDoFo objects).
+    m_pagePrefetcher.clear();
     // Cleat font cache.
     this->clearFontCache();
     // Clear pages.
@@ -88,13 +105,17 @@ void PRDocument::clear()
 PRPage* PRDocument::insertPage( size_t index, PRPage* pPage )
 {
     index = std::min( std::max( index, size_t(0) ), m_pPages.size() );
+    // Pages indexes are shifted: prefetched contents discarded.
+    m_pagePrefetcher.clear();
     // Create temp page and insert it in the PoDoFo pages tree.
     PdfPage* tmpPage = new PdfPage( pPage->mediaBox(), m_podofoDocument );
     m_podofoDocument->GetPagesTree()->InsertPage( int(index)-1, tmpPage );
+    m_pagesIndex.insert( index, tmpPage->GetObject() );
     delete tmpPage;
 
     // Insert PRPage object and push modifications.
     m_pPages.insert( m_pPages.begin()+index, pPage );
+    m_pagesTreeDirty = true;
     this->attachPage( index );
     m_pPages[ index ]->pushModifications( true, true );
     // Update pages indexes.
@@ -108,41 +129,107 @@ PRPage* PRDocument::insertPage( size_t index )
 void PRDocument::deletePage( size_t index )
 {
     index = std::min( std::max( index, size_t(0) ), m_pPages.size()-1 );
+    m_pagePrefetcher.clear();
     // Delete PoDoFo::PdfPage.
     m_podofoDocument->GetPagesTree()->DeletePage( index );
+    m_pagesIndex.erase( index );
     // TODO: move page objects to trash before deleting...
 
     // Delete PRPage.
+    m_cacheManager.remove( m_pPages[ index ] );
     delete m_pPages[ index ];
     m_pPages.erase( m_pPages.begin() + index );
+    m_pagesTreeDirty = true;
     this->setPagesIndex();
 }
 
 void PRDocument::loadPages()
 {
     this->clearPages();
-    // Load pages from PoDoFo document.
-    size_t nbPages = m_podofoDocument->GetPageCount();
-    m_pPages.resize( nbPages );
-    for( size_t i = 0 ; i < nbPages ; ++i ) {
-        m_pPages[i] = new PRPage();
-        m_pPages[i]->load( m_podofoDocument->GetPage( i ), false, true );
-        this->attachPage( i );
+    // Pages index and table: PRPage objects created on first access.
+    m_pagesIndex.build( m_podofoDocument );
+    m_pPages.resize( m_pagesIndex.size(), NULL );
+}
+void PRDocument::reloadPages()
+{
+    // Detach pages first: PoDoFo pages of the previous index may not exist anymore,
+    // cached contents are simply dropped.
+    std::vector<PRPage*> pPages;
+    pPages.swap( m_pPages );
+    for( size_t i = 0 ; i < pPages.size() ; ++i ) {
+        if( pPages[i] ) {
+            m_cacheManager.remove( pPages[i] );
+            delete pPages[i]->m_pContentsStream;
+            pPages[i]->m_pContentsStream = NULL;
+            pPages[i]->setListener( NULL );
+            pPages[i]->setParent( NULL );
+        }
+    }
+    m_pagesIndex.build( m_podofoDocument );
+    m_pPages.resize( m_pagesIndex.size(), NULL );
+
+    // PRPage objects are kept (geometry pages refer to them): re-pointed at the new PoDoFo pages.
+    for( size_t i = 0 ; i < pPages.size() ; ++i ) {
+        if( !pPages[i] ) {
+            continue;
+        }
+        if( i < m_pPages.size() ) {
+            m_pPages[i] = pPages[i];
+            m_pPages[i]->setPageIndex( i );
+            m_pPages[i]->load( m_pagesIndex.page( i ), false, true );
+            this->attachPage( i );
+        }
+        else {
+            // Pages removed: kept detached until the document is cleared.
+            m_pDetachedPages.push_back( pPages[i] );
+        }
+    }
+}
+void PRDocument::loadPage( size_t index )
+{
+    m_pPages[index] = new PRPage();
+    m_pPages[index]->load( m_pagesIndex.page( index ), false, true );
+    this->attachPage( index );
+}
+PRPage* PRDocument::page( size_t idx )
+{
+    if( !m_pPages.at( idx ) ) {
+        this->loadPage( idx );
     }
+    return m_pPages[ idx ];
+}
+const PRPage* PRDocument::page( size_t idx ) const
+{
+    // Loading a page on demand does not modify the document.
+    return const_cast<PRDocument*>( this )->page( idx );
 }
 void PRDocument::clearPages()
 {
     for( size_t i = 0 ; i < m_pPages.size() ; ++i ) {
-        delete m_pPages[i];
+        if( m_pPages[i] ) {
+            // Detach first: the PoDoFo page may not exist anymore (pages tree modified),
+            // cached contents are simply dropped.
+            m_cacheManager.remove( m_pPages[i] );
+            m_pPages[i]->setListener( NULL );
+            m_pPages[i]->setParent( NULL );
+            delete m_pPages[i];
+        }
     }
     m_pPages.clear();
-    // Clear cache.
-    m_pagesCacheList.clear();
+    for( size_t i = 0 ; i < m_pDetachedPages.size() ; ++i ) {
+        delete m_pDetachedPages[i];
+    }
+    m_pDetachedPages.clear();
+    m_pagesIndex.clear();
+    m_pagesTreeDirty = false;
+    m_podofoModified = false;
 }
 void PRDocument::setPagesIndex()
 {
     for( size_t i = 0 ; i < m_pPages.size() ; ++i ) {
-        m_pPages[i]->setPageIndex( i );
+        if( m_pPages[i] ) {
+            m_pPages[i]->setPageIndex( i );
+        }
     }
 }
 
@@ -152,65 +239,116 @@ void PRDocument::attachPage( size_t index )
         PRPage* page = m_pPages[index];
         page->setPageIndex( index );
         page->setParent( this );
-        // Connect signals:
-        QObject::connect( page, SIGNAL(contentsCached(size_t)),
-                          this, SLOT(cachePageContents(size_t)) );
-        QObject::connect( page, SIGNAL(modified(size_t,bool,bool)),
-                          this, SLOT(cachePageContents(size_t)) );
-        QObject::connect( page, SIGNAL(contentsUncached(size_t)),
-                          this, SLOT(uncachePageContents(size_t)) );
+        page->setListener( this );
     }
 }
 
-void PRDocument::setPagesCacheSize( size_t cacheSize )
+void PRDocument::pageContentsCached( size_t pageIndex )
+{
+    this->cachePageContents( pageIndex );
+}
+void PRDocument::pageContentsUncached( size_t pageIndex )
+{
+    this->uncachePageContents( pageIndex );
+}
+void PRDocument::pageModified( size_t pageIndex, bool incContents, bool incAttributes )
+{
+    // Update cache entry (footprint).
+    Q_UNUSED( incContents );
+    Q_UNUSED( incAttributes );
+    this->cachePageContents( pageIndex );
+}
+
+void PRDocument::updatePagesIndex()
+{
+    QMutexLocker locker( &m_podofoMutex );
+    // Prefetched contents and PRPage objects refer to the previous pages.
+    m_pagePrefetcher.clear();
+    m_streamDecoder.clear();
+    this->updateStreamDecoderCache();
+    this->reloadPages();
+    // Pages tree (and other objects) modified directly on the PoDoFo document.
+    m_pagesTreeDirty = true;
+    m_podofoModified = true;
+}
+
+void PRDocument::notifyPoDoFoModified()
+{
+    // Contents loaded in advance may be outdated.
+    m_pagePrefetcher.clear();
+    m_podofoModified = true;
+}
+
+void PRDocument::setContentsCacheDirectory( const QString& cacheDir, qint64 maxSize )
+{
+    m_contentsCache.setCacheDirectory( cacheDir );
+    m_contentsCache.setMaxSize( maxSize );
+}
+void PRDocument::prefetchPagesContents( size_t pageIndex )
+{
+    // Current page and upcoming ones: decoding on the thread pool.
+    size_t lastIndex = std::min( pageIndex + m_prefetchDepth + 1, m_pPages.size() );
+    std::vector<PdfCanvas*> pcanvases;
+    for( size_t i = pageIndex ; i < lastIndex ; ++i ) {
+        if( ( !m_pPages[i] || !m_pPages[i]->isContentsCached() ) && m_pagesIndex.page( i ) ) {
+            pcanvases.push_back( m_pagesIndex.page( i ) );
+        }
+    }
+    // Streams out of the window will not be taken (random accesses, jumps).
+    m_streamDecoder.retain( pcanvases );
+    for( size_t i = 0 ; i < pcanvases.size() ; ++i ) {
+        m_streamDecoder.prefetch( pcanvases[i] );
+    }
+    this->updateStreamDecoderCache();
+}
+void PRDocument::updateStreamDecoderCache()
 {
-    size_t minCacheSize = 10;
-    m_pagesCacheSize = std::max( cacheSize, size_t( minCacheSize ) );
-    this->cleanCachePages();
+    // Decoded streams accounted in the budget, released first if unused.
+    if( m_streamDecoder.size() ) {
+        m_cacheManager.insert( &m_streamDecoderClient, PRCacheKind::Streams );
+    }
+    else {
+        m_cacheManager.remove( &m_streamDecoderClient );
+    }
 }
 void PRDocument::cachePageContents( size_t pageIndex )
 {
-    // Find index in the cache list.
-    std::list<size_t>::iterator it;
-    it = std::find( m_pagesCacheList.begin(), m_pagesCacheList.end(), pageIndex );
-    if( it == m_pagesCacheList.end() ) {
-        m_pagesCacheList.push_back( pageIndex );
-        m_pPages[ pageIndex ]->cacheContents();
+    // Insert in the cache manager, or update footprint if already cached.
+    PRPage* page = m_pPages[ pageIndex ];
+    if( !m_cacheManager.contains( page ) ) {
+        page->cacheContents();
         // Log information.
         QLOG_INFO() << QString( "<PRDocument> Cache page contents stream (index: %1)." )
                        .arg( pageIndex ).toAscii().constData();
     }
-    else {
-        // Already cached: push to the back of the list.
-        m_pagesCacheList.erase( it );
-        m_pagesCacheList.push_back( pageIndex );
-    }
-    // Clean cache.
-    this->cleanCachePages();
+    m_cacheManager.insert( page, PRCacheKind::Contents );
+    // Decoded streams of the page have been taken.
+    this->updateStreamDecoderCache();
+    // Contents loaded in advance are outdated (modifications). Schedule next pages.
+    m_pagePrefetcher.discard( pageIndex );
+    m_pagePrefetcher.notifyAccess( pageIndex );
+}
+void PRDocument::touchPageContents( size_t pageIndex )
+{
+    m_cacheManager.touch( m_pPages[ pageIndex ] );
+    m_pagePrefetcher.notifyAccess( pageIndex );
 }
 void PRDocument::uncachePageContents( size_t pageIndex )
 {
-    // Find index in the cache list.
-    std::list<size_t>::iterator it;
-    it = std::find( m_pagesCacheList.begin(), m_pagesCacheList.end(), pageIndex );
-    if( it != m_pagesCacheList.end() ) {
-        // Remove index and uncache contents.
-        m_pagesCacheList.erase( it );
-        m_pPages[ pageIndex ]->uncacheContents();
+    PRPage* page = m_pPages[ pageIndex ];
+    if( m_cacheManager.contains( page ) ) {
+        // Remove from the manager and uncache contents.
+        m_cacheManager.remove( page );
+        page->uncacheContents();
         // Log information.
         QLOG_INFO() << QString( "<PRDocument> Uncache page contents stream (index: %1)." )
                        .arg( pageIndex ).toAscii().constData();
     }
 }
-void PRDocument::cleanCachePages()
-{
-    while( m_pagesCacheList.size() > m_pagesCacheSize ) {
-        this->uncachePageContents( m_pagesCacheList.front() );
-    }
-}
 
 
-PoDoFo::PdfMemDocument* PRDocument::loadPoDoFoDocument( const QString& filename )
+PoDoFo::PdfMemDocument* PRDocument::loadPoDoFoDocument( const QString& filename,
+                                                        PRDocumentLoadMode::Enum mode )
 {
     // Not null pointer: free current document before loading.
     if( m_podofoDocument ) {
@@ -226,8 +364,16 @@ PoDoFo::PdfMemDocument* PRDocument::loadPoDoFoDocument( const QString& filename
                        .arg( QFileInfo( m_filename ).fileName() )
                        .toAscii().constData();
 
+        m_loadMode = mode;
         m_podofoDocument = new PoDoFo::PdfMemDocument();
-        m_podofoDocument->Load( m_filename.toLocal8Bit().data() );
+        if( m_loadMode == PRDocumentLoadMode::Lazy ) {
+            // Memory-mapped file: objects are parsed when first accessed.
+            m_mappedFile = new PdfeMappedFile( m_filename );
+            m_podofoDocument->Load( m_mappedFile->device() );
+        }
+        else {
+            m_podofoDocument->Load( m_filename.toLocal8Bit().data() );
+        }
         // Log information.
         QLOG_INFO() << QString( "<PRDocument> End loading PoDoFo document \"%1\" (%2 pages)." )
                        .arg( QFileInfo( m_filename ).fileName() )
@@ -239,6 +385,8 @@ PoDoFo::PdfMemDocument* PRDocument::loadPoDoFoDocument( const QString& filename
         // Reset members.
         delete m_podofoDocument;
         m_podofoDocument = NULL;
+        delete m_mappedFile;
+        m_mappedFile = NULL;
         m_filename.clear();
         // Throw exception...
         PRException errPR( error );
@@ -257,13 +405,7 @@ void PRDocument::writePoDoFoDocument( const QString& filename, const QString& su
         return;
     }
     // Fix filename if corresponds to m_filename.
-    QString fileOut = filename;
-    QFileInfo infoOut( fileOut );
-    if( infoOut == QFileInfo( m_filename ) ) {
-        fileOut = infoOut.canonicalPath() + "/"
-                + infoOut.completeBaseName()
-                + QString("%1.pdf").arg( suffix );
-    }
+    QString fileOut = this->outputFilename( filename, suffix );
     // Get mutex and then write file.
     QMutexLocker locker( &m_podofoMutex );
     try
@@ -289,12 +431,231 @@ void PRDocument::writePoDoFoDocument( const QString& filename, const QString& su
         throw errPR;
     }
 }
+bool PRDocument::writePoDoFoUpdate( const QString& filename, const QString& suffix )
+{
+    // No document loaded.
+    if( !m_podofoDocument ) {
+        throw PRException( PRExceptionCode::PoDoFo,
+                           tr( "Can not write down PoDoFo document: no file loaded." ),
+                           true );
+    }
+    QString fileOut = this->outputFilename( filename, suffix );
+    QMutexLocker locker( &m_podofoMutex );
+
+    // Modified objects are only tracked through PRPage objects.
+    if( m_podofoModified ) {
+        QLOG_WARN() << QString( "<PRDocument> Incremental update not possible for \"%1\" (document modified outside pages): full writing." )
+                       .arg( QFileInfo( m_filename ).fileName() ).toAscii().constData();
+        return false;
+    }
+    // Original file: find the last cross-reference section.
+    QFile fileIn( m_filename );
+    if( m_podofoDocument->GetEncrypted() || !fileIn.open( QIODevice::ReadOnly ) ) {
+        QLOG_WARN() << QString( "<PRDocument> Incremental update not possible for \"%1\": full writing." )
+                       .arg( QFileInfo( m_filename ).fileName() ).toAscii().constData();
+        return false;
+    }
+    qint64 sizeIn = fileIn.size();
+    fileIn.seek( std::max( sizeIn - 1024, qint64( 0 ) ) );
+    QByteArray tail = fileIn.readAll();
+    int idxStartXRef = tail.lastIndexOf( "startxref" );
+    qint64 prevXRef = -1;
+    if( idxStartXRef >= 0 ) {
+        prevXRef = tail.mid( idxStartXRef + 9 ).trimmed().split( '\n' ).first().trimmed().toLongLong();
+        fileIn.seek( prevXRef );
+    }
+    // Cross-reference streams: a classic section can not be appended.
+    if( prevXRef <= 0 || !fileIn.read( 4 ).startsWith( "xref" ) ) {
+        QLOG_WARN() << QString( "<PRDocument> Incremental update not possible for \"%1\" (no cross-reference table): full writing." )
+                       .arg( QFileInfo( m_filename ).fileName() ).toAscii().constData();
+        return false;
+    }
+    fileIn.close();
+
+    try
+    {
+        // Log information.
+        QLOG_INFO() << QString( "<PRDocument> Begin writing PoDoFo document update \"%1\"." )
+                       .arg( QFileInfo( fileOut ).fileName() )
+                       .toAscii().constData();
+
+        // Write modified objects.
+        std::map<PdfReference, PdfObject*> objects = this->modifiedObjects();
+        std::map<PdfReference, qint64> offsets;
+        PdfRefCountedBuffer buffer;
+        PdfOutputDevice device( &buffer );
+        device.Print( "\n" );
+        std::map<PdfReference, PdfObject*>::iterator it;
+        pdf_objnum maxObjNum = 0;
+        for( it = objects.begin() ; it != objects.end() ; ++it ) {
+            offsets[ it->first ] = sizeIn + device.Tell();
+            it->second->WriteObject( &device, ePdfWriteMode_Compact, NULL );
+            maxObjNum = std::max( maxObjNum, it->first.ObjectNumber() );
+        }
+        // Cross-reference section: subsections of consecutive objects.
+        qint64 xrefOffset = sizeIn + device.Tell();
+        device.Print( "xref\n" );
+        std::map<PdfReference, qint64>::iterator itOff = offsets.begin();
+        while( itOff != offsets.end() ) {
+            std::map<PdfReference, qint64>::iterator itEnd = itOff;
+            size_t count = 0;
+            do {
+                ++itEnd;
+                ++count;
+            } while( itEnd != offsets.end() &&
+                     itEnd->first.ObjectNumber() == itOff->first.ObjectNumber() + count );
+
+            QByteArray subsection = QString( "%1 %2\n" ).arg( itOff->first.ObjectNumber() )
+                    .arg( count ).toAscii();
+            device.Write( subsection.constData(), subsection.size() );
+            for( ; itOff != itEnd ; ++itOff ) {
+                QByteArray entry = QString( "%1 %2 n\r\n" )
+                        .arg( itOff->second, 10, 10, QChar( '0' ) )
+                        .arg( itOff->first.GenerationNumber(), 5, 10, QChar( '0' ) ).toAscii();
+                device.Write( entry.constData(), entry.size() );
+            }
+        }
+        // Trailer, linked to the previous section.
+        PdfObject trailer( m_podofoDocument->GetTrailer()->GetDictionary() );
+        pdf_int64 sizeObjs = std::max( trailer.GetDictionary().GetKeyAsLong( "Size", 0 ),
+                                       pdf_int64( maxObjNum ) + 1 );
+        trailer.GetDictionary().RemoveKey( "XRefStm" );
+        trailer.GetDictionary().AddKey( "Size", PdfVariant( sizeObjs ) );
+        trailer.GetDictionary().AddKey( "Prev", PdfVariant( pdf_int64( prevXRef ) ) );
+        device.Print( "trailer\n" );
+        trailer.WriteObject( &device, ePdfWriteMode_Compact, NULL );
+        QByteArray startXRef = QString( "\nstartxref\n%1\n%%EOF\n" ).arg( xrefOffset ).toAscii();
+        device.Write( startXRef.constData(), startXRef.size() );
+
+        // Copy of the original file, then append the update.
+        QFile::remove( fileOut );
+        QFile file( fileOut );
+        if( !QFile::copy( m_filename, fileOut ) || !file.open( QIODevice::Append ) ) {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, fileOut.toLocal8Bit().constData() );
+        }
+        file.write( buffer.GetBuffer(), device.GetLength() );
+        file.close();
+
+        // Log information.
+        QLOG_INFO() << QString( "<PRDocument> End writing PoDoFo document update \"%1\" (%2 objects)." )
+                       .arg( QFileInfo( fileOut ).fileName() )
+                       .arg( objects.size() )
+                       .toAscii().constData();
+    }
+    catch( const PoDoFo::PdfError& error )
+    {
+        // Throw exception...
+        PRException errPR( error );
+        errPR.log( QsLogging::ErrorLevel );
+        throw errPR;
+    }
+    return true;
+}
+std::map<PdfReference, PdfObject*> PRDocument::modifiedObjects() const
+{
+    std::map<PdfReference, PdfObject*> objects;
+    PdfVecObjects* pObjects = m_podofoDocument->GetCatalog()->GetOwner();
+
+    // Dirty pages: dictionary, contents and resources (indirect objects).
+    for( size_t i = 0 ; i < m_pPages.size() ; ++i ) {
+        if( !m_pPages[i] || !m_pPages[i]->isDirty() ) {
+            continue;
+        }
+        PdfObject* pPageObj = m_pagesIndex.entry( i ).pobject;
+        objects[ pPageObj->Reference() ] = pPageObj;
+
+        const char* keys[] = { "Contents", "Resources" };
+        for( size_t k = 0 ; k < 2 ; ++k ) {
+            PdfObject* pObj = pPageObj->GetDictionary().GetKey( keys[k] );
+            if( pObj && pObj->IsReference() ) {
+                pObj = pObjects->GetObject( pObj->GetReference() );
+                if( pObj ) {
+                    objects[ pObj->Reference() ] = pObj;
+                }
+            }
+            if( !pObj ) {
+                continue;
+            }
+            // Contents array elements or resources sub-dictionaries.
+            if( pObj->IsArray() ) {
+                const PdfArray& array = pObj->GetArray();
+                for( size_t j = 0 ; j < array.size() ; ++j ) {
+                    if( array[j].IsReference() ) {
+                        PdfObject* pSubObj = pObjects->GetObject( array[j].GetReference() );
+                        if( pSubObj ) {
+                            objects[ pSubObj->Reference() ] = pSubObj;
+                        }
+                    }
+                }
+            }
+            else if( pObj->IsDictionary() && k == 1 ) {
+                const TKeyMap& keyMap = pObj->GetDictionary().GetKeys();
+                for( TCIKeyMap itKey = keyMap.begin() ; itKey != keyMap.end() ; ++itKey ) {
+                    if( itKey->second->IsReference() ) {
+                        PdfObject* pSubObj = pObjects->GetObject( itKey->second->GetReference() );
+                        if( pSubObj ) {
+                            objects[ pSubObj->Reference() ] = pSubObj;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    // Pages tree nodes, if pages were inserted or deleted.
+    if( m_pagesTreeDirty ) {
+        std::vector<PdfObject*> pNodes;
+        pNodes.push_back( m_podofoDocument->GetPagesTree()->GetObject() );
+        while( !pNodes.empty() ) {
+            PdfObject* pNode = pNodes.back();
+            pNodes.pop_back();
+            objects[ pNode->Reference() ] = pNode;
+
+            PdfObject* pKids = pNode->GetIndirectKey( "Kids" );
+            if( pKids && pKids->IsArray() ) {
+                const PdfArray& kids = pKids->GetArray();
+                for( size_t j = 0 ; j < kids.size() ; ++j ) {
+                    PdfObject* pKid = kids[j].IsReference() ?
+                                pObjects->GetObject( kids[j].GetReference() ) : NULL;
+                    if( pKid && pKid->GetDictionary().HasKey( "Kids" ) ) {
+                        pNodes.push_back( pKid );
+                    }
+                }
+            }
+        }
+    }
+    // New objects: not created by the PoDoFo parser.
+    for( TCIVecObjects it = pObjects->begin() ; it != pObjects->end() ; ++it ) {
+        if( !dynamic_cast<PdfParserObject*>( *it ) ) {
+            objects[ (*it)->Reference() ] = *it;
+        }
+    }
+    return objects;
+}
+QString PRDocument::outputFilename( const QString& filename, const QString& suffix ) const
+{
+    QString fileOut = filename;
+    QFileInfo infoOut( fileOut );
+    if( infoOut == QFileInfo( m_filename ) ) {
+        fileOut = infoOut.canonicalPath() + "/"
+                + infoOut.completeBaseName()
+                + QString("%1.pdf").arg( suffix );
+    }
+    return fileOut;
+}
 void PRDocument::freePoDoFoDocument()
 {
     // Get mutex and then free.
     QMutexLocker locker( &m_podofoMutex );
+    m_streamDecoder.clear();
+    this->updateStreamDecoderCache();
+    if( m_podofoDocument ) {
+        PdfeFontEmbedded::releaseFontPrograms( &m_podofoDocument->GetObjects() );
+    }
     delete m_podofoDocument;
     m_podofoDocument = NULL;
+    // Mapped file: after the document, which may still read it.
+    delete m_mappedFile;
+    m_mappedFile = NULL;
     m_filename = QString();
 }
 
@@ -305,9 +666,11 @@ PoDoFoExtended::PdfeFont* PRDocument::fontCache( const PoDoFo::PdfReference& fon
     it = m_fontCache.find( fontRef );
     // If not found, add to cache.
     if( it == m_fontCache.end() ) {
+        PDFE_PROFILE_COUNTER( "fonts.cache.misses", 1 );
         return this->addFontToCache( fontRef );
     }
     else {
+        PDFE_PROFILE_COUNTER( "fonts.cache.hits", 1 );
         return it->second;
     }
 }
@@ -319,9 +682,11 @@ void PRDocument::clearFontCache()
         delete it->second;
         it->second = NULL;
     }
+    m_fontCache.clear();
 }
 PoDoFoExtended::PdfeFont* PRDocument::addFontToCache( const PoDoFo::PdfReference& fontRef )
 {
+    PDFE_PROFILE_SCOPE( "fonts.load" );
     // Get PoDoFo font object.
     PdfObject* pFontObj = m_podofoDocument->GetObjects().GetObject( fontRef );
     PdfeFont* pFont = NULL;
@@ -22,19 +22,45 @@
 #include <QString>
 #include <QMutex>
 
+#include "PdfeContentsCache.h"
+#include "PdfeStreamDecoder.h"
+
+#include "PRCacheManager.h"
+#include "PRPagePrefetcher.h"
+#include "PRPagesIndex.h"
+#include "PRPage.h"
+
 namespace PoDoFo {
     class PdfMemDocument;
+    class PdfObject;
     class PdfReference;
     class PdfRect;
     class PdfPage;
 }
 namespace PoDoFoExtended {
     class PdfeFont;
+    class PdfeMappedFile;
 }
 
 namespace PdfRecut {
 
-class PRPage;
+namespace PRDocumentSaveMode {
+/** Saving modes of a PDF document.
+ */
+enum Enum {
+    Full = 0,       /// Complete rewriting of the document (default).
+    Incremental     /// Original file with modified objects appended (incremental update).
+};
+}
+namespace PRDocumentLoadMode {
+/** Loading modes of a PDF document.
+ */
+enum Enum {
+    Memory = 0,     /// File read in memory (default).
+    Lazy            /// Memory-mapped file, objects loaded on demand.
+};
+}
+
 //************************************************************//
 //                         PRDocument                         //
 //************************************************************//
@@ -46,12 +72,18 @@ class PRPage;
  * unknown consequences might appear (Sarah Palin, Black holes,
  * Communism... who knows !)
  *
- * It owns a mutex for the access to this object.
+ * It owns a (recursive) mutex for the access to this object.
+ *
+ * PRPage objects are created on first access (lazy page table) and
+ * notify the document of cache events through PRPageListener.
  */
-class PRDocument : public QObject
+class PRDocument : public QObject, public PRPageListener
 {
     Q_OBJECT
 
+    friend class PRPage;
+    friend class PRPagePrefetcher;
+
 public:
     /** Default constructor: initialize parent QObject.
      * \param parent Parent QObject.
@@ -64,13 +96,21 @@ public:
 public:
     /** Load a PoDoFo document at a given filename.
      * \param filename Path the document to load.
+     * \param mode Loading mode. In lazy mode, the file is memory-mapped
+     * and PoDoFo objects are only parsed when accessed.
      */
-    void load( const QString& filename );
+    void load( const QString& filename,
+               PRDocumentLoadMode::Enum mode = PRDocumentLoadMode::Memory );
     /** Save the document in at a given place.
      * \param filename Path where to save the document. Modified if equal to
      * the member filename (to avoid PoDoFo writing issues).
+     * \param mode Saving mode. An incremental update only appends objects of
+     * modified pages (and new objects) to a copy of the original file. Falls
+     * back to a full rewriting if the original file does not allow it
+     * (encryption, cross-reference streams).
      */
-    void save( const QString& filename );
+    void save( const QString& filename,
+               PRDocumentSaveMode::Enum mode = PRDocumentSaveMode::Full );
     /** Clear the document (free PoDoFo memory and internal objects).
      */
     void clear();
@@ -97,26 +137,96 @@ public:
 
     /// Number of pages in the document.
     size_t nbPages() const          {   return m_pPages.size();     }
-    /// Get a page (pointer to the object).
-    PRPage* page( size_t idx )              {   return m_pPages.at( idx );  }
-    const PRPage* page( size_t idx ) const  {   return m_pPages.at( idx );  }
-    /// Set page contents cache size (minimum: 10).
-    void setPagesCacheSize( size_t cacheSize );
+    /// Get a page (pointer to the object). Created on first access.
+    PRPage* page( size_t idx );
+    const PRPage* page( size_t idx ) const;
+    /// Flat index of PoDoFo pages (objects and inherited attributes).
+    PRPagesIndex* pagesIndex()              {   return &m_pagesIndex;   }
+    const PRPagesIndex* pagesIndex() const  {   return &m_pagesIndex;   }
+    /** Rebuild the index of PoDoFo pages. To call after modifications of the
+     * pages tree made directly on the PoDoFo document (or its cache cleared).
+     * Existing PRPage objects are kept and reloaded from the new PoDoFo pages
+     * (cached contents dropped, not saved), as geometry pages refer to them;
+     * pages beyond the new count are detached. The document is marked as
+     * modified outside of PRPage objects (c.f. notifyPoDoFoModified).
+     */
+    void updatePagesIndex();
+    /** Notify modifications made directly on the PoDoFo document (pages tree,
+     * catalog, outlines, annotations, streams,...), which are not tracked by
+     * PRPage objects. Incremental saving then falls back to a full writing,
+     * and contents loaded in advance are discarded.
+     */
+    void notifyPoDoFoModified();
+    /// Cache manager shared by pages contents and geometry data.
+    PRCacheManager* cacheManager()              {   return &m_cacheManager;     }
+    const PRCacheManager* cacheManager() const  {   return &m_cacheManager;     }
+    /** Set directory of the on-disk contents cache.
+     * \param cacheDir Cache directory (empty: disabled, default).
+     * \param maxSize Maximum size of the directory, in bytes (0: unlimited).
+     */
+    void setContentsCacheDirectory( const QString& cacheDir, qint64 maxSize = 0 );
+    /// On-disk cache of parsed pages contents streams.
+    const PoDoFoExtended::PdfeContentsCache& contentsCache() const  {   return m_contentsCache;   }
+    /// Set the number of upcoming pages whose streams are decoded in advance (0: disabled).
+    void setPrefetchDepth( size_t depth )   {   m_prefetchDepth = depth;    }
+    /// Number of upcoming pages whose streams are decoded in advance.
+    size_t prefetchDepth() const            {   return m_prefetchDepth;     }
+    /** Schedule the decoding of the contents streams of a page and
+     * of the upcoming ones (c.f. prefetchDepth), which are not yet cached.
+     * \param pageIndex Index of the page.
+     */
+    void prefetchPagesContents( size_t pageIndex );
+    /// Decoder of contents streams used to load pages.
+    PoDoFoExtended::PdfeStreamDecoder* streamDecoder()  {   return &m_streamDecoder;    }
+    /// Prefetcher of pages contents, on sequential accesses.
+    PRPagePrefetcher* pagePrefetcher()  {   return &m_pagePrefetcher;   }
 
 private:
-    /// Load pages from the PoDoFo document.
+    /// Allocate the pages table (pages are created on first access).
     void loadPages();
+    /** Create and load a page from the PoDoFo document.
+     * \param index Index of the page.
+     */
+    void loadPage( size_t index );
+    /** Rebuild the pages index and reload existing pages from it.
+     * PRPage objects are kept: pages beyond the new count are detached.
+     */
+    void reloadPages();
     /// Clear the vector of pages.
     void clearPages();
     /// Set pages index.
     void setPagesIndex();
     /** Attach a page to the document, i.e. set parent
-     * and connect signals/slots.
+     * and listener.
      * \param index Index of the page.
      */
     void attachPage( size_t index );
+    /** Update the memory held by the stream decoder in the cache manager.
+     */
+    void updateStreamDecoderCache();
+
+private:
+    /** Streams decoded in advance, as an entry of the cache manager:
+     * they are discarded on eviction.
+     */
+    class StreamDecoderClient : public PRCacheManager::Client
+    {
+    public:
+        StreamDecoderClient( PoDoFoExtended::PdfeStreamDecoder* pdecoder ) :
+            m_pDecoder( pdecoder ) { }
+        virtual size_t cacheFootprint() const   {   return m_pDecoder->nbBytes();   }
+        virtual void cacheRelease()             {   m_pDecoder->clear();    }
+    private:
+        /// Stream decoder.
+        PoDoFoExtended::PdfeStreamDecoder*  m_pDecoder;
+    };
+
+private:
+    // PRPageListener interface.
+    virtual void pageContentsCached( size_t pageIndex );
+    virtual void pageContentsUncached( size_t pageIndex );
+    virtual void pageModified( size_t pageIndex, bool incContents, bool incAttributes );
 
-private slots:
     // Page contents cache.
     /** Cache a page of the document.
      * \param pageIndex Index of the page to cache.
@@ -126,11 +236,10 @@ private slots:
      * \param pageIndex Index of the page to uncache.
      */
     void uncachePageContents( size_t pageIndex );
-private:
-    /** Clean page cache. i.e. uncached pages until
-     * the cache size is respected.
+    /** Mark the contents of a page as recently used (cache hit).
+     * \param pageIndex Index of the page.
      */
-    void cleanCachePages();
+    void touchPageContents( size_t pageIndex );
 
 public:
     // Font cache related member functions.
@@ -155,6 +264,8 @@ public:
     bool isDocumentLoaded() const   {   return ( m_podofoDocument != NULL );    }
     /// Get PoDoFo document pointer.
     PoDoFo::PdfMemDocument* podofoDocument() const {    return m_podofoDocument;    }
+    /// Loading mode of the document.
+    PRDocumentLoadMode::Enum loadMode() const   {   return m_loadMode;  }
     /// Get PoDoFo document mutex.
     QMutex* podofoMutex()       {   return &m_podofoMutex;  }
     /// Get filename of the PDF document.
@@ -179,15 +290,37 @@ private:
     /** (Re)Load PoDoFo document from the defined filename. Need PoDoFo mutex.
      * Throw an exception if an error occured during the loading operation.
      * \param filename Filename of the PDF document to load.
+     * \param mode Loading mode (lazy: memory-mapped file, objects parsed on demand).
      * \return Pointer to a PdfMemDocument object if loaded correctly.
      */
-    PoDoFo::PdfMemDocument* loadPoDoFoDocument( const QString& filename );
+    PoDoFo::PdfMemDocument* loadPoDoFoDocument( const QString& filename,
+                                                PRDocumentLoadMode::Enum mode );
     /** Write PoDoFo document to a file.  Need PoDoFo mutex.
      * \param filename Filename of the output Pdf document. Modified if equal to
      * the member filename (to avoid PoDoFo writing issues).
      * \param suffix Suffix used to modified the filename, if necessary.
      */
     void writePoDoFoDocument( const QString& filename, const QString& suffix );
+    /** Write an incremental update of the PoDoFo document: copy of the
+     * original file followed by modified objects, a cross-reference section
+     * and a trailer. Not possible if the document has been modified outside
+     * of PRPage objects (c.f. notifyPoDoFoModified). Need PoDoFo mutex.
+     * \param filename Filename of the output Pdf document. Modified if equal to
+     * the member filename.
+     * \param suffix Suffix used to modified the filename, if necessary.
+     * \return False if an incremental update is not possible for the original file.
+     */
+    bool writePoDoFoUpdate( const QString& filename, const QString& suffix );
+    /** Get the objects modified since loading: dirty pages (dictionaries, contents
+     * and resources), pages tree if modified and new objects.
+     * \return Map of objects, ordered by references.
+     */
+    std::map<PoDoFo::PdfReference, PoDoFo::PdfObject*> modifiedObjects() const;
+    /** Output filename: modified if equal to the member filename.
+     * \param filename Filename of the output Pdf document.
+     * \param suffix Suffix used to modified the filename, if necessary.
+     */
+    QString outputFilename( const QString& filename, const QString& suffix ) const;
     /** Free PoDoFo document. Need PoDoFo mutex to free memory.
      * Reset the filename to empty.
      */
@@ -204,13 +337,33 @@ private:
     PoDoFo::PdfMemDocument*  m_podofoDocument;
     /// PoDoFo document mutex.
     QMutex  m_podofoMutex;
+    /// Loading mode.
+    PRDocumentLoadMode::Enum  m_loadMode;
+    /// Memory-mapped input file (lazy mode).
+    PoDoFoExtended::PdfeMappedFile*  m_mappedFile;
 
-    /// Pages vector.
+    /// Pages vector (NULL for pages not yet accessed).
     std::vector<PRPage*>  m_pPages;
-    /// Pages cache list.
-    std::list<size_t>  m_pagesCacheList;
-    /// Pages cache size (default: infinity).
-    size_t  m_pagesCacheSize;
+    /// Pages detached by a re-index, deleted when the document is cleared.
+    std::vector<PRPage*>  m_pDetachedPages;
+    /// Index of PoDoFo pages.
+    PRPagesIndex  m_pagesIndex;
+    /// Pages tree modified since loading (insertion, deletion)?
+    bool  m_pagesTreeDirty;
+    /// PoDoFo document modified outside of PRPage objects since loading?
+    bool  m_podofoModified;
+    /// Cache manager (pages contents, geometry data).
+    PRCacheManager  m_cacheManager;
+    /// On-disk cache of parsed contents streams.
+    PoDoFoExtended::PdfeContentsCache  m_contentsCache;
+    /// Decoder of contents streams (prefetching pipeline).
+    PoDoFoExtended::PdfeStreamDecoder  m_streamDecoder;
+    /// Entry of the stream decoder in the cache manager.
+    StreamDecoderClient  m_streamDecoderClient;
+    /// Number of upcoming pages prefetched (default: 2).
+    size_t  m_prefetchDepth;
+    /// Prefetcher of pages contents (background loading).
+    PRPagePrefetcher  m_pagePrefetcher;
 
     /// Map containing font cache. Each key corresponds to the reference of the font object.
     std::map< PoDoFo::PdfReference, PoDoFoExtended::PdfeFont* >  m_fontCache;
@@ -13,6 +13,9 @@
 #include "PRDocument.h"
 #include "PRException.h"
 #include "PRStreamLayoutZone.h"
+#include "PRGeometry/PRGPage.h"
+
+#include "PdfeProfiler.h"
 
 #include <podofo/podofo.h>
 #include <QtCore>
@@ -36,13 +39,17 @@ std::string PRDocumentLayout::zoneSuffixe( "_ZS" );
 //                      Public methods                      //
 //**********************************************************//
 PRDocumentLayout::PRDocumentLayout( QObject* parent ) :
-    QObject( parent ), m_abortOperation( false ), m_pageLayouts()
+    QObject( parent ), m_abortOperation( false ), m_pData( new Data() )
 {
 }
 
 void PRDocumentLayout::init()
 {
-    m_pageLayouts.clear();
+    QMutexLocker locker( &m_dataMutex );
+    // New data: snapshots in use are not modified.
+    boost::shared_ptr<Data> pdata( new Data() );
+    pdata->parameters = m_pData->parameters;
+    m_pData = pdata;
     m_abortOperation = false;
 }
 
@@ -50,80 +57,117 @@ void PRDocumentLayout::addPages( int nbPages )
 {
     if( nbPages > 0 )
     {
-        // Write Locker semaphore needed.
-        PdfeSemaphoreWriteLocker writeLocker( &m_semaphore );
-
-        // Add pages and set index.
-        size_t oldSize = m_pageLayouts.size();
-        m_pageLayouts.resize( oldSize + nbPages );
-        for( size_t i = oldSize ; i < m_pageLayouts.size() ; i++ )
-            m_pageLayouts[i].indexOut = i;
+        QMutexLocker locker( &m_dataMutex );
+        Data* pdata = this->editData();
+        resizePages( pdata->pageLayouts, pdata->pageLayouts.size() + nbPages );
     }
 }
 
 void PRDocumentLayout::addPageZone( int pageIndexOut, const PRPageZone& zoneIn )
 {
-    // Resize the vector of pages (if necessary).
-    this->addPages( pageIndexOut+1 - m_pageLayouts.size() );
+    QMutexLocker locker( &m_dataMutex );
+    Data* pdata = this->editData();
 
-    // Write Locker semaphore needed.
-    PdfeSemaphoreWriteLocker writeLocker( &m_semaphore );
+    // Resize the vector of pages (if necessary).
+    resizePages( pdata->pageLayouts, pageIndexOut+1 );
 
     // Add zone to page.
-    m_pageLayouts[pageIndexOut].zonesIn.push_back(zoneIn);
-    m_pageLayouts[pageIndexOut].zonesIn.back().parent = & (m_pageLayouts[pageIndexOut] );
+    PRPageLayout& pageLayout = pdata->pageLayouts[pageIndexOut];
+    pageLayout.zonesIn.push_back(zoneIn);
+    pageLayout.zonesIn.back().parent = &pageLayout;
 }
 
 void PRDocumentLayout::setPageBoxes( int pageIndexOut,
                                       const PoDoFo::PdfRect& mediaBox,
                                       const PoDoFo::PdfRect& cropBox )
 {
-    // Resize the vector of pages (if necessary).
-    this->addPages( pageIndexOut+1 - m_pageLayouts.size() );
+    QMutexLocker locker( &m_dataMutex );
+    Data* pdata = this->editData();
 
-    // Write Locker semaphore needed.
-    PdfeSemaphoreWriteLocker writeLocker( &m_semaphore );
+    // Resize the vector of pages (if necessary).
+    resizePages( pdata->pageLayouts, pageIndexOut+1 );
 
     // Set media box.
-    m_pageLayouts[pageIndexOut].mediaBox = mediaBox;
+    PRPageLayout& pageLayout = pdata->pageLayouts[pageIndexOut];
+    pageLayout.mediaBox = mediaBox;
 
     // Set crop box (and check it is smaller than mediabox...)
     if( cropBox.GetWidth() > mediaBox.GetWidth() || cropBox.GetHeight() > mediaBox.GetHeight() ) {
-        m_pageLayouts[pageIndexOut].cropBox = mediaBox;
+        pageLayout.cropBox = mediaBox;
     }
     else {
-        m_pageLayouts[pageIndexOut].cropBox = cropBox;
+        pageLayout.cropBox = cropBox;
+    }
+}
+
+void PRDocumentLayout::initSplitPages( const PRDocument* documentHandle,
+                                        double margin,
+                                        size_t nbPages )
+{
+    // Boxes read from the pages index: no pages tree traversal.
+    const PRPagesIndex* pIndex = documentHandle->pagesIndex();
+    if( !nbPages || nbPages > pIndex->size() ) {
+        nbPages = pIndex->size();
+    }
+    this->init();
+    for( size_t i = 0 ; i < nbPages ; ++i ) {
+        PdfRect mediaBox = pIndex->entry( i ).mediaBox;
+        PdfRect pageBox = PRGPage::PageCropBox( pIndex->entry( i ) );
+        double delta = std::min( margin, pageBox.GetWidth() / 4 );
+
+        // Top half, then bottom half.
+        PRPageZone zone;
+        zone.indexIn = int( i );
+        zone.leftZoneOut = pageBox.GetLeft() + delta;
+        zone.bottomZoneOut = pageBox.GetBottom() + pageBox.GetHeight()/4;
+        zone.zoneIn = PdfRect( pageBox.GetLeft() + delta,
+                               pageBox.GetBottom() + pageBox.GetHeight()/2,
+                               pageBox.GetWidth() - 2*delta,
+                               pageBox.GetHeight()/2 - delta );
+        this->setPageBoxes( 2*i, mediaBox, pageBox );
+        this->addPageZone( 2*i, zone );
+
+        zone.zoneIn = PdfRect( pageBox.GetLeft() + delta,
+                               pageBox.GetBottom() + delta,
+                               pageBox.GetWidth() - 2*delta,
+                               pageBox.GetHeight()/2 - delta );
+        this->setPageBoxes( 2*i+1, mediaBox, pageBox );
+        this->addPageZone( 2*i+1, zone );
     }
 }
 
 PoDoFo::PdfRect PRDocumentLayout::getPageMediaBox( int pageIndexOut ) const
 {
-    if( pageIndexOut >= int(m_pageLayouts.size()) )
+    Snapshot layout = this->snapshot();
+    if( pageIndexOut >= int(layout->pageLayouts.size()) )
         PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
-    return m_pageLayouts[pageIndexOut].mediaBox;
+    return layout->pageLayouts[pageIndexOut].mediaBox;
 }
 
 PoDoFo::PdfRect PRDocumentLayout::getPageCropBox( int pageIndexOut ) const
 {
-    if( pageIndexOut >= int(m_pageLayouts.size()) )
+    Snapshot layout = this->snapshot();
+    if( pageIndexOut >= int(layout->pageLayouts.size()) )
         PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
-    return m_pageLayouts[pageIndexOut].cropBox;
+    return layout->pageLayouts[pageIndexOut].cropBox;
 }
 
 void PRDocumentLayout::setLayoutParameters( const PRLayoutParameters& params )
 {
-    // Write Locker semaphore needed.
-    PdfeSemaphoreWriteLocker writeLocker( &m_semaphore );
-
-    m_parameters = params;
+    QMutexLocker locker( &m_dataMutex );
+    this->editData()->parameters = params;
 }
 
 PRLayoutParameters PRDocumentLayout::getLayoutParameters() const
 {
-    // Read Locker semaphore needed.
-    PdfeSemaphoreReadLocker readLocker( const_cast<PdfeClassSemaphore*> (&m_semaphore) );
+    return this->snapshot()->parameters;
+}
 
-    return m_parameters;
+PRDocumentLayout::Snapshot PRDocumentLayout::snapshot() const
+{
+    // Only the pointer copy is protected: snapshots are never modified.
+    QMutexLocker locker( &m_dataMutex );
+    return m_pData;
 }
 
 //************************************************************//
@@ -132,8 +176,8 @@ PRLayoutParameters PRDocumentLayout::getLayoutParameters() const
 void PRDocumentLayout::writeLayoutToPdf( PRDocument* documentHandle,
                                          const QString& filename )
 {
-    // Read Locker semaphore needed.
-    PdfeSemaphoreReadLocker readLocker( &m_semaphore );
+    // Snapshot of the layout: modifications are not blocked during the export.
+    Snapshot layout = this->snapshot();
     try
     {
         // Load PoDoFo document if necessary and obtain mutex on it.
@@ -143,7 +187,7 @@ void PRDocumentLayout::writeLayoutToPdf( PRDocument* documentHandle,
         QMutexLocker pdfLocker( documentHandle->podofoMutex() );
 
         // Transform PoDoFo document.
-        this->transformDocument( documentHandle );
+        this->transformDocument( documentHandle, *layout );
         pdfLocker.unlock();
 
         // Write it to a pdf.
@@ -172,8 +216,8 @@ void PRDocumentLayout::writeLayoutToPdf( PRDocument* documentHandle,
 void PRDocumentLayout::writeOverlayInToPdf( PRDocument* documentHandle,
                                              const QString& filename )
 {
-    // Read Locker semaphore needed.
-    PdfeSemaphoreReadLocker readLocker( &m_semaphore );
+    // Snapshot of the layout: modifications are not blocked during the export.
+    Snapshot layout = this->snapshot();
     try
     {
         // Load PoDoFo document if necessary and obtain mutex on it.
@@ -183,7 +227,7 @@ void PRDocumentLayout::writeOverlayInToPdf( PRDocument* documentHandle,
         QMutexLocker pdfLocker( documentHandle->podofoMutex() );
 
         // Write overlay.
-        this->printLayoutIn( documentHandle );
+        this->printLayoutIn( documentHandle, *layout );
         pdfLocker.unlock();
 
         // Write it to a pdf.
@@ -212,8 +256,8 @@ void PRDocumentLayout::writeOverlayInToPdf( PRDocument* documentHandle,
 void PRDocumentLayout::writeOverlayOutToPdf( PRDocument* documentHandle,
                                               const QString& filename )
 {
-    // Read Locker semaphore needed.
-    PdfeSemaphoreReadLocker readLocker( &m_semaphore );
+    // Snapshot of the layout: modifications are not blocked during the export.
+    Snapshot layout = this->snapshot();
     try
     {
         // Load PoDoFo document if necessary and obtain mutex on it.
@@ -223,7 +267,7 @@ void PRDocumentLayout::writeOverlayOutToPdf( PRDocument* documentHandle,
         QMutexLocker pdfLocker( documentHandle->podofoMutex() );
 
         // Write overlay.
-        this->printLayoutOut( documentHandle );
+        this->printLayoutOut( documentHandle, *layout );
         pdfLocker.unlock();
 
         // Write it to a pdf.
@@ -249,64 +293,100 @@ void PRDocumentLayout::writeOverlayOutToPdf( PRDocument* documentHandle,
     }
 }
 
+void PRDocumentLayout::applyToDocument( PRDocument* documentHandle )
+{
+    Snapshot layout = this->snapshot();
+    QMutexLocker pdfLocker( documentHandle->podofoMutex() );
+    this->transformDocument( documentHandle, *layout );
+}
+
 //*************************************************************//
 //                      Protected methods                      //
 //*************************************************************//
-void PRDocumentLayout::transformDocument( PRDocument* documentHandle ) const
+PRDocumentLayout::Data* PRDocumentLayout::editData()
 {
+    // Copy on write: the data is shared with snapshots in use.
+    if( !m_pData.unique() ) {
+        m_pData.reset( new Data( *m_pData ) );
+    }
+    return m_pData.get();
+}
+void PRDocumentLayout::resizePages( std::vector<PRPageLayout>& pageLayouts, size_t nbPages )
+{
+    // Add pages and set index.
+    size_t oldSize = pageLayouts.size();
+    if( nbPages > oldSize ) {
+        pageLayouts.resize( nbPages );
+        for( size_t i = oldSize ; i < pageLayouts.size() ; i++ )
+            pageLayouts[i].indexOut = i;
+    }
+}
+
+void PRDocumentLayout::transformDocument( PRDocument* documentHandle,
+                                          const Data& layout ) const
+{
+    PDFE_PROFILE_SCOPE( "layout.transform" );
     // Get PoDoFo document.
     PdfMemDocument* document = documentHandle->podofoDocument();
     QString methodTitle = tr( "Reorganize Pdf document." );
 
+    const std::vector<PRPageLayout>& pageLayouts = layout.pageLayouts;
+    const PRLayoutParameters& parameters = layout.parameters;
+
     // Construct vector and map which reference zones for each page in the input document.
     std::vector< std::vector<const PRPageZone*> > vecPageInZones( document->GetPageCount() );
     std::map<PdfReference, std::vector<const PRPageZone*> > mapPageInZones;
-    for(size_t idx = 0 ; idx < m_pageLayouts.size() ; idx++)
+    for(size_t idx = 0 ; idx < pageLayouts.size() ; idx++)
     {
-        for(size_t i = 0 ; i < m_pageLayouts[idx].zonesIn.size() ; i++)
+        for(size_t i = 0 ; i < pageLayouts[idx].zonesIn.size() ; i++)
         {
-            PdfPage* pageIn = document->GetPage( m_pageLayouts[idx].zonesIn[i].indexIn );
-            mapPageInZones[ pageIn->GetObject()->Reference() ].push_back( &m_pageLayouts[idx].zonesIn[i] );
-            vecPageInZones[ m_pageLayouts[idx].zonesIn[i].indexIn ].push_back( &m_pageLayouts[idx].zonesIn[i] );
+            const PRPagesIndex::Entry& pageIn = documentHandle->pagesIndex()->entry( pageLayouts[idx].zonesIn[i].indexIn );
+            mapPageInZones[ pageIn.reference ].push_back( &pageLayouts[idx].zonesIn[i] );
+            vecPageInZones[ pageLayouts[idx].zonesIn[i].indexIn ].push_back( &pageLayouts[idx].zonesIn[i] );
         }
     }
     int origPagesNb = document->GetPageCount();
+    PRPagesIndex* pagesIndex = documentHandle->pagesIndex();
 
     // Form objects.
     std::vector<PoDoFo::PdfObject*> formObjects;
 
     // Local variables.
     int indexIn;
-    PdfPage* pageIn;
     PdfPage* pageOut;
     PdfObject* streamObj;
     PdfVariant pagebox;
 
     // Pages loop construction.
     emit methodProgress( methodTitle, 0.0 );
-    for(size_t idx = 0 ; idx < m_pageLayouts.size() ; idx++)
+    for(size_t idx = 0 ; idx < pageLayouts.size() ; idx++)
     {
         // Create an empty page in the document.
-        pageOut = document->CreatePage( m_pageLayouts[idx].mediaBox );
+        pageOut = document->CreatePage( pageLayouts[idx].mediaBox );
+        {
+            // Output pages indexed, after the original ones.
+            QMutexLocker locker( documentHandle->podofoMutex() );
+            pagesIndex->insert( origPagesNb+idx, pageOut->GetObject() );
+        }
 
         // Resources associated to the page.
         PdfeResources resourcesOut( pageOut->GetResources() );
         //resourcesOut.push_back( pageOut->GetResources() );
 
         // Set cropbox.
-        m_pageLayouts[idx].cropBox.ToVariant( pagebox );
+        pageLayouts[idx].cropBox.ToVariant( pagebox );
         pageOut->GetObject()->GetDictionary().AddKey( "CropBox", pagebox );
 
         // Set page rotation.
         pageOut->GetObject()->GetDictionary().AddKey( "Rotate",
-                                                      pdf_int64(m_parameters.pagesRotation) );
+                                                      pdf_int64(parameters.pagesRotation) );
 
         // Add contents array to the page.
         pageOut->GetObject()->GetDictionary().AddKey( "Contents", PdfArray() );
         PdfArray& streamsArray = pageOut->GetObject()->GetDictionary().GetKey( "Contents" )->GetArray();
 
         // Zones loop analysis.
-        for(size_t i = 0 ; i < m_pageLayouts[idx].zonesIn.size() ; i++)
+        for(size_t i = 0 ; i < pageLayouts[idx].zonesIn.size() ; i++)
         {
             // Abort operation.
             if( m_abortOperation ) {
@@ -322,8 +402,7 @@ void PRDocumentLayout::transformDocument( PRDocument* documentHandle ) const
             streamsArray.push_back( streamRef );
 
             // Get input page used in this zone.
-            indexIn = m_pageLayouts[idx].zonesIn[i].indexIn;
-            pageIn = document->GetPage( indexIn );
+            indexIn = pageLayouts[idx].zonesIn[i].indexIn;
 
             try
             {
@@ -336,11 +415,11 @@ void PRDocumentLayout::transformDocument( PRDocument* documentHandle ) const
                 std::string suffixeStr = suffixe.str();
 
                 // Obtain stream which corresponds to zone.
-                PRStreamLayoutZone streamLayout( pageIn,
+                PRStreamLayoutZone streamLayout( documentHandle->page( indexIn ),
                                                  streamObj->GetStream(),
                                                  &resourcesOut,
-                                                 m_pageLayouts[idx].zonesIn[i],
-                                                 m_parameters,
+                                                 pageLayouts[idx].zonesIn[i],
+                                                 parameters,
                                                  suffixeStr );
                 streamLayout.generateStream();
 
@@ -358,15 +437,15 @@ void PRDocumentLayout::transformDocument( PRDocument* documentHandle ) const
                 streamsArray.erase( streamsArray.end()-1 );
             }
         }
-        emit methodProgress( methodTitle, double(idx+1) / double(m_pageLayouts.size()) );
+        emit methodProgress( methodTitle, double(idx+1) / double(pageLayouts.size()) );
     }
     emit methodProgress( methodTitle, 1.0 );
 
     // Copy document outlines.
-    this->copyOutlines( document, mapPageInZones, origPagesNb );
+    this->copyOutlines( document, pagesIndex, mapPageInZones, origPagesNb );
 
     // Copy pages annotations.
-    this->copyAnnotations( document, mapPageInZones, origPagesNb );
+    this->copyAnnotations( document, pagesIndex, mapPageInZones, origPagesNb );
 
     // Copy page labels.
     this->copyPageLabels( document, vecPageInZones );
@@ -377,21 +456,25 @@ void PRDocumentLayout::transformDocument( PRDocument* documentHandle ) const
     // Delete unused forms.
     this->deleteFormObjects( document, formObjects );
 
-    // Clear pages tree cache.
+    // Clear pages tree cache and rebuild pages index.
     document->GetPagesTree()->ClearCache();
+    documentHandle->updatePagesIndex();
 
     // If wanted, add zones overlay.
-    if( m_parameters.overlayLayoutZones ) {
-        this->printLayoutOut( documentHandle );
+    if( parameters.overlayLayoutZones ) {
+        this->printLayoutOut( documentHandle, layout );
     }
 }
 
-void PRDocumentLayout::printLayoutIn( PRDocument* documentHandle ) const
+void PRDocumentLayout::printLayoutIn( PRDocument* documentHandle,
+                                      const Data& layout ) const
 {
     // Get PoDoFo document.
     PdfMemDocument* document = documentHandle->podofoDocument();
     QString methodTitle = tr( "Print out layout overlay." );
 
+    const std::vector<PRPageLayout>& pageLayouts = layout.pageLayouts;
+
     // Watermark parameters.
     PdfColor fillColor( 0.0, 0.0, 1.0 );
     PdfColor strokeColor( 0.0, 0.0, 0.8 );
@@ -417,20 +500,23 @@ void PRDocumentLayout::printLayoutIn( PRDocument* documentHandle ) const
 
     // Print page zones...
     emit methodProgress( methodTitle, 0.0 );
-    for(size_t idx = 0 ; idx < m_pageLayouts.size() ; idx++)
+    for(size_t idx = 0 ; idx < pageLayouts.size() ; idx++)
     {
         streamIdx.str("");
         streamIdx << (idx+1);
 
-        for(size_t i = 0 ; i < m_pageLayouts[idx].zonesIn.size() ; i++)
+        for(size_t i = 0 ; i < pageLayouts[idx].zonesIn.size() ; i++)
         {
             // Abort operation.
             if( m_abortOperation ) {
                 throw PRException( PRExceptionCode::PRAbort, methodTitle );
             }
 
-            const PRPageZone& zone = m_pageLayouts[idx].zonesIn[i];
-            pPage = document->GetPage( zone.indexIn );
+            const PRPageZone& zone = pageLayouts[idx].zonesIn[i];
+            pPage = documentHandle->pagesIndex()->page( zone.indexIn );
+            if( !pPage ) {
+                continue;
+            }
 
             // Set painter
             painter.SetPage( pPage );
@@ -453,17 +539,22 @@ void PRDocumentLayout::printLayoutIn( PRDocument* documentHandle ) const
             painter.Restore();
             painter.FinishPage();
         }
-        emit methodProgress( methodTitle, double(idx+1)/double(m_pageLayouts.size()) );
+        emit methodProgress( methodTitle, double(idx+1)/double(pageLayouts.size()) );
     }
     emit methodProgress( methodTitle, 1.0 );
+    // Contents modified directly on PoDoFo pages.
+    documentHandle->notifyPoDoFoModified();
 }
 
-void PRDocumentLayout::printLayoutOut( PRDocument* documentHandle ) const
+void PRDocumentLayout::printLayoutOut( PRDocument* documentHandle,
+                                       const Data& layout ) const
 {
     // Get PoDoFo document.
     PdfMemDocument* document = documentHandle->podofoDocument();
     QString methodTitle = tr( "Print in layout overlay." );
 
+    const std::vector<PRPageLayout>& pageLayouts = layout.pageLayouts;
+
     // Watermark parameters
     PdfColor fillColor( 0.0, 0.0, 1.0 );
     PdfColor strokeColor( 0.0, 0.0, 0.8 );
@@ -487,18 +578,18 @@ void PRDocumentLayout::printLayoutOut( PRDocument* documentHandle ) const
 
     // Print pages of the output document
     emit methodProgress( methodTitle, 0.0 );
-    for(size_t idx = 0 ; idx < m_pageLayouts.size() ; idx++)
+    for(size_t idx = 0 ; idx < pageLayouts.size() ; idx++)
     {
         // Create page if necessary
         if( document->GetPageCount() <= int(idx) )
-            pPage = document->CreatePage( m_pageLayouts[idx].mediaBox );
+            pPage = document->CreatePage( pageLayouts[idx].mediaBox );
         else
             pPage = document->GetPage( idx );
 
         // Reset mediabox and cropbox
-        m_pageLayouts[idx].mediaBox.ToVariant( pagebox );
+        pageLayouts[idx].mediaBox.ToVariant( pagebox );
         pPage->GetResources()->GetDictionary().AddKey( "MediaBox", pagebox );
-        m_pageLayouts[idx].cropBox.ToVariant( pagebox );
+        pageLayouts[idx].cropBox.ToVariant( pagebox );
         pPage->GetResources()->GetDictionary().AddKey( "CropBox", pagebox );
 
         // Set painter
@@ -514,14 +605,14 @@ void PRDocumentLayout::printLayoutOut( PRDocument* documentHandle ) const
         painter.SetFont( pFont );
 
         // Print different zones in the page
-        for(size_t i = 0 ; i < m_pageLayouts[idx].zonesIn.size() ; i++)
+        for(size_t i = 0 ; i < pageLayouts[idx].zonesIn.size() ; i++)
         {
             // Abort operation.
             if( m_abortOperation ) {
                 throw PRException( PRExceptionCode::PRAbort, methodTitle );
             }
 
-            const PRPageZone& zone = m_pageLayouts[idx].zonesIn[i];
+            const PRPageZone& zone = pageLayouts[idx].zonesIn[i];
             streamIdx.str("");
             streamIdx << (zone.indexIn + 1);
 
@@ -539,9 +630,11 @@ void PRDocumentLayout::printLayoutOut( PRDocument* documentHandle ) const
         }
         painter.Restore();
         painter.FinishPage();
-        emit methodProgress( methodTitle, double(idx+1)/double(m_pageLayouts.size()) );
+        emit methodProgress( methodTitle, double(idx+1)/double(pageLayouts.size()) );
     }
     emit methodProgress( methodTitle, 1.0 );
+    // Pages may have been created: rebuild pages index.
+    documentHandle->updatePagesIndex();
 }
 
 void PRDocumentLayout::copyPageRessources( PoDoFo::PdfPage* pageOut,
@@ -680,6 +773,7 @@ void PRDocumentLayout::deleteFormObjects( PoDoFo::PdfMemDocument* document,
 }
 
 void PRDocumentLayout::copyOutlines( PoDoFo::PdfMemDocument* document,
+                                      PRPagesIndex* pagesIndex,
                                       std::map<PdfReference, std::vector<const PRPageZone*> > &mapPageInZones,
                                       int origPagesNb ) const
 {
@@ -689,11 +783,12 @@ void PRDocumentLayout::copyOutlines( PoDoFo::PdfMemDocument* document,
     {
         PdfOutlineItem* item = docOutlines->First();
         if( item )
-            this->copyOutlineItem( document, item, mapPageInZones, origPagesNb );
+            this->copyOutlineItem( document, pagesIndex, item, mapPageInZones, origPagesNb );
     }
 }
 
 void PRDocumentLayout::copyOutlineItem( PoDoFo::PdfMemDocument* document,
+                                    PRPagesIndex* pagesIndex,
                                     PoDoFo::PdfOutlineItem* item,
                                     std::map<PdfReference, std::vector<const PRPageZone*> > &mapPageInZones,
                                     int origPagesNb ) const
@@ -711,9 +806,9 @@ void PRDocumentLayout::copyOutlineItem( PoDoFo::PdfMemDocument* document,
     {
         // Apply modification to destination if possible, or action else if.
         if( dest )
-            this->copyDestination( document, dest->GetObject(), mapPageInZones, origPagesNb );
+            this->copyDestination( document, pagesIndex, dest->GetObject(), mapPageInZones, origPagesNb );
         else if( action )
-            this->copyAction( document, action->GetObject(), mapPageInZones, origPagesNb );
+            this->copyAction( document, pagesIndex, action->GetObject(), mapPageInZones, origPagesNb );
     }
     catch( const PdfError& error )
     {
@@ -725,12 +820,13 @@ void PRDocumentLayout::copyOutlineItem( PoDoFo::PdfMemDocument* document,
 
     // Apply to first and next.
     if( item->First() )
-        this->copyOutlineItem( document, item->First(), mapPageInZones, origPagesNb );
+        this->copyOutlineItem( document, pagesIndex, item->First(), mapPageInZones, origPagesNb );
     if( item->Next() )
-        this->copyOutlineItem( document, item->Next(), mapPageInZones, origPagesNb );
+        this->copyOutlineItem( document, pagesIndex, item->Next(), mapPageInZones, origPagesNb );
 }
 
 void PRDocumentLayout::copyAction( PoDoFo::PdfMemDocument* document,
+                                    PRPagesIndex* pagesIndex,
                                     PoDoFo::PdfObject* action,
                                     std::map<PdfReference, std::vector<const PRPageZone*> > &mapPageInZones,
                                     int origPagesNb ) const
@@ -746,7 +842,7 @@ void PRDocumentLayout::copyAction( PoDoFo::PdfMemDocument* document,
     if( !actionType.compare( "GoTo" ) )
     {
         PdfObject* dest = action->GetIndirectKey( "D" );
-        this->copyDestination( document, dest, mapPageInZones, origPagesNb );
+        this->copyDestination( document, pagesIndex, dest, mapPageInZones, origPagesNb );
     }
 
     // Next action.
@@ -755,17 +851,18 @@ void PRDocumentLayout::copyAction( PoDoFo::PdfMemDocument* document,
     {
         // Type: dictionary (single action) or array of actions.
         if( nextAction->GetDataType() == ePdfDataType_Dictionary ) {
-            this->copyAction( document, nextAction, mapPageInZones, origPagesNb );
+            this->copyAction( document, pagesIndex, nextAction, mapPageInZones, origPagesNb );
         }
         else if( nextAction->GetDataType() == ePdfDataType_Array ) {
             PdfArray& actionArray = nextAction->GetArray();
             for(size_t i = 0 ; i < actionArray.size() ; i++)
-                this->copyAction( document, &actionArray[i], mapPageInZones, origPagesNb );
+                this->copyAction( document, pagesIndex, &actionArray[i], mapPageInZones, origPagesNb );
         }
     }
 }
 
 void PRDocumentLayout::copyDestination( PoDoFo::PdfMemDocument* document,
+                                    PRPagesIndex* pagesIndex,
                                     PoDoFo::PdfObject* destination,
                                     std::map<PdfReference, std::vector<const PRPageZone*> > &mapPageInZones,
                                     int origPagesNb ) const
@@ -841,7 +938,7 @@ void PRDocumentLayout::copyDestination( PoDoFo::PdfMemDocument* document,
         }
 
         // Set output page
-        PdfPage* pageOut = document->GetPage( pageInZones[idxZone]->parent->indexOut+origPagesNb );
+        PdfPage* pageOut = pagesIndex->page( pageInZones[idxZone]->parent->indexOut+origPagesNb );
         (*destArray)[0] = pageOut->GetObject()->Reference();
 
         // In the case of FitR, also update other coordinates
@@ -879,7 +976,7 @@ void PRDocumentLayout::copyDestination( PoDoFo::PdfMemDocument* document,
     {
         // Can not guess much -> set destination to first page zone
         idxZone = 0;
-        PdfPage* pageOut = document->GetPage( pageInZones[idxZone]->parent->indexOut+origPagesNb );
+        PdfPage* pageOut = pagesIndex->page( pageInZones[idxZone]->parent->indexOut+origPagesNb );
         (*destArray)[idxZone] = pageOut->GetObject()->Reference();
 
         // In the case of FitV or FitBV, update left coordinate
@@ -895,6 +992,7 @@ void PRDocumentLayout::copyDestination( PoDoFo::PdfMemDocument* document,
 }
 
 void PRDocumentLayout::copyAnnotations( PdfMemDocument* document,
+                                    PRPagesIndex* pagesIndex,
                                     std::map<PdfReference, std::vector<const PRPageZone*> > &mapPageInZones,
                                     int origPagesNb ) const
 {
@@ -904,19 +1002,23 @@ void PRDocumentLayout::copyAnnotations( PdfMemDocument* document,
     emit methodProgress( methodTitle, 0.0 );
     for( int i = 0 ; i < origPagesNb ; i++ )
     {
-        this->copyPageAnnotations( document, i, mapPageInZones, origPagesNb );
+        this->copyPageAnnotations( document, pagesIndex, i, mapPageInZones, origPagesNb );
         emit methodProgress( methodTitle, double(i+1)/double(origPagesNb) );
     }
     emit methodProgress( methodTitle, 1.0 );
 }
 
 void PRDocumentLayout::copyPageAnnotations( PdfMemDocument* document,
+                                    PRPagesIndex* pagesIndex,
                                     int idxPageIn,
                                     std::map<PdfReference, std::vector<const PRPageZone*> > &mapPageInZones,
                                     int origPagesNb ) const
 {
     // Page pointer and page zones
-    PdfPage* pageIn = document->GetPage( idxPageIn );
+    PdfPage* pageIn = pagesIndex->page( idxPageIn );
+    if( !pageIn ) {
+        return;
+    }
     std::vector<const PRPageZone*>& pageInZones = mapPageInZones[ pageIn->GetObject()->Reference() ];
     std::vector<PdfeVector> vecAnnPoints;
     int idxZone;
@@ -966,8 +1068,8 @@ void PRDocumentLayout::copyPageAnnotations( PdfMemDocument* document,
                                                           annRectV );
 
             // Add annotation to page out
-            PdfPage* pageOut = document->GetPage( pageInZones[idxZone]->parent->indexOut
-                                                  + origPagesNb );
+            PdfPage* pageOut = pagesIndex->page( pageInZones[idxZone]->parent->indexOut
+                                                 + origPagesNb );
 
             if ( !pageOut->GetObject()->GetDictionary().HasKey( "Annots" ) ) {
                 // Create the annotations array
@@ -981,10 +1083,10 @@ void PRDocumentLayout::copyPageAnnotations( PdfMemDocument* document,
                 // Modify annotation destination and action
                 PdfObject* action = pageAnn->GetObject()->GetIndirectKey( "A" );
                 if( action )
-                    this->copyAction( document, action, mapPageInZones, origPagesNb );
+                    this->copyAction( document, pagesIndex, action, mapPageInZones, origPagesNb );
                 PdfObject* dest = pageAnn->GetObject()->GetIndirectKey( "Dest" );
                 if( dest )
-                    this->copyDestination( document, dest, mapPageInZones, origPagesNb );
+                    this->copyDestination( document, pagesIndex, dest, mapPageInZones, origPagesNb );
             }
             catch( const PdfError& error )
             {
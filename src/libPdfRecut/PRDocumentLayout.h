@@ -13,11 +13,13 @@
 #define PRDOCUMENTLAYOUT_H
 
 #include <QtCore/QObject>
+#include <QtCore/QMutex>
+
+#include <boost/shared_ptr.hpp>
 
 #include <podofo/base/PdfRect.h>
 
 #include "PdfeTypes.h"
-#include "PdfeSemaphore.h"
 //#include "PRDocument.h"
 #include "PdfeMisc.h"
 
@@ -36,6 +38,7 @@ namespace PdfRecut {
 
 class PRDocument;
 class PRPageLayout;
+class PRPagesIndex;
 
 /** Pdf zone in the input document to be inserted in an output page.
  */
@@ -166,12 +169,28 @@ struct PRLayoutParameters
 };
 
 /** A class which describes a new layout for a PdfMemDocument.
- * This class is thread-safe ( Hope so ! ).
+ * This class is thread-safe: layout data are published as immutable
+ * snapshots. Readers (exports,...) work on the snapshot taken when they
+ * start, and modifications are made on a copy when a snapshot is in use
+ * (copy on write). Long exports thus never block modifications.
  */
 class PRDocumentLayout : public QObject
 {
     Q_OBJECT
 
+public:
+    /** Data of a layout: page layouts and parameters.
+     */
+    struct Data
+    {
+        /// Page layouts of the redesigned document.
+        std::vector<PRPageLayout>  pageLayouts;
+        /// Parameters used when a document is reorganized.
+        PRLayoutParameters  parameters;
+    };
+    /// Immutable snapshot of the layout data.
+    typedef boost::shared_ptr<const Data>  Snapshot;
+
 public:
     /** Default constructor.
      */
@@ -182,20 +201,17 @@ public:
     void init();
 
     /** Add pages to the document layout.
-     * Need write access on the class.
      * \param nbPages Number of pages to add.
      */
     void addPages( int nbPages );
 
     /** Add a page zone to the document layout.
-     * Need write access on the class.
      * \param pageIndexOut Index of the page into the zone is inserted.
      * \param zoneIn Zone to insert in the new document.
      */
     void addPageZone( int pageIndexOut, const PRPageZone& zoneIn );
 
     /** Set page mediaBox and cropBox.
-     * Need write access on the class.
      * \param pageIndexOut Index of the page to modify.
      * \param mediaBox Media box of the page.
      * \param cropBox Crop box of the page.
@@ -204,28 +220,34 @@ public:
                        const PoDoFo::PdfRect& mediaBox,
                        const PoDoFo::PdfRect& cropBox );
 
+    /** Initialize the layout to split the pages of a document: each page is
+     * cut in two zones (top and bottom halves), each one on an output page.
+     * \param documentHandle Input document.
+     * \param margin Margin removed around zones (at most a quarter of the page width).
+     * \param nbPages Number of pages to split (0: every page of the document).
+     */
+    void initSplitPages( const PRDocument* documentHandle,
+                         double margin = 20.0,
+                         size_t nbPages = 0 );
+
     /** Get page media box.
-     * Need read access on the class.
      * \param pageIndexOut Index of the page.
      * \return Media box.
      */
     PoDoFo::PdfRect getPageMediaBox( int pageIndexOut ) const;
 
     /** Get page crop box.
-     * Need read access on the class.
      * \param pageIndexOut Index of the page.
      * \return Crop box.
      */
     PoDoFo::PdfRect getPageCropBox( int pageIndexOut ) const;
 
     /** Set layout parameters used when a document is reorganized
-     * Need write access on the class.
      * \param params Layout parameters.
      */
     void setLayoutParameters( const PRLayoutParameters& params );
 
     /** transformDocumenters used when a document is reorganized
-     * Need read access on the class.
      * \return Layout parameters.
      */
     PRLayoutParameters getLayoutParameters() const;
@@ -250,7 +272,6 @@ signals:
 public slots:
 
     /** Write a Pdf document with the layout defined in the class.
-     * Need read access on the class.
      * Need the PoDoFo mutex on the PdfDocumentHandle object.
      * \param documentHandle Document on which to apply the layout.
      * \param filename File where to save the resulting Pdf.
@@ -260,7 +281,6 @@ public slots:
 
     /** Write a Pdf document with an overlay of the layout corresponding to the
      * input document.
-     * Need read access on the class.
      * Need the PoDoFo mutex on the PdfDocumentHandle object.
      * \param documentHandle Input document on which to print the layout.
      * \param filename File where to save the resulting Pdf.
@@ -270,7 +290,6 @@ public slots:
 
     /** Write a Pdf document with an overlay of the layout corresponding to the
      * output document.
-     * Need read access on the class.
      * Need the PoDoFo mutex on the PdfDocumentHandle object.
      * \param documentHandle Output document on which to print the layout.
      * \param filename File where to save the resulting Pdf.
@@ -284,30 +303,55 @@ public:
      */
     void setAbortOperation( bool abort = true );
 
+    /** Snapshot of the layout data. Never modified: it can be used
+     * without lock while the layout is being edited.
+     */
+    Snapshot snapshot() const;
+
+    /** Reorganize a document according to the layout, without writing it
+     * (c.f. writeLayoutToPdf). PoDoFo mutex is taken.
+     * \param documentHandle Document to modify.
+     */
+    void applyToDocument( PRDocument* documentHandle );
+
 protected:
-    // Note that mutex/semaphore are not locked in protected functions as
+    // Note that the PoDoFo mutex is not locked in protected functions as
     // we assume it has been done in public callers.
 
+    /** Data to modify. Copied if shared with snapshots in use.
+     * Need the data mutex.
+     */
+    Data* editData();
+
+    /** Resize a vector of page layouts (never shrunk) and set page indexes.
+     * \param pageLayouts Page layouts to resize.
+     * \param nbPages Minimal number of pages.
+     */
+    static void resizePages( std::vector<PRPageLayout>& pageLayouts, size_t nbPages );
+
     /** Reorganize a PdfDocument according to the layout defined in this class.
-     * Need read access on the class.
      * Need the PoDoFo mutex on the PdfDocumentHandle object.
      * \param documentHandle Object containing the PoDoFo document to modify.
+     * \param layout Snapshot of the layout data to use.
      */
-    void transformDocument( PRDocument* documentHandle ) const;
+    void transformDocument( PRDocument* documentHandle,
+                            const Data& layout ) const;
 
     /** Print the layout on the input document.
-     * Need read access on the class.
      * Need the PoDoFo mutex on the PdfDocumentHandle object.
      * \param documentHandle Document on which to print the layout.
+     * \param layout Snapshot of the layout data to use.
      */
-    void printLayoutIn( PRDocument* documentHandle ) const;
+    void printLayoutIn( PRDocument* documentHandle,
+                        const Data& layout ) const;
 
     /** Print the layout of the output document.
-     * Need read access on the class.
      * Need the PoDoFo mutex on the PdfDocumentHandle object.
      * \param documentHandle Document on which to print the layout.
+     * \param layout Snapshot of the layout data to use.
      */
-    void printLayoutOut( PRDocument* documentHandle ) const;
+    void printLayoutOut( PRDocument* documentHandle,
+                         const Data& layout ) const;
 
     /** Copy ressources from a page and add a prefix based on zone index.
      * \param pageOut Output page where resources are copied.
@@ -346,62 +390,74 @@ protected:
 
     /** Copy and modify outlines in a document to fit the new layout.
      * \param document Document to modify.
+     * \param pagesIndex Index of the document pages (including output pages).
      * \param mapPageInZones Pages / Zones map.
      * \param origPagesNb Number of pages in the original document.
      */
     void copyOutlines( PoDoFo::PdfMemDocument* document,
+                       PRPagesIndex* pagesIndex,
                        std::map< PoDoFo::PdfReference, std::vector<const PRPageZone*> >& mapPageInZones,
                        int origPagesNb ) const;
 
     /** Copy and modify and outline item in a document to fit the new layout.
      * \param document Document to modify.
+     * \param pagesIndex Index of the document pages (including output pages).
      * \param item Item to modify.
      * \param mapPageInZones Pages / Zones map.
      * \param origPagesNb Number of pages in the original document.
      */
     void copyOutlineItem( PoDoFo::PdfMemDocument* document,
+                          PRPagesIndex* pagesIndex,
                           PoDoFo::PdfOutlineItem* item,
                           std::map< PoDoFo::PdfReference, std::vector<const PRPageZone*> >& mapPageInZones,
                           int origPagesNb ) const;
 
     /** Copy and modify an action in a document to fit the new layout.
      * \param document Document to modify.
+     * \param pagesIndex Index of the document pages (including output pages).
      * \param action Action to modify.
      * \param mapPageInZones Pages / Zones map.
      * \param origPagesNb Number of pages in the original document.
      */
     void copyAction( PoDoFo::PdfMemDocument* document,
+                     PRPagesIndex* pagesIndex,
                      PoDoFo::PdfObject* action,
                      std::map< PoDoFo::PdfReference, std::vector<const PRPageZone*> >& mapPageInZones,
                      int origPagesNb ) const;
 
     /** Copy and modify an action in a document to fit the new layout.
      * \param document Document to modify.
+     * \param pagesIndex Index of the document pages (including output pages).
      * \param destination Destination to modify.
      * \param mapPageInZones Pages / Zones map.
      * \param origPagesNb Number of pages in the original document.
      */
     void copyDestination( PoDoFo::PdfMemDocument* document,
+                          PRPagesIndex* pagesIndex,
                           PoDoFo::PdfObject* destination,
                           std::map< PoDoFo::PdfReference, std::vector<const PRPageZone*> >& mapPageInZones,
                           int origPagesNb ) const;
 
     /** Copy and modify annotations in a document to fit the new layout.
      * \param document Document to modify.
+     * \param pagesIndex Index of the document pages (including output pages).
      * \param mapPageInZones Pages / Zones map.
      * \param origPagesNb Number of pages in the original document.
      */
     void copyAnnotations( PoDoFo::PdfMemDocument* document,
+                          PRPagesIndex* pagesIndex,
                           std::map< PoDoFo::PdfReference, std::vector<const PRPageZone*> >& mapPageInZones,
                           int origPagesNb ) const;
 
     /** Copy and modify annotations in a page to fit the new layout.
      * \param document Document to modify.
+     * \param pagesIndex Index of the document pages (including output pages).
      * \param idxPageIn Page where to consider annotations.
      * \param mapPageInZones Pages / Zones map.
      * \param origPagesNb Number of pages in the original document.
      */
     void copyPageAnnotations( PoDoFo::PdfMemDocument* document,
+                              PRPagesIndex* pagesIndex,
                               int idxPageIn,
                               std::map< PoDoFo::PdfReference, std::vector<const PRPageZone*> >& mapPageInZones,
                               int origPagesNb ) const;
@@ -461,17 +517,14 @@ protected:
      */
     bool m_abortOperation;
 
-    /** Internal semaphore used to protect data and multithread access.
-     */
-    PdfeClassSemaphore m_semaphore;
-
-    /** Vector of page layouts for the redesigned document.
+    /** Mutex protecting the data pointer (swap, copy and copy on write).
+     * Never held during long operations.
      */
-    std::vector<PRPageLayout> m_pageLayouts;
+    mutable QMutex m_dataMutex;
 
-    /** Parameters used when a document is reorganized.
+    /** Current layout data (shared with snapshots in use).
      */
-    PRLayoutParameters m_parameters;
+    boost::shared_ptr<Data> m_pData;
 
     /** Prefix used when import zones.
      */
@@ -45,7 +45,10 @@ void PRDocumentTools::addGraphicStateStack( PRDocument* documentHandle )
     // Modify stream content in every page
     for(int idx = 0 ; idx < document->GetPageCount() ; idx++)
     {
-        page = document->GetPage( idx );
+        page = documentHandle->pagesIndex()->page( idx );
+        if( !page ) {
+            continue;
+        }
         contents = page->GetContents();
 
         // Dictionary: replace the reference by an array
@@ -68,8 +71,9 @@ void PRDocumentTools::addGraphicStateStack( PRDocument* documentHandle )
             arrayCont.insert( arrayCont.end(), QRef );
         }
     }
-    // Clear page tree cache
+    // Clear page tree cache (and pages index, which refers to cached pages).
     document->GetPagesTree()->ClearCache();
+    documentHandle->updatePagesIndex();
 }
 
 void PRDocumentTools::uncompressStreams( PRDocument* documentHandle )
@@ -90,6 +94,7 @@ void PRDocumentTools::uncompressStreams( PRDocument* documentHandle )
         }
         ++it;
     }
+    documentHandle->notifyPoDoFoModified();
 }
 
 }
@@ -12,6 +12,7 @@
 #include "PRGDocument.h"
 
 #include "PRDocument.h"
+#include "PRPage.h"
 #include "PRGSubDocument.h"
 #include "PRGPage.h"
 
@@ -32,8 +33,7 @@ namespace PdfRecut {
 //                         PRGDocument                         //
 //************************************************************//
 PRGDocument::PRGDocument( PRDocument* parent, double subDocumentTol ) :
-    QObject( parent ),
-    m_cachePagesSize( 10 )
+    QObject( parent )
 {
     // Create sub-documents.
     this->createSubDocuments( subDocumentTol );
@@ -64,33 +64,22 @@ void PRGDocument::analyse( const PRGDocument::GParameters& params )
 
 void PRGDocument::cacheAddPage( PRGPage* gpage )
 {
-    // Is the page already in the cache?
-    std::list<PRGPage*>::iterator it;
-    it = std::find( m_cachePages.begin(), m_cachePages.end(), gpage );
-    if( it == m_cachePages.end() ) {
-        // Push to front and remove back if necessary.
-        m_cachePages.push_front( gpage );
-        if( m_cachePages.size() > m_cachePagesSize ) {
-            this->cacheRmPage( m_cachePages.back() );
-        }
+    // Geometry data depends on the page contents.
+    PRCacheManager* pmanager = this->parent()->cacheManager();
+    if( !pmanager->contains( gpage ) ) {
         QLOG_INFO() << QString( "<PRGDocument> Cache page data (index: %1)." )
                        .arg( gpage->page()->pageIndex() )
                        .toAscii().constData();
     }
-    else {
-        // Move the page to the front.
-        m_cachePages.erase( it );
-        m_cachePages.push_front( gpage );
-    }
+    pmanager->insert( gpage, PRCacheKind::Geometry, gpage->page() );
 }
 void PRGDocument::cacheRmPage( PRGPage* gpage )
 {
     // Remove the page from the cache and clear its data.
-    std::list<PRGPage*>::iterator it;
-    it = std::find( m_cachePages.begin(), m_cachePages.end(), gpage );
-    if( it != m_cachePages.end() ) {
-        (*it)->clearData();
-        m_cachePages.erase( it );
+    PRCacheManager* pmanager = this->parent()->cacheManager();
+    if( pmanager->contains( gpage ) ) {
+        pmanager->remove( gpage );
+        gpage->clearData();
 //        QLOG_INFO() << QString( "<PRGDocument> Uncache page data (index: %1)." )
 //                       .arg( page->pageIndex() )
 //                       .toAscii().constData();
@@ -99,24 +88,24 @@ void PRGDocument::cacheRmPage( PRGPage* gpage )
 
 void PRGDocument::createSubDocuments( double tolerance )
 {
-    // PoDoFo document.
-    PdfMemDocument* pDocument = this->parent()->podofoDocument();
+    // Index of PoDoFo pages.
+    const PRPagesIndex* pIndex = this->parent()->pagesIndex();
 
-    long idx( 0 );
-    long idxFirst;
+    size_t idx( 0 );
+    size_t idxFirst;
     PdfRect cbox;
     PdfRect cboxst;
 
-    while( idx < pDocument->GetPageCount() ) {
+    while( idx < pIndex->size() ) {
         // Initialize the subdocument with the current page.
         idxFirst = idx;
-        cboxst = PRGPage::PageCropBox( pDocument->GetPage( idxFirst ) );
+        cboxst = PRGPage::PageCropBox( pIndex->entry( idxFirst ) );
         bool belong = true;
         //++idx;
 
-        while( idx < pDocument->GetPageCount() ) {
+        while( idx < pIndex->size() ) {
             // Check the size of the page (width and height).
-            cbox = PRGPage::PageCropBox( pDocument->GetPage( idx ) );
+            cbox = PRGPage::PageCropBox( pIndex->entry( idx ) );
             belong = ( fabs( cboxst.GetWidth() - cbox.GetWidth() ) <= cboxst.GetWidth() * tolerance ) &&
                     ( fabs( cboxst.GetHeight() - cbox.GetHeight() ) <= cboxst.GetHeight() * tolerance );
             if( !belong ) {
@@ -145,7 +134,7 @@ PRDocument* PRGDocument::parent() const
 }
 size_t PRGDocument::nbPages() const
 {
-    return this->parent()->podofoDocument()->GetPageCount();
+    return this->parent()->pagesIndex()->size();
 }
 PRGPage* PRGDocument::page( size_t idx )
 {
@@ -13,7 +13,6 @@
 #define PRGDOCUMENT_H
 
 #include <vector>
-#include <list>
 #include <QObject>
 
 namespace PdfRecut {
@@ -59,7 +58,7 @@ public:
     void analyse( const PRGDocument::GParameters& params );
 
 public slots:
-    // Page cache.
+    // Page cache (registered in the PRDocument cache manager).
     /** Add a page to the cache. The data from the page
      * is assumed to be loaded by the caller.
      * \param page Pointer to the page to add.
@@ -94,12 +93,6 @@ public:
     /// Get a geometry page object.
     PRGPage* page( size_t idx );
     const PRGPage* page( size_t idx ) const;
-    /// Size of the page cache.
-    size_t cachePagesSize() const   {   return m_cachePagesSize;    }
-
-    // and setters.
-    /// Size of the page cache.
-    void setCachePagesSize( size_t size )   {   m_cachePagesSize = size;    }
 
 private:
     // No copy constructor and operator= allowed.
@@ -109,11 +102,6 @@ private:
     // PDF geometrical content.
     /// Vector of sub-documents.
     std::vector<PRGSubDocument*>  m_subDocuments;
-
-    /// Page cache.
-    std::list<PRGPage*>  m_cachePages;
-    /// Size of the page cache (maximum number of elements : 10 by default).
-    size_t  m_cachePagesSize;
 };
 
 //************************************************************//
@@ -75,6 +75,14 @@ void PRGPage::clearData()
         m_textPage->clearData();
     }
 }
+size_t PRGPage::cacheFootprint() const
+{
+    return m_textPage ? m_textPage->memoryFootprint() : 0;
+}
+void PRGPage::cacheRelease()
+{
+    this->clearData();
+}
 
 void PRGPage::analyse( const PRGDocument::GParameters& params )
 {
@@ -100,6 +108,11 @@ PdfRect PRGPage::PageCropBox( PdfPage* pPage )
     cropBox = PdfeRect::intersection( mediaBox, cropBox );
     return cropBox;
 }
+PdfRect PRGPage::PageCropBox( const PRPagesIndex::Entry& entry )
+{
+    // Inherited boxes: no pages tree traversal.
+    return PdfeRect::intersection( entry.mediaBox, entry.cropBox );
+}
 
 PRGSubDocument* PRGPage::parent() const
 {
@@ -16,6 +16,7 @@
 
 #include "PRGDocument.h"
 #include "PRPage.h"
+#include "PRPagesIndex.h"
 #include "PdfeContentsStream.h"
 
 namespace PoDoFo {
@@ -35,7 +36,7 @@ class PRGImagePage;
  * It describes page's basic objects (text, paths and images),
  * and the geometrical relationship between them.
  */
-class PRGPage : public QObject
+class PRGPage : public QObject, public PRCacheManager::Client
 {
     Q_OBJECT
 
@@ -61,6 +62,12 @@ public:
      */
     void clearData();
 
+    // PRCacheManager::Client interface.
+    /// Memory footprint of the page data.
+    virtual size_t cacheFootprint() const;
+    /// Release page data (c.f. clearData).
+    virtual void cacheRelease();
+
 signals:
     /** Qt signal: page stream contents has been loaded!
      * \param page Pointer of the sender page.
@@ -86,6 +93,8 @@ public:
     static PoDoFo::PdfRect PageMediaBox( PoDoFo::PdfPage* pPage );
     /// Get the crop box of a PoDoFo page (check the coherence with media box).
     static PoDoFo::PdfRect PageCropBox( PoDoFo::PdfPage* pPage );
+    /// Get the crop box of an indexed page (check the coherence with media box).
+    static PoDoFo::PdfRect PageCropBox( const PRPagesIndex::Entry& entry );
 
 public:
     // Getters...
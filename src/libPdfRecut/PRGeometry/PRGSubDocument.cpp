@@ -86,9 +86,10 @@ void PRGSubDocument::clear()
 
 void PRGSubDocument::computeMeanCropBox()
 {
+    const PRPagesIndex* pIndex = this->parent()->parent()->pagesIndex();
     double width(0), height(0);
     for( size_t i = 0 ; i < this->nbPages() ; ++i ) {
-        PdfRect cbox = PRGPage::PageCropBox( m_pages[i]->page()->podofoPage() );
+        PdfRect cbox = PRGPage::PageCropBox( pIndex->entry( m_firstPageIndex + i ) );
         width += cbox.GetWidth();
         height += cbox.GetHeight();
     }
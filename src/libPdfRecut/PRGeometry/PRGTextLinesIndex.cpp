@@ -0,0 +1,169 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRGTextLinesIndex.h"
+#include "PRGTextLine.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace PoDoFo;
+using namespace PoDoFoExtended;
+
+namespace PdfRecut {
+
+//**********************************************************//
+//                     PRGTextLinesIndex                    //
+//**********************************************************//
+PRGTextLinesIndex::PRGTextLinesIndex()
+{
+    this->clear();
+}
+void PRGTextLinesIndex::clear()
+{
+    m_entries.clear();
+    m_cells.clear();
+    m_nbCellsX = m_nbCellsY = 0;
+    m_left = m_bottom = 0.0;
+    m_cellWidth = m_cellHeight = 1.0;
+}
+void PRGTextLinesIndex::build( const std::vector<PRGTextLine*>& pLines )
+{
+    this->clear();
+
+    // Bounding boxes of lines and grid extent.
+    std::vector<PdfRect> bboxes( pLines.size() );
+    PdfRect extent;
+    size_t nbLines = 0;
+    for( size_t i = 0 ; i < pLines.size() ; ++i ) {
+        if( pLines[i] ) {
+            bboxes[i] = lineBBox( pLines[i] );
+            extent = nbLines ? PdfeRect::reunion( extent, bboxes[i] ) : bboxes[i];
+            ++nbLines;
+        }
+    }
+    if( !nbLines ) {
+        return;
+    }
+    // Grid of about one line per cell.
+    const size_t MaxCellsAxis = 128;
+    size_t nbCellsAxis = std::min( MaxCellsAxis,
+                                   size_t( std::ceil( std::sqrt( double( nbLines ) ) ) ) );
+    m_nbCellsX = m_nbCellsY = std::max( nbCellsAxis, size_t( 1 ) );
+    m_left = extent.GetLeft();
+    m_bottom = extent.GetBottom();
+    m_cellWidth = std::max( extent.GetWidth() / m_nbCellsX, 1e-3 );
+    m_cellHeight = std::max( extent.GetHeight() / m_nbCellsY, 1e-3 );
+    m_cells.resize( m_nbCellsX * m_nbCellsY );
+
+    // Insert lines.
+    for( size_t i = 0 ; i < pLines.size() ; ++i ) {
+        if( pLines[i] ) {
+            Entry entry;
+            entry.slot = i;
+            this->cellsRange( bboxes[i], entry );
+            this->insertCells( pLines[i], entry );
+            m_entries[ pLines[i] ] = entry;
+        }
+    }
+}
+
+void PRGTextLinesIndex::update( PRGTextLine* pLine )
+{
+    std::map<PRGTextLine*,Entry>::iterator it = m_entries.find( pLine );
+    if( it == m_entries.end() ) {
+        return;
+    }
+    Entry entry = it->second;
+    this->cellsRange( lineBBox( pLine ), entry );
+    if( entry.firstX != it->second.firstX || entry.firstY != it->second.firstY ||
+            entry.lastX != it->second.lastX || entry.lastY != it->second.lastY ) {
+        this->removeCells( pLine, it->second );
+        this->insertCells( pLine, entry );
+        it->second = entry;
+    }
+}
+void PRGTextLinesIndex::remove( PRGTextLine* pLine )
+{
+    std::map<PRGTextLine*,Entry>::iterator it = m_entries.find( pLine );
+    if( it != m_entries.end() ) {
+        this->removeCells( pLine, it->second );
+        m_entries.erase( it );
+    }
+}
+
+void PRGTextLinesIndex::query( const PdfRect& zone, std::vector<PRGTextLine*>& pLines ) const
+{
+    pLines.clear();
+    if( m_entries.empty() ) {
+        return;
+    }
+    Entry range;
+    this->cellsRange( zone, range );
+    for( size_t j = range.firstY ; j <= range.lastY ; ++j ) {
+        for( size_t i = range.firstX ; i <= range.lastX ; ++i ) {
+            const std::vector<PRGTextLine*>& cell = m_cells[ j * m_nbCellsX + i ];
+            pLines.insert( pLines.end(), cell.begin(), cell.end() );
+        }
+    }
+    // Lines covering several cells.
+    std::sort( pLines.begin(), pLines.end() );
+    pLines.erase( std::unique( pLines.begin(), pLines.end() ), pLines.end() );
+}
+
+bool PRGTextLinesIndex::contains( PRGTextLine* pLine ) const
+{
+    return m_entries.find( pLine ) != m_entries.end();
+}
+size_t PRGTextLinesIndex::slot( PRGTextLine* pLine ) const
+{
+    return m_entries.find( pLine )->second.slot;
+}
+
+void PRGTextLinesIndex::cellsRange( const PdfRect& rect, Entry& entry ) const
+{
+    // Cells indexes, clamped to the grid (lines outside are in border cells).
+    double firstX = std::floor( ( rect.GetLeft() - m_left ) / m_cellWidth );
+    double lastX = std::floor( ( rect.GetLeft() + rect.GetWidth() - m_left ) / m_cellWidth );
+    double firstY = std::floor( ( rect.GetBottom() - m_bottom ) / m_cellHeight );
+    double lastY = std::floor( ( rect.GetBottom() + rect.GetHeight() - m_bottom ) / m_cellHeight );
+
+    double maxX = double( m_nbCellsX ) - 1.0;
+    double maxY = double( m_nbCellsY ) - 1.0;
+    entry.firstX = size_t( std::min( std::max( firstX, 0.0 ), maxX ) );
+    entry.lastX = size_t( std::min( std::max( lastX, 0.0 ), maxX ) );
+    entry.firstY = size_t( std::min( std::max( firstY, 0.0 ), maxY ) );
+    entry.lastY = size_t( std::min( std::max( lastY, 0.0 ), maxY ) );
+}
+void PRGTextLinesIndex::insertCells( PRGTextLine* pLine, const Entry& entry )
+{
+    for( size_t j = entry.firstY ; j <= entry.lastY ; ++j ) {
+        for( size_t i = entry.firstX ; i <= entry.lastX ; ++i ) {
+            m_cells[ j * m_nbCellsX + i ].push_back( pLine );
+        }
+    }
+}
+void PRGTextLinesIndex::removeCells( PRGTextLine* pLine, const Entry& entry )
+{
+    for( size_t j = entry.firstY ; j <= entry.lastY ; ++j ) {
+        for( size_t i = entry.firstX ; i <= entry.lastX ; ++i ) {
+            std::vector<PRGTextLine*>& cell = m_cells[ j * m_nbCellsX + i ];
+            cell.erase( std::remove( cell.begin(), cell.end(), pLine ), cell.end() );
+        }
+    }
+}
+PdfRect PRGTextLinesIndex::lineBBox( PRGTextLine* pLine )
+{
+    // Same bounding box as the merging algorithms (no spaces).
+    return pLine->bbox( PRGTextLineCoordinates::Page, false, false ).toPdfRect( true );
+}
+
+}
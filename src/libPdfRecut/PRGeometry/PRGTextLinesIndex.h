@@ -0,0 +1,114 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRGTEXTLINESINDEX_H
+#define PRGTEXTLINESINDEX_H
+
+#include <map>
+#include <vector>
+
+#include <podofo/base/PdfRect.h>
+
+namespace PdfRecut {
+
+class PRGTextLine;
+
+//**********************************************************//
+//                     PRGTextLinesIndex                    //
+//**********************************************************//
+/** Spatial index of the text lines of a page, used when merging lines.
+ * Lines are stored in a uniform grid over their bounding boxes (page
+ * coordinates), so that lines close to a zone are obtained by a range query.
+ * The index also keeps the position (slot) of every line in the page vector
+ * of lines. Bounding boxes are cached: update() must be called when a line
+ * is modified.
+ */
+class PRGTextLinesIndex
+{
+public:
+    /** Construct an empty index.
+     */
+    PRGTextLinesIndex();
+    /** Clear the index.
+     */
+    void clear();
+    /** Build the index of a vector of lines (NULL elements are skipped).
+     * \param pLines Vector of lines. Slots correspond to positions in it.
+     */
+    void build( const std::vector<PRGTextLine*>& pLines );
+
+    /** Update the bounding box of a line (e.g. after a merge).
+     * \param pLine Line to update (must be in the index).
+     */
+    void update( PRGTextLine* pLine );
+    /** Remove a line from the index.
+     * \param pLine Line to remove (must be in the index).
+     */
+    void remove( PRGTextLine* pLine );
+
+    /** Lines whose bounding box intersects a zone. Lines are gathered
+     * by grid cells: the result can contain some lines not intersecting
+     * the zone, but no line intersecting it is missing.
+     * \param zone Zone to consider, in page coordinates.
+     * \param pLines Vector where to store the lines (cleared first).
+     */
+    void query( const PoDoFo::PdfRect& zone, std::vector<PRGTextLine*>& pLines ) const;
+
+public:
+    /// Is the index empty?
+    bool isEmpty() const    {   return m_entries.empty();   }
+    /// Is a line in the index?
+    bool contains( PRGTextLine* pLine ) const;
+    /** Slot of a line, i.e. its position in the vector of lines used to
+     * build the index.
+     * \param pLine Line to consider (must be in the index).
+     */
+    size_t slot( PRGTextLine* pLine ) const;
+
+private:
+    /** Entry of a line in the index.
+     */
+    struct Entry
+    {
+        /// Position in the vector of lines.
+        size_t  slot;
+        /// Range of grid cells covered by the line bounding box.
+        size_t  firstX, firstY, lastX, lastY;
+    };
+    /** Compute the range of cells covered by a rectangle.
+     */
+    void cellsRange( const PoDoFo::PdfRect& rect, Entry& entry ) const;
+    /** Add or remove a line in the cells of an entry.
+     */
+    void insertCells( PRGTextLine* pLine, const Entry& entry );
+    void removeCells( PRGTextLine* pLine, const Entry& entry );
+    /** Bounding box of a line used by the index.
+     */
+    static PoDoFo::PdfRect lineBBox( PRGTextLine* pLine );
+
+private:
+    /// Entries of lines.
+    std::map<PRGTextLine*,Entry>  m_entries;
+    /// Grid cells (row major), with the lines they contain.
+    std::vector< std::vector<PRGTextLine*> >  m_cells;
+    /// Number of cells along each axis.
+    size_t  m_nbCellsX;
+    size_t  m_nbCellsY;
+    /// Grid origin and cells dimensions.
+    double  m_left;
+    double  m_bottom;
+    double  m_cellWidth;
+    double  m_cellHeight;
+};
+
+}
+
+#endif // PRGTEXTLINESINDEX_H
@@ -21,6 +21,7 @@
 #include "PRGTextWords.h"
 
 #include "PdfeUtils.h"
+#include "PdfeProfiler.h"
 
 #include "QsLog/QsLog.h"
 
@@ -39,7 +40,7 @@ namespace PdfRecut {
 
 PRGTextPage::PRGTextPage( PRGPage* page ) :
     QObject( page ),
-    PdfeCanvasAnalysis(),
+    PdfeContentsAnalysis(),
     m_page( page )
 {
     // Clear vectors content.
@@ -56,10 +57,10 @@ PRGTextPage::~PRGTextPage()
 }
 void PRGTextPage::loadData()
 {
-    // Analyse page content.
+    // Analyse page content (cached by the parent document).
     m_nbGroupsStream = 0;
     m_nbGroupsPage = 0;
-    this->analyseContents( m_page->page()->podofoPage(), PdfeGraphicsState(), PdfeResources() );
+    this->analyseContents( m_page->page()->contents() );
     // Send signal.
     emit dataLoaded( this->page() );
 }
@@ -70,6 +71,15 @@ void PRGTextPage::clearData()
         m_pGroupsWords[i]->clearData();
     }
 }
+size_t PRGTextPage::memoryFootprint() const
+{
+    size_t footprint = sizeof( PRGTextPage );
+    for( size_t  i = 0 ; i < m_pGroupsWords.size() ; ++i ) {
+        footprint += m_pGroupsWords[i]->memoryFootprint();
+    }
+    footprint += m_pTextLines.size() * sizeof( PRGTextLine );
+    return footprint;
+}
 void PRGTextPage::clear()
 {
     // Delete groups of words.
@@ -81,10 +91,12 @@ void PRGTextPage::clear()
     // Delete text lines.
     std::for_each( m_pTextLines.begin(), m_pTextLines.end(), delete_ptr_fctor<PRGTextLine>() );
     m_pTextLines.clear();
+    m_linesIndex.clear();
 }
 
 void PRGTextPage::detectLines()
 {
+    PDFE_PROFILE_SCOPE( "text.detectLines" );
     QLOG_INFO() << QString( "<PRGTextPage> Detection of page's text lines (index: %1)." )
                    .arg( m_page->page()->pageIndex() )
                    .toAscii().constData();
@@ -92,6 +104,7 @@ void PRGTextPage::detectLines()
     // Clear existing lines.
     std::for_each( m_pTextLines.begin(), m_pTextLines.end(), delete_ptr_fctor<PRGTextLine>() );
     m_pTextLines.clear();
+    m_linesIndex.clear();
 
     // Create lines based on groups of words.
     // Simple merge between groups is performed.
@@ -100,6 +113,9 @@ void PRGTextPage::detectLines()
     }
     // Sort lines using group index.
     std::sort( m_pTextLines.begin(), m_pTextLines.end(), PRGTextLine::compareGroupIndex );
+    // Spatial index used by merging algorithms: merged lines are only
+    // set to NULL in the vector, and slots give the position of lines.
+    m_linesIndex.build( m_pTextLines );
 
     // Inside enlarge algorithm parameters.
     const double XEnlargeIn = 5.0;
@@ -108,13 +124,15 @@ void PRGTextPage::detectLines()
 
     // Try to merge some lines (inside elements).
     PRGTextLine* pLine;
-    std::vector<PRGTextLine*>::iterator it;
-    for( it = m_pTextLines.begin() ; it != m_pTextLines.end() ; ++it ) {
-        pLine = this->mergeLines_EnlargeInside( *it,
+    for( size_t i = 0 ; i < m_pTextLines.size() ; ++i ) {
+        if( !m_pTextLines[i] ) {
+            continue;
+        }
+        pLine = this->mergeLines_EnlargeInside( m_pTextLines[i],
                                                 XEnlargeIn,
                                                 YEnlargeIn,
                                                 MinLineWidthIn );
-        it = std::find( m_pTextLines.begin(), m_pTextLines.end(), pLine );
+        i = m_linesIndex.slot( pLine );
     }
 
     // Merge with elements outside a line.
@@ -126,21 +144,27 @@ void PRGTextPage::detectLines()
         double yEnlarge = 2.0 * ratio;
         double MaxLineWidthCumul = 15.0 - 11. * ratio;
 
-        for( it = m_pTextLines.begin() ; it != m_pTextLines.end() ; ++it ) {
+        for( size_t i = 0 ; i < m_pTextLines.size() ; ++i ) {
+            if( !m_pTextLines[i] ) {
+                continue;
+            }
             // Try to merge every line.
-            pLine = this->mergeLines_EnlargeOutside( *it,
+            pLine = this->mergeLines_EnlargeOutside( m_pTextLines[i],
                                                      xEnlarge, yEnlarge,
                                                      MaxLineWidthCumul );
-            it = std::find( m_pTextLines.begin(), m_pTextLines.end(), pLine );
-
             // Also merge inside elements in case they appear.
-            pLine = this->mergeLines_EnlargeInside( *it,
+            pLine = this->mergeLines_EnlargeInside( pLine,
                                                     XEnlargeIn,
                                                     YEnlargeIn,
                                                     MinLineWidthIn );
-            it = std::find( m_pTextLines.begin(), m_pTextLines.end(), pLine );
+            i = m_linesIndex.slot( pLine );
         }
     }
+    // Remove merged lines from the vector.
+    m_pTextLines.erase( std::remove( m_pTextLines.begin(), m_pTextLines.end(),
+                                     static_cast<PRGTextLine*>( NULL ) ),
+                        m_pTextLines.end() );
+    m_linesIndex.clear();
 
 
 /*
@@ -298,13 +322,15 @@ PRGTextLine* PRGTextPage::mergeLines_EnlargeInside( PRGTextLine* pBaseLine,
     yEnlarge = std::min( yEnlarge, baseLineOBBox.height() * ScaleYEnlarge );
     PdfRect enlargeBBox = baseLineOBBox.enlarge( xEnlarge, yEnlarge ).toPdfRect();
 
-    // Search with groups in the interval ( lineMinGrpIdx,lineMaxGrpIdx )
-    for( long i = minGrpIdx ; i <= maxGrpIdx ; ++i ) {
-        // Assume the group of words only has one line!
-        PRGTextLine* pLine = m_pGroupsWords[i]->textLines().at( 0 );
+    // Candidate lines: close to the enlarged bbox (page coordinates).
+    std::vector<PRGTextLine*> pLines;
+    m_linesIndex.query( baseTransMat.inverse().map( PdfeORect( enlargeBBox ) ).toPdfRect( true ),
+                        pLines );
 
-        // Line is already merged.
-        if( std::find( pLinesToMerge.begin(), pLinesToMerge.end(), pLine ) != pLinesToMerge.end() ) {
+    // Search lines with groups in the interval ( lineMinGrpIdx,lineMaxGrpIdx )
+    for( size_t i = 0 ; i < pLines.size() ; ++i ) {
+        PRGTextLine* pLine = pLines[i];
+        if( pLine == pBaseLine || !hasGroupIndex( pLine, minGrpIdx, maxGrpIdx ) ) {
             continue;
         }
 
@@ -370,30 +396,34 @@ PRGTextLine* PRGTextPage::mergeLines_EnlargeOutside(PRGTextLine* pBaseLine,
     // Enlarge bounding box used.
     PdfRect enlargeBBox = baseLineOBBox.enlarge( xEnlarge, yEnlarge ).toPdfRect();
 
-    // Search groups before and after the line.
-    for( size_t n = 0 ; n < 2 ; ++n ) {
-        for( long i = searchBounds[n*2] ; i <= searchBounds[n*2+1] ; ++i ) {
-            // Assume the group of words only has one line!
-            PRGTextLine* pLine = m_pGroupsWords[i]->textLines().at( 0 );
-            if( std::find( pLinesToMerge.begin(), pLinesToMerge.end(), pLine ) != pLinesToMerge.end() ) {
-                continue;
-            }
-            // Line bounding box in base coordinates system (check it is not empty).
-            PdfeORect lineOBBox = pLine->bbox( PRGTextLineCoordinates::Page, false, false );
-            lineOBBox = baseTransMat.map( lineOBBox );
-            if( lineOBBox.width() <= 0.0 || lineOBBox.height() <= 0.0 ||
-                    pLine->widthCumulative( PRGTextLineCoordinates::LineDocRescaled, false ) >= maxLineWidthCumul ) {
-                continue;
-            }
-            // Check the angle between the two lines: should be less than ~5°.
-            if( PdfeVector::angle( baseLineOBBox.direction(), lineOBBox.direction() ) > 0.1  ) {
-                continue;
-            }
-            // Check if the line bounding box is inside the enlarge base bbox.
-            PdfRect lineBBox = lineOBBox.toPdfRect();
-            if( PdfeRect::contains( enlargeBBox, lineBBox ) ) {
-                pLinesToMerge.push_back( pLine );
-            }
+    // Candidate lines: close to the enlarged bbox (page coordinates).
+    std::vector<PRGTextLine*> pLines;
+    m_linesIndex.query( baseTransMat.inverse().map( PdfeORect( enlargeBBox ) ).toPdfRect( true ),
+                        pLines );
+
+    // Search lines with groups before and after the line.
+    for( size_t i = 0 ; i < pLines.size() ; ++i ) {
+        PRGTextLine* pLine = pLines[i];
+        if( pLine == pBaseLine ||
+                !( hasGroupIndex( pLine, searchBounds[0], searchBounds[1] ) ||
+                   hasGroupIndex( pLine, searchBounds[2], searchBounds[3] ) ) ) {
+            continue;
+        }
+        // Line bounding box in base coordinates system (check it is not empty).
+        PdfeORect lineOBBox = pLine->bbox( PRGTextLineCoordinates::Page, false, false );
+        lineOBBox = baseTransMat.map( lineOBBox );
+        if( lineOBBox.width() <= 0.0 || lineOBBox.height() <= 0.0 ||
+                pLine->widthCumulative( PRGTextLineCoordinates::LineDocRescaled, false ) >= maxLineWidthCumul ) {
+            continue;
+        }
+        // Check the angle between the two lines: should be less than ~5°.
+        if( PdfeVector::angle( baseLineOBBox.direction(), lineOBBox.direction() ) > 0.1  ) {
+            continue;
+        }
+        // Check if the line bounding box is inside the enlarge base bbox.
+        PdfRect lineBBox = lineOBBox.toPdfRect();
+        if( PdfeRect::contains( enlargeBBox, lineBBox ) ) {
+            pLinesToMerge.push_back( pLine );
         }
     }
     // Sort lines to merge using the indexes of their groups.
@@ -642,7 +672,12 @@ PRGTextLine* PRGTextPage::mergeVectorLines( const std::vector<PRGTextLine*>& pLi
         pLine = pLines[i];
 
         // Merge if and only if the line belongs to the page.
-        it = std::find( m_pTextLines.begin(), m_pTextLines.end(), pLine );
+        if( m_linesIndex.contains( pLine ) ) {
+            it = m_pTextLines.begin() + m_linesIndex.slot( pLine );
+        }
+        else {
+            it = std::find( m_pTextLines.begin(), m_pTextLines.end(), pLine );
+        }
         if( it != m_pTextLines.end() ) {
 
             // Copy the subgroups of words.
@@ -656,15 +691,36 @@ PRGTextLine* PRGTextPage::mergeVectorLines( const std::vector<PRGTextLine*>& pLi
                 subgroup.group()->rmTextLine( pLine );
             }
             // Remove line from the page vector and delete object.
-            m_pTextLines.erase( it );
+            // Indexed lines: slot emptied, to keep other slots valid.
+            if( m_linesIndex.contains( pLine ) ) {
+                m_linesIndex.remove( pLine );
+                *it = NULL;
+            }
+            else {
+                m_pTextLines.erase( it );
+            }
             delete pLine;
         }
     }
+    if( pLines.size() > 1 ) {
+        m_linesIndex.update( pBaseLine );
+    }
     return pBaseLine;
 }
 
-// Reimplement PdfeCanvasAnalysis interface.
-PdfeVector PRGTextPage::fTextShowing( const PdfeStreamStateOld& streamState )
+bool PRGTextPage::hasGroupIndex( PRGTextLine* pLine, long minGrpIdx, long maxGrpIdx )
+{
+    for( size_t i = 0 ; i < pLine->nbSubgroups() ; ++i ) {
+        long grpIdx = pLine->subgroup( i ).group()->groupIndex();
+        if( grpIdx >= minGrpIdx && grpIdx <= maxGrpIdx ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reimplement PdfeContentsAnalysis interface.
+PdfeVector PRGTextPage::fTextShowing( const PdfeStreamState& streamState )
 {
     PRGTextGroupWords* pGroup;
     // Create the group of words.
@@ -13,7 +13,8 @@
 #define PRGTEXTPAGE_H
 
 #include <QObject>
-#include "PdfeCanvasAnalysis.h"
+#include "PdfeContentsAnalysis.h"
+#include "PRGTextLinesIndex.h"
 
 namespace PoDoFo {
 class PdfPage;
@@ -34,7 +35,7 @@ class PRGTextGroupWords;
  * - Groups of words that belong to the page;
  * - Text lines that can be detected.
  */
-class PRGTextPage : public QObject, public PoDoFoExtended::PdfeCanvasAnalysis
+class PRGTextPage : public QObject, public PoDoFoExtended::PdfeContentsAnalysis
 {
     Q_OBJECT
 
@@ -59,6 +60,11 @@ public:
      * using page content stream. Basic skeleton of page organisation is kept in memory.
      */
     void clearData();
+    /** Approximate memory footprint of the text page: groups of words
+     * (with their cached data) and text lines.
+     * \return Size in bytes.
+     */
+    size_t memoryFootprint() const;
 signals:
     /** Qt signal: text page data has been loaded!
      * \param page Pointer to the parent page it belongs to.
@@ -127,37 +133,19 @@ private:
      * \return Pointer to the resulting line.
      */
     PRGTextLine* mergeVectorLines( const std::vector<PRGTextLine*>& pLines );
+    /** Does a line contain a group of words whose index is in a given range?
+     * \param pLine Pointer of the line to consider.
+     * \param minGrpIdx First index of the range.
+     * \param maxGrpIdx Last index of the range.
+     */
+    static bool hasGroupIndex( PRGTextLine* pLine, long minGrpIdx, long maxGrpIdx );
 
 protected:
-    // Reimplement PdfeCanvasAnalysis interface.
-    /** Reimplementation of text showing function of PdfeCanvasAnalysis.
+    // Reimplement PdfeContentsAnalysis interface.
+    /** Reimplementation of text showing function of PdfeContentsAnalysis.
      * Used to read text groups of words information.
      */
-    virtual PdfeVector fTextShowing( const PoDoFoExtended::PdfeStreamStateOld& streamState );
-
-    virtual void fGeneralGState( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fSpecialGState( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fPathConstruction( const PoDoFoExtended::PdfeStreamStateOld& streamState,
-                                    const PoDoFoExtended::PdfePath& currentPath ) { }
-    virtual void fPathPainting( const PoDoFoExtended::PdfeStreamStateOld& streamState,
-                                const PoDoFoExtended::PdfePath& currentPath ) { }
-    virtual void fClippingPath( const PoDoFoExtended::PdfeStreamStateOld& streamState,
-                                const PoDoFoExtended::PdfePath& currentPath ) { }
-    virtual void fTextObjects( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fTextState( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fTextPositioning( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fType3Fonts( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fColor( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fShadingPatterns( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fInlineImages( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fXObjects( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fMarkedContents( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fCompatibility( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fUnknown( const PoDoFoExtended::PdfeStreamStateOld& streamState ) { }
-    virtual void fFormBegin( const PoDoFoExtended::PdfeStreamStateOld& streamState,
-                             PoDoFo::PdfXObject* form ) { }
-    virtual void fFormEnd( const PoDoFoExtended::PdfeStreamStateOld& streamState,
-                           PoDoFo::PdfXObject* form ) { }
+    virtual PdfeVector fTextShowing( const PoDoFoExtended::PdfeStreamState& streamState );
 
 public:
     // Rendering routines.
@@ -201,6 +189,9 @@ private:
     std::vector<PRGTextGroupWords*>  m_pGroupsWords;
     /// Text lines detected inside the page (vector of pointers).
     std::vector<PRGTextLine*>  m_pTextLines;
+    /// Spatial index of text lines, used while merging lines (NULL slots
+    /// in m_pTextLines correspond to merged lines).
+    PRGTextLinesIndex  m_linesIndex;
 };
 
 }
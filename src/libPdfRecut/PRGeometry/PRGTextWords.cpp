@@ -22,7 +22,6 @@
 #include "PRException.h"
 
 #include "PdfeFont.h"
-#include "PdfeCanvasAnalysis.h"
 #include "PdfeContentsAnalysis.h"
 
 #include <podofo/podofo.h>
@@ -133,15 +132,6 @@ PRGTextGroupWords::PRGTextGroupWords( PRDocument* document, const PdfeStreamStat
         this->readData( document, streamState );
     }
 }
-PRGTextGroupWords::PRGTextGroupWords( PRDocument* document, const PdfeStreamStateOld& streamState ) :
-    m_textPage( NULL ), m_data( NULL )
-{
-    // Initialize to empty and read data.
-    this->init();
-    if( streamState.gOperator.category() == PdfeGCategory::TextShowing ) {
-        this->readData( document, streamState );
-    }
-}
 PRGTextGroupWords::PRGTextGroupWords( PRGTextPage* textPage, const PdfeStreamState& streamState ) :
     m_textPage( NULL ), m_data( NULL )
 {
@@ -151,15 +141,6 @@ PRGTextGroupWords::PRGTextGroupWords( PRGTextPage* textPage, const PdfeStreamSta
         this->readData( textPage, streamState );
     }
 }
-PRGTextGroupWords::PRGTextGroupWords( PRGTextPage* textPage, const PdfeStreamStateOld& streamState ) :
-    m_textPage( NULL ), m_data( NULL )
-{
-    // Initialize to empty and read data.
-    this->init();
-    if( streamState.gOperator.category() == PdfeGCategory::TextShowing ) {
-        this->readData( textPage, streamState );
-    }
-}
 PRGTextGroupWords::~PRGTextGroupWords()
 {
     this->clearData();
@@ -203,33 +184,6 @@ void PRGTextGroupWords::readData( PRDocument* document, const PdfeStreamState& s
     // Read group of words.
     this->readPdfVariant( variant, pFont );
 }
-void PRGTextGroupWords::readData( PRDocument* document, const PdfeStreamStateOld& streamState )
-{
-    // Simpler references.
-    const std::vector<std::string>& gOperands = streamState.gOperands;
-    const PdfeGraphicsState& gstate = streamState.gStates.back();
-
-    // Create data structure.
-    this->clearData();
-    m_data = new PRGTextGroupWords::Data();
-
-    // Set transformation matrix and text state.
-    m_data->transMatGS = gstate.transMat();
-    m_data->textState = gstate.textState();
-
-    // Font data.
-    PdfeFont* pFont = document->fontCache( gstate.textState().fontReference() );
-    m_data->pFont = pFont;
-    m_data->fontBBox = pFont->fontBBox();
-    this->computeTransMatrices();
-
-    // Get variant from string.
-    PdfVariant variant;
-    PdfTokenizer tokenizer( gOperands.back().c_str(), gOperands.back().length() );
-    tokenizer.GetNextVariant( variant, NULL );
-    // Read group of words.
-    this->readPdfVariant( variant, pFont );
-}
 
 void PRGTextGroupWords::readData( PRGTextPage* textPage, const PdfeStreamState& streamState )
 {
@@ -238,13 +192,6 @@ void PRGTextGroupWords::readData( PRGTextPage* textPage, const PdfeStreamState&
     PRDocument* document = textPage->page()->gdocument()->parent();
     this->readData( document, streamState );
 }
-void PRGTextGroupWords::readData( PRGTextPage* textPage, const PdfeStreamStateOld& streamState )
-{
-    // Initialize using parent document.
-    m_textPage = textPage;
-    PRDocument* document = textPage->page()->gdocument()->parent();
-    this->readData( document, streamState );
-}
 void PRGTextGroupWords::readPdfVariant( const PdfVariant& variant,
                                         PdfeFont* pFont )
 {
@@ -441,6 +388,17 @@ bool PRGTextGroupWords::isDataLoaded() const
 {
     return m_data;
 }
+size_t PRGTextGroupWords::memoryFootprint() const
+{
+    size_t footprint = sizeof( PRGTextGroupWords ) + m_pTextLines.capacity() * sizeof( PRGTextLine* );
+    if( m_data ) {
+        footprint += sizeof( Data )
+                + m_data->words.capacity() * sizeof( PRGTextWord )
+                + m_data->mainSubgroups.capacity() * sizeof( Subgroup )
+                + m_data->mainSubgroups.size() * ( m_data->words.size() / 8 + 1 );
+    }
+    return footprint;
+}
 
 void PRGTextGroupWords::appendWord( const PRGTextWord& word )
 {
@@ -25,7 +25,6 @@ class PdfVariant;
 
 namespace PoDoFoExtended {
 class PdfeFont;
-class PdfeStreamStateOld;
 class PdfeStreamState;
 }
 
@@ -183,16 +182,12 @@ public:
      */
     PRGTextGroupWords( PRDocument* document,
                        const PoDoFoExtended::PdfeStreamState& streamState );
-    PRGTextGroupWords( PRDocument* document,
-                       const PoDoFoExtended::PdfeStreamStateOld& streamState );
     /** Construct a group of words from a PDF stream state.
      * \param textPage Parent text page object.
      * \param streamState Stream state to consider (must correspond to a text showinG operator).
      */
     PRGTextGroupWords( PRGTextPage* textPage,
                        const PoDoFoExtended::PdfeStreamState& streamState );
-    PRGTextGroupWords( PRGTextPage* textPage,
-                       const PoDoFoExtended::PdfeStreamStateOld& streamState );
     /** Destructor.
      */
     ~PRGTextGroupWords();
@@ -207,16 +202,12 @@ public:
      */
     void readData( PRDocument* document,
                    const PoDoFoExtended::PdfeStreamState& streamState );
-    void readData( PRDocument* document,
-                   const PoDoFoExtended::PdfeStreamStateOld& streamState );
     /** Read data of the group of words from a PDF stream state.
      * \param textPage Parent text page object.
      * \param streamState Stream state to consider (must correspond to a text showinG operator).
      */
     void readData( PRGTextPage* textPage,
                    const PoDoFoExtended::PdfeStreamState& streamState );
-    void readData( PRGTextPage* textPage,
-                   const PoDoFoExtended::PdfeStreamStateOld& streamState );
 private:
     /** Read a group of words from a PdfVariant (appended to the group).
      * \param variant Pdf variant to read (can be string or array).
@@ -252,6 +243,10 @@ public:
     /** Is group data loaded ?
      */
     bool isDataLoaded() const;
+    /** Approximate memory footprint of the group (and its cached data).
+     * \return Size in bytes.
+     */
+    size_t memoryFootprint() const;
 public:
     /** Append a word to the group.,
      * \param word Word to append.
@@ -7,6 +7,7 @@ SOURCES += \
     $$PWD/PRGPage.cpp \
     $$PWD/PRGTextPage.cpp \
     $$PWD/PRGTextLine.cpp \
+    $$PWD/PRGTextLinesIndex.cpp \
     $$PWD/PRGTextWords.cpp \
     $$PWD/PRGTextStatistics.cpp
 
@@ -16,5 +17,6 @@ HEADERS +=\
     $$PWD/PRGPage.h \
     $$PWD/PRGTextPage.h \
     $$PWD/PRGTextLine.h \
+    $$PWD/PRGTextLinesIndex.h \
     $$PWD/PRGTextWords.h \
     $$PWD/PRGTextStatistics.h
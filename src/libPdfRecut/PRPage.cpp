@@ -12,6 +12,8 @@
 #include "PRPage.h"
 #include "PRDocument.h"
 
+#include "PdfeProfiler.h"
+
 #include <podofo/podofo.h>
 
 using namespace PoDoFo;
@@ -23,7 +25,9 @@ PRPage::PRPage( const PdfRect& mediaBox ) :
     QObject( NULL ),
     m_pageIndex( 0 ),
     m_pContentsStream( NULL ),
-    m_ownPageContentsObj( false )
+    m_ownPageContentsObj( false ),
+    m_dirty( false ),
+    m_pListener( NULL )
 {
     this->initAttributes( mediaBox );
 }
@@ -31,7 +35,9 @@ PRPage::PRPage( const PRPage& rhs ) :
     QObject( NULL ),
     m_pageIndex( 0 ),
     m_pContentsStream( NULL ),
-    m_ownPageContentsObj( false )
+    m_ownPageContentsObj( false ),
+    m_dirty( false ),
+    m_pListener( NULL )
 {
     this->copyContents( rhs );
     this->copyAttributes( rhs );
@@ -140,6 +146,10 @@ void PRPage::save( PdfPage* page, bool incContents, bool incAttributes )
         }
     }
     if( page && incContents ) {
+        // Streams decoded in advance are now outdated.
+        if( this->document() ) {
+            this->document()->streamDecoder()->discard( page );
+        }
         this->cleanPoDoFoPageStreams( page );
         // Set page contents and resources.
         this->pContents()->save( page );
@@ -152,8 +162,40 @@ void PRPage::cacheContents() const
     if( !m_pContentsStream ) {
         PdfPage* page = this->podofoPage();
         if( page ) {
-            this->pContents()->load( page, true, true );
-            emit contentsCached( m_pageIndex );
+            PDFE_PROFILE_SCOPE( "page.cacheContents" );
+            // Contents loaded in advance (sequential accesses)?
+            PRDocument* pdocument = this->document();
+            m_pContentsStream = pdocument->pagePrefetcher()->take( m_pageIndex );
+            if( m_pContentsStream ) {
+                PDFE_PROFILE_COUNTER( "page.contents.prefetched", 1 );
+            }
+            else {
+                // Prefetcher workers may use the PoDoFo document.
+                QMutexLocker locker( pdocument->podofoMutex() );
+                // Try the on-disk contents cache first.
+                const PdfeContentsCache& cache = pdocument->contentsCache();
+                if( cache.isEnabled() ) {
+                    QByteArray key = cache.key( page );
+                    if( cache.load( key, *this->pContents(), page->GetObject()->GetOwner() ) ) {
+                        PDFE_PROFILE_COUNTER( "page.contents.diskCacheHits", 1 );
+                        // Streams decoded in advance are not needed.
+                        pdocument->streamDecoder()->discard( page );
+                    }
+                    else {
+                        pdocument->prefetchPagesContents( m_pageIndex );
+                        this->pContents()->load( page, true, true, pdocument->streamDecoder() );
+                        cache.store( key, *m_pContentsStream );
+                    }
+                }
+                else {
+                    // Upcoming pages decoded while this one is parsed.
+                    pdocument->prefetchPagesContents( m_pageIndex );
+                    this->pContents()->load( page, true, true, pdocument->streamDecoder() );
+                }
+            }
+            if( m_pListener ) {
+                m_pListener->pageContentsCached( m_pageIndex );
+            }
         }
     }
 }
@@ -163,19 +205,37 @@ void PRPage::uncacheContents() const
     if( m_pContentsStream && this->podofoPage() ) {
         delete m_pContentsStream;
         m_pContentsStream = NULL;
-        emit contentsUncached( m_pageIndex );
+        if( m_pListener ) {
+            m_pListener->pageContentsUncached( m_pageIndex );
+        }
     }
 }
 bool PRPage::isContentsCached() const
 {
     return m_pContentsStream;
 }
+size_t PRPage::cacheFootprint() const
+{
+    return m_pContentsStream ? m_pContentsStream->memoryFootprint() : 0;
+}
+void PRPage::cacheRelease()
+{
+    this->uncacheContents();
+}
 
 void PRPage::pushModifications( bool incContents, bool incAttributes )
 {
     PoDoFo::PdfPage* page = this->podofoPage();
     if( page ) {
+        // Prefetcher workers may use the PoDoFo page: loading outdated.
+        PRDocument* pdocument = this->document();
+        QMutexLocker locker( pdocument->podofoMutex() );
+        pdocument->pagePrefetcher()->discard( m_pageIndex );
         this->save( page, incContents, incAttributes );
+        m_dirty = true;
+    }
+    if( m_pListener ) {
+        m_pListener->pageModified( m_pageIndex, incContents, incAttributes );
     }
     emit modified( m_pageIndex, incContents, incAttributes );
 }
@@ -218,7 +278,7 @@ PdfPage* PRPage::podofoPage() const
 {
     PRDocument* pdocument = this->document();
     if( pdocument && pdocument->podofoDocument() ) {
-        return pdocument->podofoDocument()->GetPage( m_pageIndex );
+        return pdocument->pagesIndex()->page( m_pageIndex );
     }
     return NULL;
 }
@@ -232,6 +292,9 @@ const PdfeContentsStream& PRPage::contents() const
     if( !this->isContentsCached() ) {
         this->cacheContents();
     }
+    else if( this->document() ) {
+        this->document()->touchPageContents( m_pageIndex );
+    }
     return *this->pContents();
 }
 
@@ -18,6 +18,8 @@
 #include "PdfeContentsStream.h"
 #include "PdfeResources.h"
 
+#include "PRCacheManager.h"
+
 #include <QObject>
 
 namespace PoDoFo {
@@ -30,6 +32,33 @@ namespace PdfRecut {
 
 class PRDocument;
 
+//************************************************************//
+//                       PRPageListener                       //
+//************************************************************//
+/** Interface of an object notified of the cache events and the
+ * modifications of pages (usually the parent PRDocument).
+ * Direct calls: cheaper than per-page signal/slot connections.
+ */
+class PRPageListener
+{
+public:
+    virtual ~PRPageListener() { }
+    /** Page contents has been cached.
+     * \param pageIndex Index of the page.
+     */
+    virtual void pageContentsCached( size_t pageIndex ) = 0;
+    /** Page contents have been uncached (cleared).
+     * \param pageIndex Index of the page.
+     */
+    virtual void pageContentsUncached( size_t pageIndex ) = 0;
+    /** Page has been modified.
+     * \param pageIndex Index of the page.
+     * \param incContents Modifications on contents?
+     * \param incAttributes Modifications on attributes?
+     */
+    virtual void pageModified( size_t pageIndex, bool incContents, bool incAttributes ) = 0;
+};
+
 //************************************************************//
 //                           PRPage                           //
 //************************************************************//
@@ -44,7 +73,7 @@ class PRDocument;
  *    with the PDF content. It is up to a PRDocument to set this link.
  * Page contents stream can be cached/uncached depending on the willing of the user.
  */
-class PRPage : public QObject
+class PRPage : public QObject, public PRCacheManager::Client
 {
     Q_OBJECT
 
@@ -116,8 +145,8 @@ signals:
      * \param incAttributes Attributes loaded?
      */
     void loaded( size_t pageIndex, bool incContents, bool incAttributes );
-    /** Page has been loaded. It is up to a parent document
-     * to synchronised contents when a signal is received.
+    /** Page has been modified. The listener of the page (parent
+     * document) is notified first.
      * \param pageIndex Page index of the present object.
      * \param incContents Modifications on contents?
      * \param incAttributes Modifications on attributes?
@@ -139,15 +168,11 @@ public:
      */
     bool isContentsCached() const;
 
-signals:
-    /** Page contents has been cached.
-     * \param Page index of the present object.
-     */
-    void contentsCached( size_t pageIndex ) const;
-    /** Page contents have been uncached (cleared).
-     * \param Page index of the present object.
-     */
-    void contentsUncached( size_t pageIndex ) const;
+    // PRCacheManager::Client interface.
+    /// Memory footprint of the contents stream cached.
+    virtual size_t cacheFootprint() const;
+    /// Release the contents stream (uncache).
+    virtual void cacheRelease();
 
 private:
     /** Push modifications to a PoDoFo page. Only works when the page is attached
@@ -172,7 +197,11 @@ public:
     PoDoFo::PdfPage* podofoPage() const;
     /// Get page index in a document. Beginning at zero (default: 0).
     size_t pageIndex() const;
+    /// Has the page been modified since the document was loaded?
+    bool isDirty() const    {   return m_dirty;     }
 
+    /// Listener notified of cache events and modifications (NULL if none).
+    PRPageListener* listener() const    {   return m_pListener;     }
     /// Get page contents stream. Cache it from PoDoFo::PdfPage if necessary.
     const PoDoFoExtended::PdfeContentsStream& contents() const;
 
@@ -191,6 +220,8 @@ private:
     PoDoFoExtended::PdfeContentsStream* pContents() const;
     /// Set page index in the document. Take care of not messing up the order!
     void setPageIndex( size_t pageIndex )   {   m_pageIndex = pageIndex;    }
+    /// Set the listener of the page (set by the parent document).
+    void setListener( PRPageListener* plistener )   {   m_pListener = plistener;    }
 
 
 public:
@@ -215,6 +246,10 @@ private:
     mutable PoDoFoExtended::PdfeContentsStream*  m_pContentsStream;
     /// Do we own page stream contents object?
     bool  m_ownPageContentsObj;
+    /// Modifications pushed to the PoDoFo page since loading?
+    bool  m_dirty;
+    /// Listener of cache events and modifications.
+    PRPageListener*  m_pListener;
 
     // Page attributes. At least the important ones.
     /// Media box.
@@ -0,0 +1,194 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRPagePrefetcher.h"
+#include "PRDocument.h"
+#include "PRPage.h"
+
+#include "PdfeContentsCache.h"
+#include "PdfeContentsStream.h"
+
+#include <algorithm>
+
+#include <QtCore>
+#include <QtConcurrentRun>
+#include <podofo/podofo.h>
+
+using namespace PoDoFo;
+using namespace PoDoFoExtended;
+
+namespace PdfRecut {
+
+PRPagePrefetcher::PRPagePrefetcher( PRDocument* pdocument ) :
+    m_pDocument( pdocument ),
+    m_depth( DefaultDepth ),
+    m_pAnalyser( NULL ),
+    m_lastIndex( 0 ),
+    m_nbSequential( 0 )
+{
+}
+PRPagePrefetcher::~PRPagePrefetcher()
+{
+    // Workers use the document: wait for them (not holding the mutex).
+    this->clear();
+    for( size_t i = 0 ; i < m_cancelled.size() ; ++i ) {
+        m_cancelled[i].waitForFinished();
+    }
+}
+
+void PRPagePrefetcher::notifyAccess( size_t pageIndex )
+{
+    // Access pattern: repeated accesses to a page are neutral.
+    if( pageIndex == m_lastIndex + 1 ) {
+        ++m_nbSequential;
+    }
+    else if( pageIndex != m_lastIndex ) {
+        m_nbSequential = 0;
+        this->clear();
+    }
+    m_lastIndex = pageIndex;
+    // Forget cancelled jobs which are finished.
+    std::vector< QFuture<PdfeContentsStream*> > cancelled;
+    for( size_t i = 0 ; i < m_cancelled.size() ; ++i ) {
+        if( !m_cancelled[i].isFinished() ) {
+            cancelled.push_back( m_cancelled[i] );
+        }
+    }
+    m_cancelled.swap( cancelled );
+    if( !m_depth || !m_nbSequential || !m_pDocument->podofoDocument() ) {
+        return;
+    }
+    // PoDoFo pages resolved in this thread. Busy mutex: a worker is
+    // loading, scheduling postponed to the next access.
+    QMutex* pmutex = m_pDocument->podofoMutex();
+    if( !pmutex->tryLock() ) {
+        return;
+    }
+    const std::vector<PRPage*>& pPages = m_pDocument->m_pPages;
+    size_t lastIndex = std::min( pageIndex + this->boundedDepth() + 1, pPages.size() );
+    for( size_t i = pageIndex + 1 ; i < lastIndex ; ++i ) {
+        if( m_pages.count( i ) || ( pPages[i] && pPages[i]->isContentsCached() ) ||
+                !m_pDocument->pagesIndex()->page( i ) ) {
+            continue;
+        }
+        Entry entry;
+        entry.pstate.reset( new State() );
+        entry.future = QtConcurrent::run( &PRPagePrefetcher::load,
+                                          m_pDocument,
+                                          m_pDocument->pagesIndex()->page( i ),
+                                          i, entry.pstate, m_pAnalyser );
+        m_pages[i] = entry;
+    }
+    pmutex->unlock();
+}
+PdfeContentsStream* PRPagePrefetcher::take( size_t pageIndex )
+{
+    std::map<size_t, Entry>::iterator it = m_pages.find( pageIndex );
+    if( it == m_pages.end() ) {
+        return NULL;
+    }
+    PdfeContentsStream* pstream = result( it->second );
+    m_pages.erase( it );
+    return pstream;
+}
+void PRPagePrefetcher::discard( size_t pageIndex )
+{
+    delete this->take( pageIndex );
+}
+void PRPagePrefetcher::clear()
+{
+    std::map<size_t, Entry>::iterator it;
+    for( it = m_pages.begin() ; it != m_pages.end() ; ++it ) {
+        delete result( it->second );
+    }
+    m_pages.clear();
+}
+
+PdfeContentsStream* PRPagePrefetcher::load( PRDocument* pdocument,
+                                            PdfPage* ppage,
+                                            size_t pageIndex,
+                                            boost::shared_ptr<State> pstate,
+                                            Analyser* panalyser )
+{
+    QMutex* pmutex = pdocument->podofoMutex();
+    const PdfeContentsCache& cache = pdocument->contentsCache();
+    PdfeContentsStream* pstream = new PdfeContentsStream();
+    try {
+        // On-disk contents cache first.
+        QByteArray key;
+        bool cached = false;
+        {
+            QMutexLocker locker( pmutex );
+            if( int( pstate->cancelled ) ) {
+                delete pstream;
+                return NULL;
+            }
+            if( cache.isEnabled() ) {
+                key = cache.key( ppage );
+                cached = cache.load( key, *pstream, ppage->GetObject()->GetOwner() );
+                if( cached ) {
+                    pdocument->streamDecoder()->discard( ppage );
+                }
+            }
+        }
+        // Parsing: the mutex is only held while accessing PoDoFo objects.
+        if( !cached ) {
+            pstream->load( ppage, true, true, pdocument->streamDecoder(), pmutex, &pstate->cancelled );
+        }
+        QMutexLocker locker( pmutex );
+        if( int( pstate->cancelled ) ) {
+            delete pstream;
+            return NULL;
+        }
+        if( !cached && cache.isEnabled() ) {
+            cache.store( key, *pstream );
+        }
+        if( panalyser ) {
+            panalyser->analyse( pageIndex, *pstream );
+        }
+        pstate->done = true;
+    }
+    catch( const PdfError& ) {
+        // Cancelled, or synchronous loading will raise the error properly.
+        delete pstream;
+        return NULL;
+    }
+    return pstream;
+}
+PdfeContentsStream* PRPagePrefetcher::result( Entry& entry )
+{
+    // Not waiting for a running worker: it may need a mutex held by this thread.
+    {
+        QMutexLocker locker( m_pDocument->podofoMutex() );
+        if( !entry.pstate->done ) {
+            entry.pstate->cancelled = 1;
+            m_cancelled.push_back( entry.future );
+            return NULL;
+        }
+    }
+    // Done: the worker is returning, without locking.
+    return entry.future.result();
+}
+size_t PRPagePrefetcher::boundedDepth() const
+{
+    const PRCacheManager* pmanager = m_pDocument->cacheManager();
+    PRCacheManager::Statistics stats = pmanager->statistics( PRCacheKind::Contents );
+    if( !stats.nbEntries || !stats.nbBytes ) {
+        return m_depth;
+    }
+    size_t nbBytesFree = 0;
+    if( pmanager->budget() > pmanager->nbBytes() ) {
+        nbBytesFree = pmanager->budget() - pmanager->nbBytes();
+    }
+    return std::min( m_depth, nbBytesFree / ( stats.nbBytes / stats.nbEntries + 1 ) );
+}
+
+}
@@ -0,0 +1,180 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRPAGEPREFETCHER_H
+#define PRPAGEPREFETCHER_H
+
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <QFuture>
+#include <QAtomicInt>
+
+namespace PoDoFo {
+class PdfPage;
+}
+namespace PoDoFoExtended {
+class PdfeContentsStream;
+}
+
+namespace PdfRecut {
+
+class PRDocument;
+
+//************************************************************//
+//                      PRPagePrefetcher                      //
+//************************************************************//
+/** Prefetcher of pages contents, driven by the access pattern.
+ * Once sequential accesses are detected (at least two consecutive
+ * pages), the contents streams of the next pages are loaded on the
+ * Qt global thread pool, such that they are ready when accessed.
+ * The number of pages loaded in advance is bounded by the depth and
+ * by the memory left in the cache manager of the document.
+ *
+ * Workers first look up the on-disk contents cache, and only hold the
+ * PoDoFo mutex of the document while accessing PoDoFo objects (decoded
+ * streams are parsed unlocked). A loading not finished when the page is
+ * accessed is cancelled rather than waited for, since the calling thread
+ * may hold the mutex: the worker stops the next time it acquires it.
+ * Loadings are also cancelled when pages are modified.
+ *
+ * The prefetcher itself is used from the thread owning the document.
+ */
+class PRPagePrefetcher
+{
+public:
+    /** Interface of an analysis run on prefetched contents, in the
+     * worker thread (PoDoFo mutex held). Must be thread-safe.
+     */
+    class Analyser
+    {
+    public:
+        virtual ~Analyser() { }
+        /** Analyse the contents of a page.
+         * \param pageIndex Index of the page.
+         * \param contents Contents stream loaded.
+         */
+        virtual void analyse( size_t pageIndex,
+                              const PoDoFoExtended::PdfeContentsStream& contents ) = 0;
+    };
+
+public:
+    /** Create a prefetcher attached to a document (depth: DefaultDepth).
+     * \param pdocument Parent document.
+     */
+    explicit PRPagePrefetcher( PRDocument* pdocument );
+    /** Destructor: cancel loadings and wait for the workers.
+     */
+    ~PRPagePrefetcher();
+
+    /** Register an access to a page. Schedule the loading of the next
+     * pages if the access pattern is sequential; discard loaded
+     * pages otherwise.
+     * \param pageIndex Index of the page accessed.
+     */
+    void notifyAccess( size_t pageIndex );
+    /** Take the contents loaded in advance for a page. The loading is
+     * cancelled if not finished.
+     * \param pageIndex Index of the page.
+     * \return Contents stream, owned by the caller. NULL if not available.
+     */
+    PoDoFoExtended::PdfeContentsStream* take( size_t pageIndex );
+    /** Discard the contents loaded for a page (e.g. modified page).
+     * \param pageIndex Index of the page.
+     */
+    void discard( size_t pageIndex );
+    /** Discard every page loaded or pending.
+     */
+    void clear();
+
+    /// Set the number of pages loaded in advance (0: disabled).
+    void setDepth( size_t depth )   {   m_depth = depth;    }
+    /// Number of pages loaded in advance.
+    size_t depth() const            {   return m_depth;     }
+    /// Set the analysis run on prefetched contents (NULL: none, default).
+    void setAnalyser( Analyser* panalyser ) {   m_pAnalyser = panalyser;    }
+    /// Analysis run on prefetched contents.
+    Analyser* analyser() const      {   return m_pAnalyser; }
+    /// Number of pages loaded or pending.
+    size_t size() const             {   return m_pages.size();  }
+
+public:
+    /// Default number of pages loaded in advance.
+    static const size_t DefaultDepth = 2;
+
+private:
+    /// Loading state of a page, shared with the worker. Set with the PoDoFo mutex held.
+    struct State {
+        /// Loading cancelled (worker stopped at its next lock).
+        QAtomicInt  cancelled;
+        /// Loading done (result returned by the worker).
+        bool  done;
+
+        State() : cancelled( 0 ), done( false ) { }
+    };
+    /// Page scheduled.
+    struct Entry {
+        /// Loading state.
+        boost::shared_ptr<State>  pstate;
+        /// Loading job.
+        QFuture<PoDoFoExtended::PdfeContentsStream*>  future;
+    };
+    /** Loading job, run by a worker.
+     * \param pdocument Parent document.
+     * \param ppage PoDoFo page to load.
+     * \param pageIndex Index of the page.
+     * \param pstate Loading state.
+     * \param panalyser Analysis to run (can be NULL).
+     * \return Contents stream loaded. NULL if cancelled or on error.
+     */
+    static PoDoFoExtended::PdfeContentsStream* load( PRDocument* pdocument,
+                                                     PoDoFo::PdfPage* ppage,
+                                                     size_t pageIndex,
+                                                     boost::shared_ptr<State> pstate,
+                                                     Analyser* panalyser );
+    /** Get the result of an entry if done, cancel the loading otherwise.
+     * \param entry Page scheduled.
+     * \return Contents stream. NULL if cancelled or on error.
+     */
+    PoDoFoExtended::PdfeContentsStream* result( Entry& entry );
+    /** Number of pages to load in advance, bounded by the memory left in
+     * the cache manager (estimated with the mean footprint of cached contents).
+     */
+    size_t boundedDepth() const;
+
+private:
+    // No copy constructor and operator= allowed.
+    PRPagePrefetcher( const PRPagePrefetcher& rhs );
+    PRPagePrefetcher& operator=( const PRPagePrefetcher& rhs );
+
+private:
+    /// Parent document.
+    PRDocument*  m_pDocument;
+    /// Number of pages loaded in advance.
+    size_t  m_depth;
+    /// Analysis run on prefetched contents.
+    Analyser*  m_pAnalyser;
+
+    /// Index of the last page accessed.
+    size_t  m_lastIndex;
+    /// Number of consecutive sequential accesses.
+    size_t  m_nbSequential;
+    /// Pages scheduled, indexed by page index.
+    std::map<size_t, Entry>  m_pages;
+    /// Jobs cancelled, possibly still running.
+    std::vector< QFuture<PoDoFoExtended::PdfeContentsStream*> >  m_cancelled;
+};
+
+}
+
+#endif // PRPAGEPREFETCHER_H
@@ -0,0 +1,160 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PRPagesIndex.h"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <utility>
+
+#include <podofo/podofo.h>
+
+using namespace PoDoFo;
+
+namespace PdfRecut {
+
+PRPagesIndex::PRPagesIndex() :
+    m_pDocument( NULL )
+{
+}
+PRPagesIndex::~PRPagesIndex()
+{
+    this->clear();
+}
+
+void PRPagesIndex::build( PdfMemDocument* pdocument )
+{
+    this->clear();
+    m_pDocument = pdocument;
+    if( !m_pDocument ) {
+        return;
+    }
+    m_entries.reserve( m_pDocument->GetPageCount() );
+
+    // Depth-first walk of the pages tree, with inherited attributes.
+    std::vector< std::pair<PdfObject*, Entry> > nodes;
+    std::set<PdfReference> visited;
+    PdfObject* proot = m_pDocument->GetPagesTree()->GetObject();
+    nodes.push_back( std::make_pair( proot, Entry() ) );
+    while( !nodes.empty() ) {
+        PdfObject* pnode = nodes.back().first;
+        Entry entry = nodes.back().second;
+        nodes.pop_back();
+        if( !pnode || !pnode->IsDictionary() ) {
+            // Invalid kid: counted as a page by PoDoFo, empty entry.
+            if( pnode != proot ) {
+                m_entries.push_back( Entry() );
+            }
+            continue;
+        }
+        if( !visited.insert( pnode->Reference() ).second ) {
+            continue;
+        }
+        readAttributes( pnode, entry );
+
+        PdfObject* pKids = pnode->GetIndirectKey( "Kids" );
+        if( pKids && pKids->IsArray() ) {
+            // Intermediate node: kids pushed in reverse order.
+            const PdfArray& kids = pKids->GetArray();
+            for( size_t i = kids.size() ; i > 0 ; --i ) {
+                if( kids[i-1].IsReference() ) {
+                    nodes.push_back( std::make_pair(
+                                         m_pDocument->GetObjects().GetObject( kids[i-1].GetReference() ),
+                                         entry ) );
+                }
+            }
+        }
+        else {
+            // Leaf: page object.
+            entry.pobject = pnode;
+            entry.reference = pnode->Reference();
+            if( !entry.cropBox.GetWidth() || !entry.cropBox.GetHeight() ) {
+                entry.cropBox = entry.mediaBox;
+            }
+            m_entries.push_back( entry );
+        }
+    }
+}
+void PRPagesIndex::clear()
+{
+    for( size_t i = 0 ; i < m_entries.size() ; ++i ) {
+        delete m_entries[i].ppage;
+    }
+    m_pDocument = NULL;
+    m_entries.clear();
+}
+void PRPagesIndex::insert( size_t index, PdfObject* pobject )
+{
+    // New page: attributes inherited from the root down to the page.
+    std::vector<PdfObject*> pnodes;
+    std::set<PdfReference> visited;
+    for( PdfObject* pnode = pobject ; pnode && pnode->IsDictionary() ;
+         pnode = pnode->GetIndirectKey( "Parent" ) ) {
+        if( !visited.insert( pnode->Reference() ).second ) {
+            break;
+        }
+        pnodes.push_back( pnode );
+    }
+    Entry entry;
+    for( size_t i = pnodes.size() ; i > 0 ; --i ) {
+        readAttributes( pnodes[i-1], entry );
+    }
+    entry.pobject = pobject;
+    entry.reference = pobject->Reference();
+    if( !entry.cropBox.GetWidth() || !entry.cropBox.GetHeight() ) {
+        entry.cropBox = entry.mediaBox;
+    }
+    index = std::min( index, m_entries.size() );
+    m_entries.insert( m_entries.begin() + index, entry );
+}
+void PRPagesIndex::erase( size_t index )
+{
+    if( index < m_entries.size() ) {
+        delete m_entries[index].ppage;
+        m_entries.erase( m_entries.begin() + index );
+    }
+}
+
+PdfPage* PRPagesIndex::page( size_t index )
+{
+    Entry& entry = m_entries.at( index );
+    if( !entry.ppage && entry.pobject ) {
+        // Created from the page object: resources inherited from the indexed node.
+        std::deque<PdfObject*> pparents;
+        if( entry.presourcesNode ) {
+            pparents.push_back( entry.presourcesNode );
+        }
+        entry.ppage = new PdfPage( entry.pobject, pparents );
+    }
+    return entry.ppage;
+}
+
+void PRPagesIndex::readAttributes( PdfObject* pnode, Entry& entry )
+{
+    PdfObject* pObj = pnode->GetIndirectKey( "MediaBox" );
+    if( pObj && pObj->IsArray() ) {
+        entry.mediaBox = PdfRect( pObj->GetArray() );
+    }
+    pObj = pnode->GetIndirectKey( "CropBox" );
+    if( pObj && pObj->IsArray() ) {
+        entry.cropBox = PdfRect( pObj->GetArray() );
+    }
+    pObj = pnode->GetIndirectKey( "Rotate" );
+    if( pObj && pObj->IsNumber() ) {
+        entry.rotate = static_cast<int>( pObj->GetNumber() );
+    }
+    if( pnode->GetDictionary().HasKey( "Resources" ) ) {
+        entry.presourcesNode = pnode;
+    }
+}
+
+}
@@ -0,0 +1,121 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PRPAGESINDEX_H
+#define PRPAGESINDEX_H
+
+#include <vector>
+
+#include <podofo/base/PdfRect.h>
+#include <podofo/base/PdfReference.h>
+
+namespace PoDoFo {
+class PdfMemDocument;
+class PdfObject;
+class PdfPage;
+}
+
+namespace PdfRecut {
+
+//************************************************************//
+//                        PRPagesIndex                        //
+//************************************************************//
+/** Flat index of the pages of a PoDoFo document. The pages tree is
+ * walked once, collecting pages objects and their inherited attributes
+ * (MediaBox, CropBox, Resources, Rotate), such that hot loops do not
+ * traverse the tree and the parents of every page.
+ * PoDoFo::PdfPage objects are created from the indexed objects on first
+ * access, and owned by the index. Kids which are not valid page objects
+ * keep an empty entry, such that indexes match PoDoFo pages indexes.
+ * The index must be updated when the pages tree is modified.
+ */
+class PRPagesIndex
+{
+public:
+    /** Entry of a page.
+     */
+    struct Entry {
+        /// Page object (NULL if not a valid page object).
+        PoDoFo::PdfObject*  pobject;
+        /// Reference of the page object.
+        PoDoFo::PdfReference  reference;
+        /// Media box (inherited).
+        PoDoFo::PdfRect  mediaBox;
+        /// Crop box (inherited, media box if not defined).
+        PoDoFo::PdfRect  cropBox;
+        /// Node defining the resources: page object or ancestor (can be NULL).
+        PoDoFo::PdfObject*  presourcesNode;
+        /// Rotation, in degrees (inherited).
+        int  rotate;
+        /// PoDoFo page (NULL until accessed).
+        PoDoFo::PdfPage*  ppage;
+
+        Entry() : pobject( NULL ), presourcesNode( NULL ), rotate( 0 ), ppage( NULL ) { }
+    };
+
+public:
+    /** Create an empty index.
+     */
+    PRPagesIndex();
+    /** Destructor: delete PoDoFo pages created.
+     */
+    ~PRPagesIndex();
+
+    /** Build the index of a document, walking its pages tree.
+     * \param pdocument PoDoFo document.
+     */
+    void build( PoDoFo::PdfMemDocument* pdocument );
+    /** Clear the index.
+     */
+    void clear();
+    /** Insert the entry of a page inserted in the pages tree.
+     * Inherited attributes are read along its parents.
+     * \param index Index of the page inserted.
+     * \param pobject Page object inserted.
+     */
+    void insert( size_t index, PoDoFo::PdfObject* pobject );
+    /** Erase the entry of a page deleted from the pages tree.
+     * \param index Index of the page deleted.
+     */
+    void erase( size_t index );
+
+    /// Number of pages.
+    size_t size() const     {   return m_entries.size();    }
+    /// Entry of a page.
+    const Entry& entry( size_t index ) const    {   return m_entries.at( index );   }
+    /** Get the PoDoFo page object (created from the entry on first access).
+     * \param index Index of the page.
+     * \return PoDoFo page. NULL if not a valid page object.
+     */
+    PoDoFo::PdfPage* page( size_t index );
+
+private:
+    /** Read the (inheritable) attributes of a pages tree node.
+     * \param pnode Node of the pages tree (or page object).
+     * \param entry Entry where to store attributes.
+     */
+    static void readAttributes( PoDoFo::PdfObject* pnode, Entry& entry );
+
+private:
+    // No copy constructor and operator= allowed.
+    PRPagesIndex( const PRPagesIndex& rhs );
+    PRPagesIndex& operator=( const PRPagesIndex& rhs );
+
+private:
+    /// PoDoFo document.
+    PoDoFo::PdfMemDocument*  m_pDocument;
+    /// Entries of pages.
+    std::vector<Entry>  m_entries;
+};
+
+}
+
+#endif // PRPAGESINDEX_H
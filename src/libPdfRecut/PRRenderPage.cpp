@@ -38,7 +38,7 @@ PRRenderPage::PRRenderPage( PRDocument* document,
                             const PdfeContentsStream* pContents ) :
     PdfeContentsAnalysis(),
     m_document( document ),
-    m_page( document->podofoDocument()->GetPage( pageIndex ) ),
+    m_page( document->pagesIndex()->page( pageIndex ) ),
     m_pageIndex( pageIndex ),
     m_pContentsStream( NULL ),
     m_pageImage( NULL ),
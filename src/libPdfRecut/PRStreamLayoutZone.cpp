@@ -11,6 +11,8 @@
 
 #include <podofo/podofo.h>
 #include "PRStreamLayoutZone.h"
+#include "PRPage.h"
+#include "PdfeProfiler.h"
 
 #define BUFFER_SIZE 4096
 
@@ -19,12 +21,12 @@ using namespace PoDoFoExtended;
 
 namespace PdfRecut {
 
-PRStreamLayoutZone::PRStreamLayoutZone( PoDoFo::PdfPage* pageIn,
+PRStreamLayoutZone::PRStreamLayoutZone( const PRPage* pageIn,
                                         PoDoFo::PdfStream* streamOut,
                                         PdfeResources* resourcesOut,
                                         const PRPageZone &zone,
                                         const PRLayoutParameters &parameters, const std::string &resSuffixe ) :
-    PdfeCanvasAnalysis(), m_pageIn( pageIn ), m_zone ( zone ), m_resSuffixe ( resSuffixe ), m_parameters( parameters )
+    PdfeContentsAnalysis(), m_pageIn( pageIn ), m_zone ( zone ), m_resSuffixe ( resSuffixe ), m_parameters( parameters )
 {
     // Downcasting to PdfMemStream pointer.resource
     m_streamOut = dynamic_cast<PdfMemStream*>( streamOut );
@@ -35,6 +37,8 @@ PRStreamLayoutZone::PRStreamLayoutZone( PoDoFo::PdfPage* pageIn,
 
 void PRStreamLayoutZone::generateStream()
 {
+    PDFE_PROFILE_SCOPE( "layout.zone" );
+    PDFE_PROFILE_COUNTER( "layout.zones", 1 );
     // Zone Out coordinates and transformation.
     PdfeMatrix zoneOutTrMatrix;
     zoneOutTrMatrix(2,0) = m_zone.leftZoneOut - m_zone.zoneIn.GetLeft();
@@ -68,8 +72,8 @@ void PRStreamLayoutZone::generateStream()
     m_streamOut->Append( m_bufStream.str() );
     m_bufStream.str( "" );
 
-    // Perform the analysis.
-    this->analyseContents( m_pageIn, PdfeGraphicsState(), PdfeResources() );
+    // Perform the analysis on the page contents (cached by the parent document).
+    this->analyseContents( m_pageIn->contents() );
 
     // Close stream.
     m_streamOut->Append("Q\n");
@@ -83,11 +87,11 @@ void PRStreamLayoutZone::generateStream()
     //    std::cout << bufs.str() << std::endl;
 }
 
-void PRStreamLayoutZone::fGeneralGState( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fGeneralGState( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const std::vector<std::string>& gOperands = streamState.gOperands;
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
 
     m_bufStream.str("");
     m_bufString.clear();
@@ -95,13 +99,13 @@ void PRStreamLayoutZone::fGeneralGState( const PdfeStreamStateOld& streamState )
     if( gOperator.type() == PdfeGOperator::gs ) {
         // Specific case of command "gs": add resource suffixe.
         m_bufString += "/";
-        m_bufString += gOperands.back().substr( 1 );
+        m_bufString += gOperands.back().to_string().substr( 1 );
         m_bufString += this->getSuffixe();
         m_bufString += " gs\n";
 
         // Add key to out resources.
         this->addResourcesOutKey( PdfeResourcesType::ExtGState,
-                                  gOperands.back().substr( 1 ),
+                                  gOperands.back().to_string().substr( 1 ),
                                   streamState.resources );
     }
     else {
@@ -113,11 +117,11 @@ void PRStreamLayoutZone::fGeneralGState( const PdfeStreamStateOld& streamState )
     m_streamOut->Append( m_bufString );
 }
 
-void PRStreamLayoutZone::fSpecialGState( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fSpecialGState( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const std::vector<std::string>& gOperands = streamState.gOperands;
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
 
     m_bufString.clear();
 
@@ -128,18 +132,18 @@ void PRStreamLayoutZone::fSpecialGState( const PdfeStreamStateOld& streamState )
     m_streamOut->Append( m_bufString );
 }
 
-void PRStreamLayoutZone::fPathConstruction( const PdfeStreamStateOld& streamState,
+void PRStreamLayoutZone::fPathConstruction( const PdfeStreamState& streamState,
                                             const PdfePath& currentPath )
 {
     // Everything is done in painting function !
 }
 
-void PRStreamLayoutZone::fPathPainting( const PdfeStreamStateOld& streamState,
+void PRStreamLayoutZone::fPathPainting( const PdfeStreamState& streamState,
                                         const PdfePath& currentPath )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const PdfeGraphicsState& gState = streamState.gStates.back();
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const PdfeGraphicsState& gState = streamState.gstates.back();
 
     // Subpaths from the current path.
     std::vector<PdfeSubPath> subpaths = currentPath.subpaths();
@@ -247,15 +251,15 @@ void PRStreamLayoutZone::fPathPainting( const PdfeStreamStateOld& streamState,
     m_streamOut->Append( m_bufStream.str() );
 }
 
-void PRStreamLayoutZone::fClippingPath( const PdfeStreamStateOld& streamState,
+void PRStreamLayoutZone::fClippingPath( const PdfeStreamState& streamState,
                                         const PdfePath& currentPath  )
 {
 }
 
-void PRStreamLayoutZone::fTextObjects( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fTextObjects( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
 
     // Copy operator.
     m_bufString = gOperator.str();
@@ -263,24 +267,24 @@ void PRStreamLayoutZone::fTextObjects( const PdfeStreamStateOld& streamState )
     m_streamOut->Append( m_bufString );
 }
 
-void PRStreamLayoutZone::fTextState( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fTextState( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const std::vector<std::string>& gOperands = streamState.gOperands;
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
 
     if( gOperator.type() == PdfeGOperator::Tf ) {
         // Font: add resource prefix to name.
         m_bufString = "/";
-        m_bufString += gOperands[0].substr( 1 );
+        m_bufString += gOperands[0].to_string().substr( 1 );
         m_bufString += this->getSuffixe();
         m_bufString += " ";
-        m_bufString += gOperands[1];
+        m_bufString += gOperands[1].to_string();
         m_bufString += " Tf\n";
 
         // Add key to out resources.
         this->addResourcesOutKey( PdfeResourcesType::Font,
-                                  gOperands[0].substr( 1 ),
+                                  gOperands[0].to_string().substr( 1 ),
                                   streamState.resources );
     }
     else {
@@ -293,11 +297,11 @@ void PRStreamLayoutZone::fTextState( const PdfeStreamStateOld& streamState )
     m_streamOut->Append( m_bufString );
 }
 
-void PRStreamLayoutZone::fTextPositioning( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fTextPositioning( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const std::vector<std::string>& gOperands = streamState.gOperands;
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
 
     // Copy variables and operator.
     m_bufString.clear();
@@ -307,12 +311,12 @@ void PRStreamLayoutZone::fTextPositioning( const PdfeStreamStateOld& streamState
     m_streamOut->Append( m_bufString );
 }
 
-PdfeVector PRStreamLayoutZone::fTextShowing( const PdfeStreamStateOld& streamState )
+PdfeVector PRStreamLayoutZone::fTextShowing( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const std::vector<std::string>& gOperands = streamState.gOperands;
-    const PdfeGraphicsState& gState = streamState.gStates.back();
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
+    const PdfeGraphicsState& gState = streamState.gstates.back();
 
     // Show text if inside page zone.
     PdfeMatrix tmpMat = gState.textState().transMat() * gState.transMat();
@@ -343,11 +347,11 @@ PdfeVector PRStreamLayoutZone::fTextShowing( const PdfeStreamStateOld& streamSta
     return PdfeVector();
 }
 
-void PRStreamLayoutZone::fType3Fonts( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fType3Fonts( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const std::vector<std::string>& gOperands = streamState.gOperands;
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
 
     m_bufString.clear();
 
@@ -358,22 +362,22 @@ void PRStreamLayoutZone::fType3Fonts( const PdfeStreamStateOld& streamState )
     m_streamOut->Append( m_bufString );
 }
 
-void PRStreamLayoutZone::fColor( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fColor( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const std::vector<std::string>& gOperands = streamState.gOperands;
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
 
     m_bufString.clear();
     // Test if the last operand is a PdfName.
-    if( gOperands.back()[0] == '/' ) {
+    if( !gOperands.empty() && !gOperands.back().empty() && gOperands.back()[0] == '/' ) {
         // Copy the sub-vector.
-        std::vector<std::string> tmpGOperands( gOperands );
+        std::vector<PdfeData> tmpGOperands( gOperands );
         tmpGOperands.pop_back();
         this->copyVariables( tmpGOperands, m_bufString );
 
         // Color space resource.
-        m_bufString +=  gOperands.back();
+        m_bufString += gOperands.back().to_string();
         m_bufString += this->getSuffixe();
         m_bufString += " ";
         m_bufString += gOperator.str();
@@ -381,7 +385,7 @@ void PRStreamLayoutZone::fColor( const PdfeStreamStateOld& streamState )
 
         // Add key to out resources.
         this->addResourcesOutKey( PdfeResourcesType::ColorSpace,
-                                  gOperands.back().substr( 1 ),
+                                  gOperands.back().to_string().substr( 1 ),
                                   streamState.resources );
     }
     else {
@@ -394,34 +398,34 @@ void PRStreamLayoutZone::fColor( const PdfeStreamStateOld& streamState )
     m_streamOut->Append( m_bufString );
 }
 
-void PRStreamLayoutZone::fShadingPatterns( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fShadingPatterns( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const std::vector<std::string>& gOperands = streamState.gOperands;
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
 
     // Paint a shading pattern in the current clipping path. TBI: check if inside zone.
     if( true )
     {
         // Command sh: add resource prefix.
         m_bufString = "/";
-        m_bufString += gOperands.back().substr( 1 );
+        m_bufString += gOperands.back().to_string().substr( 1 );
         m_bufString += this->getSuffixe();
         m_bufString += " sh\n";
         m_streamOut->Append( m_bufString );
 
         // Add key to out resources.
         this->addResourcesOutKey( PdfeResourcesType::Shading,
-                                  gOperands.back().substr( 1 ),
+                                  gOperands.back().to_string().substr( 1 ),
                                   streamState.resources );
     }
 }
 
-void PRStreamLayoutZone::fInlineImages( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fInlineImages( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
-    const std::vector<std::string>& gOperands = streamState.gOperands;
-    const PdfeGraphicsState& gState = streamState.gStates.back();
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
+    const PdfeGraphicsState& gState = streamState.gstates.back();
 
     if( gOperator.type() == PdfeGOperator::ID ) {
         // Save variables.
@@ -446,26 +450,25 @@ void PRStreamLayoutZone::fInlineImages( const PdfeStreamStateOld& streamState )
 
         // Image data.
         m_bufString += "ID ";
-        m_bufString += gOperands.back();
+        m_bufString += gOperands.back().to_string();
         m_bufString += " EI\n";
 
         m_streamOut->Append( m_bufString );
     }
 }
 
-void PRStreamLayoutZone::fXObjects( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fXObjects( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const std::vector<std::string>& gOperands = streamState.gOperands;
-    const PdfeGraphicsState& gState = streamState.gStates.back();
+    const std::vector<PdfeData>& gOperands = streamState.pNode->operands();
+    const PdfeGraphicsState& gState = streamState.gstates.back();
 
-    // Get XObject and subtype.
-    std::string xobjName = gOperands.back().substr( 1 );
-    PdfObject* xobjPtr = streamState.resources.getIndirectKey( PdfeResourcesType::XObject, xobjName );
-    std::string xobjSubtype = xobjPtr->GetIndirectKey( "Subtype" )->GetName().GetName();
+    // XObject name and type (set when the contents stream is loaded).
+    std::string xobjName = gOperands.back().to_string().substr( 1 );
+    PdfeXObjectType::Enum xobjType = streamState.pNode->xobjectType();
 
     // Distinction between different type of XObjects
-    if( !xobjSubtype.compare( "Image" ) ) {
+    if( xobjType == PdfeXObjectType::Image ) {
         // Check if the image is inside the zone.
         PdfePath pathImg;
         pathImg.appendRectangle( PdfRect(0,0,1,1) );
@@ -488,17 +491,17 @@ void PRStreamLayoutZone::fXObjects( const PdfeStreamStateOld& streamState )
                                       streamState.resources );
         }
     }
-    else if( !xobjSubtype.compare( "Form" ) ) {
+    else if( xobjType == PdfeXObjectType::Form ) {
         // Nothing to do.
         // See fFormBegin and fFormEnd.
     }
-    else if( !xobjSubtype.compare( "PS" ) ) {
+    else if( xobjType == PdfeXObjectType::PS ) {
         // Depreciated according to Pdf reference.
         // Therefore, don't care about the implementation...
     }
 }
 
-void PRStreamLayoutZone::fFormBegin( const PdfeStreamStateOld& streamState,
+void PRStreamLayoutZone::fFormBegin( const PdfeStreamState& streamState,
                                      PoDoFo::PdfXObject* form )
 {
     // Push form.
@@ -507,37 +510,38 @@ void PRStreamLayoutZone::fFormBegin( const PdfeStreamStateOld& streamState,
     // Add form to the list.
     m_formObjects.push_back( form->GetObject() );
 
-    // Follows implementation from Pdf Reference: q / cm / re W n.
+    // Form stream is inlined in the contents stream, including its
+    // transformation matrix (q / cm / ... / Q). The form's BBox clipping
+    // path is hence expressed in the current space: q / BBox W n.
     m_bufStream.str("");
     m_bufStream << "q\n";
 
-    // If transformation matrix, add it.
+    PdfeMatrix formTransMat;
     PdfObject* xObjPtr = form->GetObject();
     if( xObjPtr->GetDictionary().HasKey( "Matrix" ) ) {
         PdfArray& mat = xObjPtr->GetIndirectKey( "Matrix" )->GetArray();
-
-        m_bufStream << mat[0].GetReal() << " ";
-        m_bufStream << mat[1].GetReal() << " ";
-        m_bufStream << mat[2].GetReal() << " ";
-        m_bufStream << mat[3].GetReal() << " ";
-        m_bufStream << mat[4].GetReal() << " ";
-        m_bufStream << mat[5].GetReal() << " ";
-        m_bufStream << "cm\n";
+        formTransMat(0,0) = mat[0].GetReal();    formTransMat(0,1) = mat[1].GetReal();
+        formTransMat(1,0) = mat[2].GetReal();    formTransMat(1,1) = mat[3].GetReal();
+        formTransMat(2,0) = mat[4].GetReal();    formTransMat(2,1) = mat[5].GetReal();
     }
-
-    // Form's BBox: add corresponding clipping path.
     PdfRect formBBox = form->GetPageSize();
-    m_bufStream << formBBox.GetLeft() << " ";
-    m_bufStream << formBBox.GetBottom() << " ";
-    m_bufStream << formBBox.GetWidth() << " ";
-    m_bufStream << formBBox.GetHeight() << " ";
-    m_bufStream << " re W n\n";
+    PdfeVector bboxPoints[4] = {
+        PdfeVector( formBBox.GetLeft(), formBBox.GetBottom() ),
+        PdfeVector( formBBox.GetLeft() + formBBox.GetWidth(), formBBox.GetBottom() ),
+        PdfeVector( formBBox.GetLeft() + formBBox.GetWidth(), formBBox.GetBottom() + formBBox.GetHeight() ),
+        PdfeVector( formBBox.GetLeft(), formBBox.GetBottom() + formBBox.GetHeight() )
+    };
+    for( size_t i = 0 ; i < 4 ; ++i ) {
+        PdfeVector point = bboxPoints[i] * formTransMat;
+        m_bufStream << point(0) << " " << point(1) << ( i == 0 ? " m\n" : " l\n" );
+    }
+    m_bufStream << "h W n\n";
 
     // Append to stream.
     m_streamOut->Append( m_bufStream.str() );
 }
 
-void PRStreamLayoutZone::fFormEnd( const PdfeStreamStateOld& streamState,
+void PRStreamLayoutZone::fFormEnd( const PdfeStreamState& streamState,
                                    PoDoFo::PdfXObject* form )
 {
     // Pop form.
@@ -547,15 +551,15 @@ void PRStreamLayoutZone::fFormEnd( const PdfeStreamStateOld& streamState,
     m_streamOut->Append( "Q\n" );
 }
 
-void PRStreamLayoutZone::fMarkedContents( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fMarkedContents( const PdfeStreamState& streamState )
 {
     // Vous dîtes ?
 }
 
-void PRStreamLayoutZone::fCompatibility( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fCompatibility( const PdfeStreamState& streamState )
 {
     // Simpler references.
-    const PdfeGraphicOperator& gOperator = streamState.gOperator;
+    const PdfeGraphicOperator& gOperator = streamState.pNode->goperator();
 
     // Graphic compatibility mode.
     m_bufString = gOperator.str();
@@ -563,7 +567,7 @@ void PRStreamLayoutZone::fCompatibility( const PdfeStreamStateOld& streamState )
     m_streamOut->Append( m_bufString );
 }
 
-void PRStreamLayoutZone::fUnknown( const PdfeStreamStateOld& streamState )
+void PRStreamLayoutZone::fUnknown( const PdfeStreamState& streamState )
 {
     // Euh...
 }
@@ -12,7 +12,7 @@
 #ifndef PRSTREAMLAYOUTZONE_H
 #define PRSTREAMLAYOUTZONE_H
 
-#include "PdfeCanvasAnalysis.h"
+#include "PdfeContentsAnalysis.h"
 #include "PdfeMisc.h"
 
 #include "PRDocumentLayout.h"
@@ -24,19 +24,21 @@ namespace PoDoFo {
 
 namespace PdfRecut {
 
+class PRPage;
+
 /** Class used to generate a Pdf stream which corresponds to a given
  * document layout zone from a Pdf page.
  */
-class PRStreamLayoutZone : public PoDoFoExtended::PdfeCanvasAnalysis
+class PRStreamLayoutZone : public PoDoFoExtended::PdfeContentsAnalysis
 {
 public:
     /** Default constructor.
-     * \param pageIn Input page to analyse.
+     * \param pageIn Input page to analyse (contents taken from the document cache).
      * \param streamOut Output stream to generate.
      * \param zone Pdf zone corresponding to the output stream.
      * \param Resource prefix to be used in the output stream.
      */
-    PRStreamLayoutZone( PoDoFo::PdfPage* pageIn,
+    PRStreamLayoutZone( const PRPage* pageIn,
                         PoDoFo::PdfStream* streamOut,
                         PoDoFoExtended::PdfeResources* resourcesOut,
                         const PRPageZone& zone,
@@ -45,47 +47,47 @@ public:
 
     void generateStream();
 
-    void fGeneralGState( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fGeneralGState( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fSpecialGState( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fSpecialGState( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fPathConstruction( const PoDoFoExtended::PdfeStreamStateOld& streamState,
+    void fPathConstruction( const PoDoFoExtended::PdfeStreamState& streamState,
                             const PoDoFoExtended::PdfePath& currentPath );
 
-    void fPathPainting( const PoDoFoExtended::PdfeStreamStateOld& streamState,
+    void fPathPainting( const PoDoFoExtended::PdfeStreamState& streamState,
                         const PoDoFoExtended::PdfePath& currentPath );
 
-    void fClippingPath( const PoDoFoExtended::PdfeStreamStateOld& streamState,
+    void fClippingPath( const PoDoFoExtended::PdfeStreamState& streamState,
                         const PoDoFoExtended::PdfePath& currentPath );
 
-    void fTextObjects( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fTextObjects( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fTextState( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fTextState( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fTextPositioning( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fTextPositioning( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    PdfeVector fTextShowing( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    PdfeVector fTextShowing( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fType3Fonts( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fType3Fonts( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fColor( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fColor( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fShadingPatterns( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fShadingPatterns( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fInlineImages( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fInlineImages( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fXObjects( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fXObjects( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fMarkedContents( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fMarkedContents( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fCompatibility( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fCompatibility( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fUnknown( const PoDoFoExtended::PdfeStreamStateOld& streamState );
+    void fUnknown( const PoDoFoExtended::PdfeStreamState& streamState );
 
-    void fFormBegin( const PoDoFoExtended::PdfeStreamStateOld& streamState,
+    void fFormBegin( const PoDoFoExtended::PdfeStreamState& streamState,
                      PoDoFo::PdfXObject* form );
 
-    void fFormEnd( const PoDoFoExtended::PdfeStreamStateOld& streamState,
+    void fFormEnd( const PoDoFoExtended::PdfeStreamState& streamState,
                    PoDoFo::PdfXObject* form );
 
     /** Get the list of form objects from the page.
@@ -95,7 +97,7 @@ public:
 protected:
     /** Copy variables to a buffer.
      */
-    void copyVariables( const std::vector<std::string>& vecVariables, std::string& buffer );
+    void copyVariables( const std::vector<PoDoFoExtended::PdfeData>& vecVariables, std::string& buffer );
 
     /** Add out resources key.
      */
@@ -116,7 +118,7 @@ protected:
 
 protected:
     /// Input page.
-    PoDoFo::PdfPage*  m_pageIn;
+    const PRPage*  m_pageIn;
 
     /// Output stream.
     PoDoFo::PdfMemStream*  m_streamOut;
@@ -148,7 +150,7 @@ protected:
 
     // Temp variables used during analysis.
     /// Key/values of an inline image.
-    std::vector<std::string> m_keyValuesII;
+    std::vector<PoDoFoExtended::PdfeData> m_keyValuesII;
 };
 
 //**********************************************************//
@@ -158,11 +160,11 @@ inline std::vector<PoDoFo::PdfObject*> PRStreamLayoutZone::getFormObjects()
 {
     return m_formObjects;
 }
-inline void PRStreamLayoutZone::copyVariables( const std::vector<std::string>& vecVariables,
+inline void PRStreamLayoutZone::copyVariables( const std::vector<PoDoFoExtended::PdfeData>& vecVariables,
                                                std::string& buffer )
 {
     for( size_t i = 0 ; i < vecVariables.size() ; i++ ) {
-        buffer += vecVariables[i];
+        buffer.append( vecVariables[i].begin(), vecVariables[i].end() );
         buffer += " ";
     }
 }
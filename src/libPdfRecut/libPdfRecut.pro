@@ -22,7 +22,10 @@ SOURCES += \
     PRStreamLayoutZone.cpp \
     PRRenderPage.cpp \
     PRUtils.cpp \
-    PRPage.cpp
+    PRPage.cpp \
+    PRCacheManager.cpp \
+    PRPagePrefetcher.cpp \
+    PRPagesIndex.cpp
 
 HEADERS +=\
     PRDocument.h \
@@ -32,7 +35,10 @@ HEADERS +=\
     PRStreamLayoutZone.h \
     PRRenderPage.h \
     PRUtils.h \
-    PRPage.h
+    PRPage.h \
+    PRCacheManager.h \
+    PRPagePrefetcher.h \
+    PRPagesIndex.h
 
 ### libPoDoFoExtended
 INCLUDEPATH += $$PWD/../libPoDoFoExtended
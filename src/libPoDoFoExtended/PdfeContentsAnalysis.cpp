@@ -11,6 +11,8 @@
 
 #include "PdfeContentsAnalysis.h"
 #include "PdfeGraphicsState.h"
+#include "PdfeProfiler.h"
+#include "PdfeStreamTokenizer.h"
 
 #include <podofo/podofo.h>
 
@@ -34,6 +36,7 @@ PdfeContentsAnalysis::~PdfeContentsAnalysis()
 
 void PdfeContentsAnalysis::analyseContents( const PdfeContentsStream& stream )
 {
+    PDFE_PROFILE_SCOPE( "analysis.contents" );
     // Stream state and current path.
     PdfeStreamState streamState;
     PdfePath currentPath;
@@ -48,124 +51,133 @@ void PdfeContentsAnalysis::analyseContents( const PdfeContentsStream& stream )
     // Analyse contents stream's nodes.
     streamState.pNode = stream.firstNode();
     while( streamState.pNode ) {
-        // References to have simpler notations...
-        PdfeContentsStream::Node* pnode = streamState.pNode;
-        PdfeGraphicsState& gstate = streamState.gstates.back();
-        PdfeResources& resources = streamState.resources;
-
-        // Update graphics state.
-        gstate.update( pnode, currentPath, resources );
-
-        // Specific treatment for each kind of node.
-        if( pnode->category() == PdfeGCategory::GeneralGState ) {
-            // Commands in this category: w, J, j, M, d, ri, i, gs.
-            this->fGeneralGState( streamState );
-        }
-        else if( pnode->category() == PdfeGCategory::SpecialGState ) {
-            // Commands in this category: q, Q, cm.
-            if( pnode->type() == PdfeGOperator::q ) {
-                // Push on the graphics state stack.
-                streamState.gstates.push_back( gstate );
-            }
-            else if( pnode->type() == PdfeGOperator::Q ) {
-                // Pop on the graphics state stack.
-                streamState.gstates.pop_back();
-            }
-            // Call category function.
-            this->fSpecialGState( streamState );
-        }
-        else if( pnode->category() == PdfeGCategory::TextObjects ) {
-            // Commands in this category: BT, ET.
-            this->fTextObjects( streamState );
-        }
-        else if( pnode->category() == PdfeGCategory::TextState ) {
-            // Commands in this category: Tc, Tw, Tz, TL, Tf, Tr, Ts.
-            this->fTextState( streamState );
-        }
-        else if( pnode->category() == PdfeGCategory::TextPositioning ) {
-            // Commands in this category: Td, TD, Tm, T*.
-            this->fTextPositioning( streamState );
-        }
-        else if( pnode->category() == PdfeGCategory::TextShowing ) {
-            // Commands in this category: Tj, TJ, ', "
-
-            // Call category function: return text displacement vector.
-            PdfeVector textDispl = this->fTextShowing( streamState );
-            // Update text transformation matrix using the vector.
-            PdfeMatrix transMat;
-            transMat(2,0) = textDispl(0);
-            transMat(2,1) = textDispl(1);
-            gstate.textState().setTransMat( transMat * gstate.textState().transMat() );
-        }
-        else if( pnode->category() == PdfeGCategory::Color ) {
-            // Commands in this category: CS, cs, SC, SCN, sc, scn, G, g, RG, rg, K, k.
-            this->fColor( streamState );
-        }
-        else if( pnode->category() == PdfeGCategory::PathConstruction ) {
-            // Commands in this category: m, l, c, v, y, h, re.
+        streamState.pNode = this->analyseNode( streamState, currentPath, resourcesStack );
+        // Next node in the stream...
+        streamState.pNode = streamState.pNode->next();
+    }
+}
+PdfeContentsStream::Node* PdfeContentsAnalysis::analyseNode( PdfeStreamState& streamState,
+                                                             PdfePath& currentPath,
+                                                             std::vector<PdfeResources>& resourcesStack )
+{
+    // References to have simpler notations...
+    PdfeContentsStream::Node* pnode = streamState.pNode;
+    PdfeGraphicsState& gstate = streamState.gstates.back();
+    PdfeResources& resources = streamState.resources;
 
-            // Load current path.
-            pnode = currentPath.load( pnode, gstate );
-            // Call category function.
-            this->fPathConstruction( streamState, currentPath );
-        }
-        else if( pnode->category() == PdfeGCategory::PathPainting ) {
-            // Commands in this category: S, s, f, F, f*, B, B*, b, b*, n.
-
-            // Set path painting operator.
-            currentPath.setPaintingOp( pnode->goperator() );
-            // Call category function.
-            this->fPathPainting( streamState, currentPath );
-
-            // Update graphics state clipping rectangle.
-            gstate.clippingRect().append( currentPath );
-            // Clear the current path.
-            currentPath.init( true );
-        }
-        else if( pnode->category() == PdfeGCategory::ClippingPath ) {
-            // Commands in this category: W, W*.
+    // Update graphics state.
+    gstate.update( pnode, currentPath, resources );
 
-            // Set the clipping path operator of the current path.
-            currentPath.setClippingPathOp( pnode->goperator() );
-            // Call category function.
-            this->fClippingPath( streamState, currentPath );
-        }
-        else if( pnode->category() == PdfeGCategory::Type3Fonts ) {
-            // Commands in this category: d0, d1.
-            this->fType3Fonts( streamState );
-        }
-        else if( pnode->category() == PdfeGCategory::ShadingPatterns ) {
-            // Commands in this category: sh.
-            this->fShadingPatterns( streamState );
+    // Specific treatment for each kind of node.
+    if( pnode->category() == PdfeGCategory::GeneralGState ) {
+        // Commands in this category: w, J, j, M, d, ri, i, gs.
+        this->fGeneralGState( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::SpecialGState ) {
+        // Commands in this category: q, Q, cm.
+        if( pnode->type() == PdfeGOperator::q ) {
+            // Push on the graphics state stack.
+            streamState.gstates.push_back( gstate );
         }
-        else if( pnode->category() == PdfeGCategory::InlineImages ) {
-            // Commands in this category: BI, ID, EI.
-            this->fInlineImages( streamState );
+        else if( pnode->type() == PdfeGOperator::Q ) {
+            // Pop on the graphics state stack.
+            streamState.gstates.pop_back();
         }
-        else if( pnode->category() == PdfeGCategory::XObjects ) {
-            // Commands in this category: Do.
-
-            // Does it correspond to a form XObject which is Loaded?
-            if( pnode->xobjectType() == PdfeXObjectType::Form && pnode->isFormXObjectLoaded() ) {
-                // Opening node.
-                if( pnode->isOpeningNode() ) {
-                    // Save back resources and add form resources.
-                    PdfXObject xobject( pnode->xobject() );
-                    resourcesStack.push_back( streamState.resources );
-                    //streamState.resources.push_back( xobject.GetResources() );
-                    streamState.resources.append( PdfeResources( xobject.GetResources() ) );
-
-                    this->fFormBegin( streamState, &xobject );
-                }
-                // Closing node.
-                else if( pnode->isClosingNode() ) {
-                    // Restore resources.
-                    PdfXObject xobject( pnode->xobject() );
-                    streamState.resources = resourcesStack.back();
-                    resourcesStack.pop_back();
-
-                    this->fFormEnd( streamState, &xobject );
-                }
+        // Call category function.
+        this->fSpecialGState( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::TextObjects ) {
+        // Commands in this category: BT, ET.
+        this->fTextObjects( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::TextState ) {
+        // Commands in this category: Tc, Tw, Tz, TL, Tf, Tr, Ts.
+        this->fTextState( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::TextPositioning ) {
+        // Commands in this category: Td, TD, Tm, T*.
+        this->fTextPositioning( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::TextShowing ) {
+        // Commands in this category: Tj, TJ, ', "
+
+        // Call category function: return text displacement vector.
+        PdfeVector textDispl = this->fTextShowing( streamState );
+        // Update text transformation matrix using the vector.
+        PdfeMatrix transMat;
+        transMat(2,0) = textDispl(0);
+        transMat(2,1) = textDispl(1);
+        gstate.textState().setTransMat( transMat * gstate.textState().transMat() );
+    }
+    else if( pnode->category() == PdfeGCategory::Color ) {
+        // Commands in this category: CS, cs, SC, SCN, sc, scn, G, g, RG, rg, K, k.
+        this->fColor( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::PathConstruction ) {
+        // Commands in this category: m, l, c, v, y, h, re.
+
+        // Load current path.
+        pnode = currentPath.load( pnode, gstate );
+        // Call category function.
+        this->fPathConstruction( streamState, currentPath );
+    }
+    else if( pnode->category() == PdfeGCategory::PathPainting ) {
+        // Commands in this category: S, s, f, F, f*, B, B*, b, b*, n.
+
+        // Set path painting operator.
+        currentPath.setPaintingOp( pnode->goperator() );
+        // Call category function.
+        this->fPathPainting( streamState, currentPath );
+
+        // Update graphics state clipping rectangle.
+        gstate.clippingRect().append( currentPath );
+        // Clear the current path.
+        currentPath.init( true );
+    }
+    else if( pnode->category() == PdfeGCategory::ClippingPath ) {
+        // Commands in this category: W, W*.
+
+        // Set the clipping path operator of the current path.
+        currentPath.setClippingPathOp( pnode->goperator() );
+        // Call category function.
+        this->fClippingPath( streamState, currentPath );
+    }
+    else if( pnode->category() == PdfeGCategory::Type3Fonts ) {
+        // Commands in this category: d0, d1.
+        this->fType3Fonts( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::ShadingPatterns ) {
+        // Commands in this category: sh.
+        this->fShadingPatterns( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::InlineImages ) {
+        // Commands in this category: BI, ID, EI.
+        this->fInlineImages( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::XObjects ) {
+        // Commands in this category: Do.
+
+        // Does it correspond to a form XObject which is Loaded?
+        if( pnode->xobjectType() == PdfeXObjectType::Form && pnode->isFormXObjectLoaded() ) {
+            // Opening node.
+            if( pnode->isOpeningNode() ) {
+                // Save back resources and add form resources.
+                PdfXObject xobject( pnode->xobject() );
+                resourcesStack.push_back( streamState.resources );
+                //streamState.resources.push_back( xobject.GetResources() );
+                streamState.resources.append( PdfeResources( xobject.GetResources() ) );
+
+                this->fFormBegin( streamState, &xobject );
+            }
+            // Closing node.
+            else if( pnode->isClosingNode() ) {
+                // Restore resources.
+                PdfXObject xobject( pnode->xobject() );
+                streamState.resources = resourcesStack.back();
+                resourcesStack.pop_back();
+
+                this->fFormEnd( streamState, &xobject );
+            }
 //                // Get form's BBox and append it to clipping path.
 //                PdfArray& bbox = xObjPtr->GetIndirectKey( "BBox" )->GetArray();
 //                PdfePath pathBBox;
@@ -174,26 +186,183 @@ void PdfeContentsAnalysis::analyseContents( const PdfeContentsStream& stream )
 //                pathBBox.appendLine( PdfeVector( bbox[2].GetReal(), bbox[3].GetReal() ) );
 //                pathBBox.appendLine( PdfeVector( bbox[0].GetReal(), bbox[3].GetReal() ) );
 //                pathBBox.closeSubpath();
-            }
-            // Call category function.
-            this->fXObjects( streamState );
-        }
-        else if( pnode->category() == PdfeGCategory::Compatibility ) {
-            // Commands in this category: BX, EX.
-            this->fCompatibility( streamState );
         }
-        else if( pnode->category() == PdfeGCategory::Unknown ) {
-            // Call category function.
-            this->fUnknown( streamState );
+        // Call category function.
+        this->fXObjects( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::Compatibility ) {
+        // Commands in this category: BX, EX.
+        this->fCompatibility( streamState );
+    }
+    else if( pnode->category() == PdfeGCategory::Unknown ) {
+        // Call category function.
+        this->fUnknown( streamState );
 //                if( !gstate.compatibilityMode ) {
 //                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidContentStream,
 //                                             "Invalid token in a stream" );
 //                }
+    }
+    return pnode;
+}
+
+void PdfeContentsAnalysis::analyseContents( PdfCanvas* pcanvas,
+                                            const PdfeGraphicsState& initialGState,
+                                            bool loadFormsStream )
+{
+    PDFE_PROFILE_SCOPE( "analysis.contents" );
+    // Stream state and current path.
+    PdfeStreamState streamState;
+    PdfePath currentPath;
+    // Resources stack.
+    std::vector<PdfeResources> resourcesStack;
+    // Window of nodes not analysed yet.
+    PdfeContentsStream window;
+
+    // Initialize graphics state and resources.
+    streamState.pStream = &window;
+    streamState.pNode = NULL;
+    streamState.gstates.push_back( initialGState );
+    streamState.resources = PdfeResources( pcanvas->GetResources() );
+
+    // Streaming analysis, and flush remaining nodes.
+    this->analyseCanvas( pcanvas, loadFormsStream, window,
+                         streamState, currentPath, resourcesStack );
+    this->analyseWindow( window, streamState, currentPath, resourcesStack );
+}
+void PdfeContentsAnalysis::analyseCanvas( PdfCanvas* pcanvas,
+                                          bool loadFormsStream,
+                                          PdfeContentsStream& window,
+                                          PdfeStreamState& streamState,
+                                          PdfePath& currentPath,
+                                          std::vector<PdfeResources>& resourcesStack )
+{
+    // Contents stream tokenizer.
+    PdfeStreamTokenizer tokenizer( pcanvas );
+    // Tmp variable to store node informations.
+    EPdfContentsType tokenType;
+    std::string strVariant;
+    PdfeGraphicOperator goperator;
+    std::vector<PdfeData> goperands;
+    PdfeContentsStream::Node* pNode_BeginSubpath = NULL;
+    PdfeContentsStream::Node* pNode = NULL;
+
+    while( tokenizer.ReadNext( tokenType, goperator, strVariant ) ) {
+        // Variant or inline image data: store it in the operands stack.
+        if( tokenType == ePdfContentsType_Variant ||
+                tokenType == ePdfContentsType_ImageData ) {
+            goperands.push_back( strVariant );
+            continue;
         }
-        // Next node in the stream...
-        streamState.pNode = pnode;
+        if( tokenType != ePdfContentsType_Keyword ) {
+            continue;
+        }
+        // Keyword: append the node to the window.
+        pNode = window.insert( PdfeContentsStream::Node( 0, goperator, goperands ),
+                               window.lastNode() );
+        goperands.clear();
+
+        // Path construction and clipping: wait for the painting operator.
+        if( goperator.category() == PdfeGCategory::PathConstruction ) {
+            if( !pNode_BeginSubpath ) {
+                pNode_BeginSubpath = pNode;
+            }
+            pNode->setBeginSubpathNode( pNode_BeginSubpath );
+            if( goperator.type() == PdfeGOperator::h ) {
+                pNode_BeginSubpath = NULL;
+            }
+            continue;
+        }
+        pNode_BeginSubpath = NULL;
+        if( goperator.category() == PdfeGCategory::ClippingPath ) {
+            continue;
+        }
+        // Path painting: link path construction nodes.
+        if( goperator.category() == PdfeGCategory::PathPainting ) {
+            PdfeContentsStream::Node* pnode = window.firstNode();
+            while( pnode != pNode ) {
+                if( pnode->category() == PdfeGCategory::PathConstruction ) {
+                    pnode->setPaintingNode( pNode );
+                }
+                pnode = pnode->next();
+            }
+        }
+        // XObjects: set type and analyse forms if necessary.
+        else if( goperator.category() == PdfeGCategory::XObjects ) {
+            std::string xobjName = pNode->operands().back().to_string().substr( 1 );
+            PdfObject* pXObject = streamState.resources.getIndirectKey( PdfeResourcesType::XObject, xobjName );
+            if( pXObject ) {
+                std::string xobjSubtype = pXObject->GetIndirectKey( "Subtype" )->GetName().GetName();
+                if( xobjSubtype == "Form" ) {
+                    pNode->setXObject( PdfeXObjectType::Form, pXObject );
+                    pNode->setFormXObject( loadFormsStream, loadFormsStream, false );
+                    if( loadFormsStream ) {
+                        std::vector<PdfeData> xobjOperands( pNode->operands() );
+                        // Opening node: update resources before analysing the form.
+                        this->analyseWindow( window, streamState, currentPath, resourcesStack );
+                        window.insert( PdfeContentsStream::Node( 0, PdfeGraphicOperator( PdfeGOperator::q ) ),
+                                       window.lastNode() );
+                        // Transformation matrix of the form.
+                        if( pXObject->GetDictionary().HasKey( "Matrix" ) ) {
+                            PdfeMatrix formTransMat;
+                            PdfArray& mat = pXObject->GetIndirectKey( "Matrix" )->GetArray();
+                            formTransMat(0,0) = mat[0].GetReal();    formTransMat(0,1) = mat[1].GetReal();
+                            formTransMat(1,0) = mat[2].GetReal();    formTransMat(1,1) = mat[3].GetReal();
+                            formTransMat(2,0) = mat[4].GetReal();    formTransMat(2,1) = mat[5].GetReal();
+                            if( formTransMat != PdfeMatrix() ) {
+                                pNode = window.insert( PdfeContentsStream::Node( 0, PdfeGraphicOperator( PdfeGOperator::cm ) ),
+                                                       window.lastNode() );
+                                pNode->setOperands( formTransMat );
+                            }
+                        }
+                        this->analyseWindow( window, streamState, currentPath, resourcesStack );
+
+                        // Recursive analysis of the form stream.
+                        PdfXObject xobject( pXObject );
+                        this->analyseCanvas( &xobject, loadFormsStream, window,
+                                             streamState, currentPath, resourcesStack );
+
+                        // Restore graphics state and closing form node.
+                        window.insert( PdfeContentsStream::Node( 0, PdfeGraphicOperator( PdfeGOperator::Q ) ),
+                                       window.lastNode() );
+                        pNode = window.insert( PdfeContentsStream::Node( 0, goperator, xobjOperands ),
+                                               window.lastNode() );
+                        pNode->setXObject( PdfeXObjectType::Form, pXObject );
+                        pNode->setFormXObject( true, false, true );
+                    }
+                }
+                else if( xobjSubtype == "PS" ) {
+                    pNode->setXObject( PdfeXObjectType::PS, pXObject );
+                }
+                else if( xobjSubtype == "Image" ) {
+                    pNode->setXObject( PdfeXObjectType::Image, pXObject );
+                }
+                else {
+                    pNode->setXObject( PdfeXObjectType::Unknown, pXObject );
+                }
+            }
+            else {
+                pNode->setXObject( PdfeXObjectType::Unknown, pXObject );
+            }
+        }
+        // Analyse the window content.
+        this->analyseWindow( window, streamState, currentPath, resourcesStack );
+    }
+}
+void PdfeContentsAnalysis::analyseWindow( PdfeContentsStream& window,
+                                          PdfeStreamState& streamState,
+                                          PdfePath& currentPath,
+                                          std::vector<PdfeResources>& resourcesStack )
+{
+    streamState.pNode = window.firstNode();
+    while( streamState.pNode ) {
+        streamState.pNode = this->analyseNode( streamState, currentPath, resourcesStack );
         streamState.pNode = streamState.pNode->next();
     }
+    // Clear the window (node IDs keep increasing).
+    while( window.firstNode() ) {
+        window.erase( window.firstNode(), false );
+    }
+    streamState.pNode = NULL;
 }
 
 // Default implementations... Usually empty.
@@ -13,9 +13,11 @@
 #define PDFECONTENTSANALYSIS_H
 
 #include "PdfeContentsStream.h"
+#include "PdfeGraphicsState.h"
 #include "PdfePath.h"
 
 namespace PoDoFo {
+    class PdfCanvas;
     class PdfXObject;
 }
 
@@ -62,6 +64,59 @@ protected:
      * \param stream Contents stream to analyse.
      */
     void analyseContents( const PdfeContentsStream& stream );
+    /** Analyse the contents stream of a canvas in streaming mode, i.e.
+     * without materialising a complete PdfeContentsStream. Nodes are created
+     * on the fly from the tokenizer and only a bounded window is kept in memory
+     * (at most the current path and its painting/clipping operators).
+     * Consequently, in the stream state given to callbacks, pStream points to
+     * this window and nodes links outside of it (opening/closing nodes) are NULL.
+     * \param pcanvas Canvas whose contents stream is analysed.
+     * \param initialGState Initial graphics state.
+     * \param loadFormsStream Are streams from XObjects forms also analysed?
+     * If yes, they are analysed recursively, as if integrated in the parent stream.
+     */
+    void analyseContents( PoDoFo::PdfCanvas* pcanvas,
+                          const PdfeGraphicsState& initialGState,
+                          bool loadFormsStream );
+
+private:
+    /** Analyse a node of a contents stream: update the stream state
+     * and call the corresponding category function.
+     * \param streamState Stream state, pNode being the node to analyse.
+     * \param currentPath Current path.
+     * \param resourcesStack Stack of resources (forms XObjects).
+     * \return Last node which has been analysed (path construction
+     * nodes are analysed together).
+     */
+    PdfeContentsStream::Node* analyseNode( PdfeStreamState& streamState,
+                                           PdfePath& currentPath,
+                                           std::vector<PdfeResources>& resourcesStack );
+    /** Recursive streaming analysis of a canvas.
+     * \param pcanvas Canvas whose contents stream is analysed.
+     * \param loadFormsStream Are streams from XObjects forms also analysed?
+     * \param window Window of nodes not analysed yet.
+     * \param streamState Stream state.
+     * \param currentPath Current path.
+     * \param resourcesStack Stack of resources (forms XObjects).
+     */
+    void analyseCanvas( PoDoFo::PdfCanvas* pcanvas,
+                        bool loadFormsStream,
+                        PdfeContentsStream& window,
+                        PdfeStreamState& streamState,
+                        PdfePath& currentPath,
+                        std::vector<PdfeResources>& resourcesStack );
+    /** Analyse every node in the window and then clear it.
+     * \param window Window of nodes not analysed yet.
+     * \param streamState Stream state.
+     * \param currentPath Current path.
+     * \param resourcesStack Stack of resources (forms XObjects).
+     */
+    void analyseWindow( PdfeContentsStream& window,
+                        PdfeStreamState& streamState,
+                        PdfePath& currentPath,
+                        std::vector<PdfeResources>& resourcesStack );
+
+protected:
 
     // PdfeContentsAnalysis interface.
     virtual void fGeneralGState( const PdfeStreamState& streamState );
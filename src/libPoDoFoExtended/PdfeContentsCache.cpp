@@ -0,0 +1,230 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+
+#include "PdfeContentsCache.h"
+#include "PdfeContentsStream.h"
+#include "PdfeResources.h"
+#include "PdfeUtils.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <QtCore>
+#include <QsLog/QsLog.h>
+#include <podofo/podofo.h>
+
+using namespace PoDoFo;
+
+namespace PoDoFoExtended {
+
+PdfeContentsCache::PdfeContentsCache( const QString& cacheDir ) :
+    m_cacheDir( cacheDir ),
+    m_maxSize( 0 ),
+    m_size( -1 )
+{
+}
+PdfeContentsCache::PdfeContentsCache( const PdfeContentsCache& rhs ) :
+    m_cacheDir( rhs.m_cacheDir ),
+    m_maxSize( rhs.m_maxSize ),
+    m_size( -1 )
+{
+}
+PdfeContentsCache& PdfeContentsCache::operator=( const PdfeContentsCache& rhs )
+{
+    if( this != &rhs ) {
+        this->setCacheDirectory( rhs.m_cacheDir );
+        m_maxSize = rhs.m_maxSize;
+    }
+    return *this;
+}
+void PdfeContentsCache::setCacheDirectory( const QString& cacheDir )
+{
+    QMutexLocker locker( &m_sizeMutex );
+    m_cacheDir = cacheDir;
+    m_size = -1;
+}
+
+QByteArray PdfeContentsCache::key( PdfCanvas* pcanvas ) const
+{
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    std::set<PdfReference> visited;
+    this->hashContents( hash, pcanvas->GetContents(), pcanvas->GetResources(), visited );
+    return hash.result().toHex();
+}
+void PdfeContentsCache::hashContents( QCryptographicHash& hash,
+                                      PdfObject* pContents,
+                                      PdfObject* pResources,
+                                      std::set<PdfReference>& visited ) const
+{
+    std::string str;
+    // Contents streams: dictionary and raw data.
+    std::vector<PdfObject*> pStreams;
+    if( pContents && pContents->IsArray() ) {
+        PdfArray& contentsArray = pContents->GetArray();
+        for( size_t i = 0 ; i < contentsArray.size() ; ++i ) {
+            pStreams.push_back( PdfeIndirectObject( &contentsArray[i], pContents->GetOwner() ) );
+        }
+    }
+    else if( pContents && pContents->HasStream() ) {
+        pStreams.push_back( pContents );
+    }
+    for( size_t i = 0 ; i < pStreams.size() ; ++i ) {
+        if( !pStreams[i] || !pStreams[i]->HasStream() ) {
+            continue;
+        }
+        pStreams[i]->ToString( str );
+        hash.addData( str.data(), str.size() );
+
+        char* pBuffer;
+        pdf_long length;
+        pStreams[i]->GetStream()->GetCopy( &pBuffer, &length );
+        boost::shared_ptr<char> spBuffer( pBuffer, free_ptr_fctor<char>() );
+        hash.addData( pBuffer, length );
+    }
+    if( !pResources ) {
+        return;
+    }
+    // Resources: resolved sub-dictionaries.
+    for( size_t i = 0 ; i < PdfeResourcesType::size() ; ++i ) {
+        PdfObject* pResSubDict = pResources->GetIndirectKey( PdfeResourcesType::str( PdfeResourcesType::Enum( i ) ) );
+        if( pResSubDict ) {
+            pResSubDict->ToString( str );
+            hash.addData( PdfeResourcesType::str( PdfeResourcesType::Enum( i ) ) );
+            hash.addData( str.data(), str.size() );
+        }
+    }
+    // Form XObjects, which are loaded in the contents stream.
+    PdfObject* pXObjects = pResources->GetIndirectKey( "XObject" );
+    if( !pXObjects || !pXObjects->IsDictionary() ) {
+        return;
+    }
+    const TKeyMap& keys = pXObjects->GetDictionary().GetKeys();
+    for( TKeyMap::const_iterator it = keys.begin() ; it != keys.end() ; ++it ) {
+        if( !it->second->IsReference() || visited.count( it->second->GetReference() ) ) {
+            continue;
+        }
+        visited.insert( it->second->GetReference() );
+        PdfObject* pXObject = pXObjects->GetOwner()->GetObject( it->second->GetReference() );
+        PdfObject* pSubtype = pXObject ? pXObject->GetIndirectKey( "Subtype" ) : NULL;
+        if( pSubtype && pSubtype->IsName() && pSubtype->GetName() == PdfName( "Form" ) ) {
+            this->hashContents( hash, pXObject, pXObject->GetIndirectKey( "Resources" ), visited );
+        }
+    }
+}
+
+bool PdfeContentsCache::load( const QByteArray& key,
+                              PdfeContentsStream& stream,
+                              const PdfVecObjects* pOwner ) const
+{
+    if( !this->isEnabled() ) {
+        return false;
+    }
+    QFile file( this->entryFilename( key ) );
+    if( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+    // Memory-mapped file, or simple read if mapping is not available.
+    bool loaded = false;
+    QByteArray data;
+    uchar* pdata = file.map( 0, file.size() );
+    try {
+        if( pdata ) {
+            loaded = stream.loadBinaryData( reinterpret_cast<const char*>( pdata ), file.size(), pOwner );
+        }
+        else {
+            data = file.readAll();
+            loaded = stream.loadBinaryData( data.constData(), data.size(), pOwner );
+        }
+    }
+    catch( const PdfError& ) {
+        // Reported as a cache miss: the page is parsed again.
+        stream.init();
+        loaded = false;
+    }
+    if( pdata ) {
+        file.unmap( pdata );
+    }
+    if( !loaded ) {
+        QLOG_WARN() << QString( "<PdfeContentsCache> Invalid cache entry removed (key: %1)." )
+                       .arg( QString( key ) ).toAscii().constData();
+        file.close();
+        file.remove();
+    }
+    return loaded;
+}
+bool PdfeContentsCache::store( const QByteArray& key,
+                               const PdfeContentsStream& stream ) const
+{
+    if( !this->isEnabled() || !QDir().mkpath( m_cacheDir ) ) {
+        return false;
+    }
+    PdfeData data = stream.binaryData();
+
+    // Temporary file, renamed afterwards (concurrent runs may share the cache).
+    QTemporaryFile file( QDir( m_cacheDir ).filePath( QString( key ) + ".XXXXXX" ) );
+    file.setAutoRemove( false );
+    if( !file.open() ) {
+        return false;
+    }
+    bool written = ( file.write( data.data(), data.size() ) == qint64( data.size() ) );
+    file.close();
+
+    QString filename = this->entryFilename( key );
+    QFile::remove( filename );
+    if( !written || !file.rename( filename ) ) {
+        file.remove();
+        QLOG_WARN() << QString( "<PdfeContentsCache> Can not write cache entry (key: %1)." )
+                       .arg( QString( key ) ).toAscii().constData();
+        return false;
+    }
+    this->updateSize( data.size() );
+    return true;
+}
+QString PdfeContentsCache::entryFilename( const QByteArray& key ) const
+{
+    return QDir( m_cacheDir ).filePath( QString( key ) + ".pdfecs" );
+}
+void PdfeContentsCache::updateSize( qint64 entrySize ) const
+{
+    if( m_maxSize <= 0 ) {
+        return;
+    }
+    QMutexLocker locker( &m_sizeMutex );
+    // Directory only scanned when unknown or full (other runs may share it).
+    if( m_size >= 0 ) {
+        m_size += entrySize;
+        if( m_size <= m_maxSize ) {
+            return;
+        }
+    }
+    QDir dir( m_cacheDir );
+    QFileInfoList entries = dir.entryInfoList( QStringList( "*.pdfecs" ), QDir::Files,
+                                               QDir::Time | QDir::Reversed );
+    m_size = 0;
+    for( int i = 0 ; i < entries.size() ; ++i ) {
+        m_size += entries[i].size();
+    }
+    if( m_size <= m_maxSize ) {
+        return;
+    }
+    // Remove oldest entries, down to 3/4 of the maximum size (no scan at every store).
+    int nbRemoved = 0;
+    for( int i = 0 ; i < entries.size() && m_size > m_maxSize / 4 * 3 ; ++i ) {
+        if( QFile::remove( entries[i].filePath() ) ) {
+            m_size -= entries[i].size();
+            ++nbRemoved;
+        }
+    }
+    QLOG_INFO() << QString( "<PdfeContentsCache> Cache directory trimmed (%1 entries removed)." )
+                   .arg( nbRemoved ).toAscii().constData();
+}
+
+}
@@ -0,0 +1,128 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+
+#ifndef PDFECONTENTSCACHE_H
+#define PDFECONTENTSCACHE_H
+
+#include <set>
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+#include <podofo/base/PdfReference.h>
+
+namespace PoDoFo {
+class PdfCanvas;
+class PdfObject;
+class PdfVecObjects;
+}
+class QCryptographicHash;
+
+namespace PoDoFoExtended {
+
+class PdfeContentsStream;
+
+//**********************************************************//
+//                     PdfeContentsCache                    //
+//**********************************************************//
+/** On-disk cache of parsed contents streams. Each entry contains the
+ * binary representation of a PdfeContentsStream (c.f. binaryData) and is
+ * keyed by a hash of the canvas contents objects (streams, resources and
+ * form XObjects used), so that it can be shared between runs and documents.
+ * Entries are loaded through memory-mapped files. The cache is disabled
+ * if no directory is set. If a maximum size is set, the oldest entries are
+ * removed once the directory grows over it.
+ */
+class PdfeContentsCache
+{
+public:
+    /** Create a contents cache.
+     * \param cacheDir Directory where entries are stored (empty: disabled).
+     */
+    PdfeContentsCache( const QString& cacheDir = QString() );
+    /** Copy constructor (the size of the directory is recomputed).
+     */
+    PdfeContentsCache( const PdfeContentsCache& rhs );
+    /** Assignment operator (the size of the directory is recomputed).
+     */
+    PdfeContentsCache& operator=( const PdfeContentsCache& rhs );
+
+    /** Compute the key corresponding to a canvas. The hash covers contents
+     * streams, resources and (recursively) form XObjects streams.
+     * \param pcanvas Canvas (page, form, ...).
+     * \return Key (hexadecimal hash).
+     */
+    QByteArray key( PoDoFo::PdfCanvas* pcanvas ) const;
+    /** Load a contents stream from the cache.
+     * \param key Key of the entry.
+     * \param stream Contents stream to load.
+     * \param pOwner Collection of objects used to resolve references.
+     * \return True if the entry exists and has been correctly loaded.
+     */
+    bool load( const QByteArray& key,
+               PdfeContentsStream& stream,
+               const PoDoFo::PdfVecObjects* pOwner ) const;
+    /** Store a contents stream in the cache. The entry is written
+     * in a temporary file which is then renamed.
+     * \param key Key of the entry.
+     * \param stream Contents stream to store.
+     * \return True if the entry has been written.
+     */
+    bool store( const QByteArray& key,
+                const PdfeContentsStream& stream ) const;
+
+public:
+    /// Is the cache enabled?
+    bool isEnabled() const              {   return !m_cacheDir.isEmpty();   }
+    /// Cache directory.
+    QString cacheDirectory() const      {   return m_cacheDir;  }
+    /// Set cache directory (empty: disabled).
+    void setCacheDirectory( const QString& cacheDir );
+    /// Maximum size of the cache directory, in bytes (0: unlimited).
+    qint64 maxSize() const              {   return m_maxSize;   }
+    /// Set maximum size of the cache directory, in bytes (0: unlimited, default).
+    void setMaxSize( qint64 maxSize )   {   m_maxSize = maxSize;    }
+
+private:
+    /** Add contents and resources objects to a hash.
+     * \param hash Hash object to update.
+     * \param pContents Contents object (stream or array of streams).
+     * \param pResources Resources object.
+     * \param visited Set of form XObjects already added.
+     */
+    void hashContents( QCryptographicHash& hash,
+                       PoDoFo::PdfObject* pContents,
+                       PoDoFo::PdfObject* pResources,
+                       std::set<PoDoFo::PdfReference>& visited ) const;
+    /// Filename of an entry.
+    QString entryFilename( const QByteArray& key ) const;
+    /** Account for a new entry in the size of the directory, and remove
+     * the oldest entries if it exceeds the maximum size.
+     * \param entrySize Size of the entry written.
+     */
+    void updateSize( qint64 entrySize ) const;
+
+private:
+    /// Cache directory.
+    QString  m_cacheDir;
+    /// Maximum size of the directory (0: unlimited).
+    qint64  m_maxSize;
+    /// Size of the directory, as last computed (-1: unknown).
+    mutable qint64  m_size;
+    /// Mutex protecting the size of the directory.
+    mutable QMutex  m_sizeMutex;
+};
+
+}
+
+#endif // PDFECONTENTSCACHE_H
@@ -12,9 +12,13 @@
 #include "PdfeContentsStream.h"
 
 #include "PdfeGraphicsState.h"
+#include "PdfeProfiler.h"
 #include "PdfeStreamTokenizer.h"
 #include "PdfeUtils.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include <QtCore>
 #include <QsLog/QsLog.h>
 #include <podofo/podofo.h>
@@ -23,6 +27,24 @@ using namespace PoDoFo;
 
 namespace PoDoFoExtended {
 
+const char* PdfeContentsWarning::str( PdfeContentsWarning::Enum kind )
+{
+    static const char* descriptions[] = {
+        "Closing 'Q' operator with no opening 'q'",
+        "Begin subpath a construction operator different from 'm/re'",
+        "Path painting with no path defined",
+        "Closing 'ET' operator with no opening 'BT'",
+        "Closing 'EI' operator with no opening 'BI'",
+        "Closing 'EX' operator with no opening 'BX'",
+        "Postscript XObject inserted. Currently not supported",
+        "Unknown XObject type",
+        "XObject not found in the PDF document",
+        "Unknown graphics operator in the contents stream",
+        "Path constructed but not painted"
+    };
+    return descriptions[kind];
+}
+
 //**********************************************************//
 //                     PdfeContentsStream                   //
 //**********************************************************//
@@ -30,7 +52,8 @@ PdfeContentsStream::PdfeContentsStream() :
     m_pFirstNode( NULL ), m_pLastNode( NULL ),
     m_nbNodes( 0 ), m_maxNodeID( 0 ),
     m_pInitialGState( new PdfeGraphicsState() ),
-    m_resources()
+    m_resources(),
+    m_nbWarnings( PdfeContentsWarning::size(), 0 )
 {
 }
 void PdfeContentsStream::init()
@@ -44,13 +67,15 @@ void PdfeContentsStream::init()
     m_maxNodeID = 0;
     m_pInitialGState->init();
     m_resources.init();
+    m_nbWarnings.assign( PdfeContentsWarning::size(), 0 );
 }
 PdfeContentsStream::PdfeContentsStream( const PdfeContentsStream& rhs ) :
     m_pFirstNode( NULL ), m_pLastNode( NULL ),
     m_nbNodes( rhs.m_nbNodes ),
     m_maxNodeID( rhs.m_maxNodeID ),
     m_pInitialGState( new PdfeGraphicsState( *(rhs.m_pInitialGState) ) ),
-    m_resources( rhs.m_resources )
+    m_resources( rhs.m_resources ),
+    m_nbWarnings( rhs.m_nbWarnings )
 {
     // Copy nodes.
     this->copyNodes( rhs );
@@ -67,6 +92,7 @@ PdfeContentsStream& PdfeContentsStream::operator=( const PdfeContentsStream& rhs
     m_maxNodeID = rhs.m_maxNodeID;
     m_pInitialGState->operator=( *(rhs.m_pInitialGState) );
     m_resources = rhs.m_resources;
+    m_nbWarnings = rhs.m_nbWarnings;
     this->copyNodes( rhs );
 
     return *this;
@@ -335,21 +361,35 @@ PdfeContentsStream::Node* PdfeContentsStream::erase( PdfeContentsStream::Node* p
     return this->erase( pnode, false );
 }
 
-void PdfeContentsStream::load( PdfCanvas* pcanvas, bool loadFormsStream, bool fixStream )
+void PdfeContentsStream::load( PdfCanvas* pcanvas,
+                               bool loadFormsStream,
+                               bool fixStream,
+                               PdfeStreamDecoder* pDecoder,
+                               QMutex* pMutex,
+                               const QAtomicInt* pAbort )
 {
+    PDFE_PROFILE_SCOPE( "contents.load" );
     // Reinitialize the contents stream.
     this->init();
     // Load canvas and set initial resources.
-    this->load( pcanvas, loadFormsStream, fixStream, NULL, std::string() );
+    this->load( pcanvas, loadFormsStream, fixStream, NULL, std::string(), pDecoder, pMutex, pAbort );
+    this->logWarningsSummary();
+    PDFE_PROFILE_VALUE( "contents.nodes", double( m_nbNodes ) );
 }
 PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                                                     bool loadFormsStream,
                                                     bool fixStream,
                                                     PdfeContentsStream::Node* pNodePrev,
-                                                    const std::string& resSuffix )
+                                                    const std::string& resSuffix,
+                                                    PdfeStreamDecoder* pDecoder,
+                                                    QMutex* pMutex,
+                                                    const QAtomicInt* pAbort )
 {
+    // PoDoFo objects accessed: streams decoding and resources.
+    QMutexLocker locker( pMutex );
+    checkAbort( pAbort );
     // Contents stream tokenizer.
-    PdfeStreamTokenizer tokenizer( pcanvas );
+    PdfeStreamTokenizer tokenizer( pcanvas, pDecoder );
     // Tmp variable to store node informations.
     EPdfContentsType tokenType;
     std::string strVariant;
@@ -374,6 +414,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
     //PdfeResources resources( resSuffix );
     //resources.push_back( pcanvas->GetResources() );
     //resources.append( PdfeResources( pcanvas->GetResources() ) );
+    locker.unlock();
 
     // Analyse page stream / Also known as the big dirty loop !
     while( tokenizer.ReadNext( tokenType, goperator, strVariant ) ) {
@@ -399,8 +440,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                         pNodes_q.pop_back();
                     }
                     else {
-                        QLOG_WARN() << QString( "<PdfeContentsStream> Missing closing 'Q' operator in a contents stream (node ID: %1)." )
-                                       .arg( pNode->id() ).toAscii().constData();
+                        this->warning( PdfeContentsWarning::UnmatchedQ, pNode->id() );
                     }
                 }
             }
@@ -410,8 +450,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                     pNode_BeginSubpath = pNode;
                     if( goperator.type() != PdfeGOperator::m &&
                             goperator.type() != PdfeGOperator::re ) {
-                        QLOG_WARN() << QString( "<PdfeContentsStream> Begin subpath a construction operator different from 'm/re' (node ID: %1)." )
-                                       .arg( pNode->id() ).toAscii().constData();
+                        this->warning( PdfeContentsWarning::BeginSubpath, pNode->id() );
                         // TODO: keep track of the current point and add a node with 'm'.
                     }
                 }
@@ -431,8 +470,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                     pNodes_path.clear();
                 }
                 else {
-                    QLOG_WARN() << QString( "<PdfeContentsStream> Path painting with no path defined (node ID: %1)." )
-                                   .arg( pNode->id() ).toAscii().constData();
+                    this->warning( PdfeContentsWarning::PaintingNoPath, pNode->id() );
                 }
             }
             else if( goperator.category() == PdfeGCategory::TextObjects ) {
@@ -446,8 +484,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                         pNodes_BT.pop_back();
                     }
                     else {
-                        QLOG_WARN() << QString( "<PdfeContentsStream> Missing closing 'BT' operator in a contents stream (node ID: %1)." )
-                                       .arg( pNode->id() ).toAscii().constData();
+                        this->warning( PdfeContentsWarning::UnmatchedET, pNode->id() );
                     }
                 }
             }
@@ -462,8 +499,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                         pNodes_BI.pop_back();
                     }
                     else {
-                        QLOG_WARN() << QString( "<PdfeContentsStream> Missing closing 'BI' operator in a contents stream (node ID: %1)." )
-                                       .arg( pNode->id() ).toAscii().constData();
+                        this->warning( PdfeContentsWarning::UnmatchedEI, pNode->id() );
                     }
                 }
             }
@@ -478,8 +514,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                         pNodes_BX.pop_back();
                     }
                     else {
-                        QLOG_WARN() << QString( "<PdfeContentsStream> Missing closing 'BX' operator in a contents stream (node ID: %1)." )
-                                       .arg( pNode->id() ).toAscii().constData();
+                        this->warning( PdfeContentsWarning::UnmatchedEX, pNode->id() );
                     }
                 }
             }
@@ -487,6 +522,8 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
             else if( goperator.category() == PdfeGCategory::XObjects ) {
                 // Get XObject pointer and subtype.
                 std::string xobjName = goperands.back().to_string().substr( 1 ) + resSuffix;
+                QMutexLocker xobjLocker( pMutex );
+                checkAbort( pAbort );
                 PdfObject* pXObject = m_resources.getIndirectKey( PdfeResourcesType::XObject, xobjName );
                 // The XObject exists...
                 if( pXObject ) {
@@ -518,10 +555,12 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                                     pNode->setOperands( formTransMat );
                                 }
                             }
-                            // Load form XObject, with new suffix.
+                            // Load form XObject, with new suffix (locks on its own).
+                            xobjLocker.unlock();
                             std::ostringstream  suffixStream;
                             suffixStream << resSuffix << "_form" << nbForms;
-                            pNode = this->load( &xobject, loadFormsStream, fixStream, pNode, suffixStream.str() );
+                            pNode = this->load( &xobject, loadFormsStream, fixStream, pNode, suffixStream.str(),
+                                                pDecoder, pMutex, pAbort );
                             // Restore the current graphics state on the stack 'Q'.
                             pNode = this->insert( Node( 0, PdfeGraphicOperator( PdfeGOperator::Q ) ),
                                                   pNode );
@@ -539,16 +578,14 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                     }
                     else if( xobjSubtype == "PS" ) {
                         pNode->setXObject( PdfeXObjectType::PS, pXObject );
-                        QLOG_WARN() << QString( "<PdfeContentsStream> Postscript XObject inserted. Currently not supported. (node ID: %1)." )
-                                       .arg( pNode->id() ).toAscii().constData();
+                        this->warning( PdfeContentsWarning::PSXObject, pNode->id() );
                     }
                     else if( xobjSubtype == "Image" ) {
                         pNode->setXObject( PdfeXObjectType::Image, pXObject );
                     }
                     else {
                         pNode->setXObject( PdfeXObjectType::Unknown, pXObject );
-                        QLOG_WARN() << QString( "<PdfeContentsStream> Unknown XObject type. (node ID: %1)." )
-                                       .arg( pNode->id() ).toAscii().constData();
+                        this->warning( PdfeContentsWarning::UnknownXObject, pNode->id() );
                         if( fixStream ) {
                             this->erase( pNode, false );
                             pNode = pNodePrev;
@@ -558,8 +595,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                 // No XObject found.
                 else {
                     pNode->setXObject( PdfeXObjectType::Unknown, pXObject );
-                    QLOG_WARN() << QString( "<PdfeContentsStream> XObject not found in the PDF document. (node ID: %1)." )
-                                   .arg( pNode->id() ).toAscii().constData();
+                    this->warning( PdfeContentsWarning::XObjectNotFound, pNode->id() );
                     if( fixStream ) {
                         this->erase( pNode, false );
                         pNode = pNodePrev;
@@ -567,8 +603,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                 }
             }
             else if( goperator.type() == PdfeGOperator::Unknown ) {
-                QLOG_WARN() << QString( "<PdfeContentsStream> Unknown graphics operator in the contents stream (node ID: %1)." )
-                               .arg( pNode->id() ).toAscii().constData();
+                this->warning( PdfeContentsWarning::UnknownOperator, pNode->id() );
             }
 
             // Clear path construction stack.
@@ -577,8 +612,7 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
                     goperator.category() != PdfeGCategory::ClippingPath &&
                     !pNodes_path.empty() ) {
                 pNodes_path.clear();
-                QLOG_WARN() << QString( "<PdfeContentsStream> Path constructed but not painted (node ID: %1)." )
-                               .arg( pNode->id() ).toAscii().constData();
+                this->warning( PdfeContentsWarning::PathNotPainted, pNode->id() );
 
             }
             if( goperator.category() != PdfeGCategory::PathConstruction ) {
@@ -595,6 +629,51 @@ PdfeContentsStream::Node* PdfeContentsStream::load( PdfCanvas* pcanvas,
     }
     return pNodePrev;
 }
+void PdfeContentsStream::checkAbort( const QAtomicInt* pAbort )
+{
+    if( pAbort && int( *pAbort ) ) {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Contents stream loading aborted." );
+    }
+}
+
+void PdfeContentsStream::warning( PdfeContentsWarning::Enum kind, pdfe_nodeid nodeid )
+{
+    // Malformed streams can raise thousands of warnings: only log the first ones.
+    if( ++m_nbWarnings[kind] <= MaxWarningsLogged ) {
+        QLOG_WARN() << QString( "<PdfeContentsStream> %1 (node ID: %2)." )
+                       .arg( PdfeContentsWarning::str( kind ) ).arg( nodeid ).toAscii().constData();
+    }
+}
+void PdfeContentsStream::logWarningsSummary() const
+{
+    size_t nbWarnings = this->nbWarnings();
+    if( !nbWarnings ) {
+        return;
+    }
+    PDFE_PROFILE_COUNTER( "contents.warnings", qint64( nbWarnings ) );
+    // Summary only if warnings were not logged.
+    if( *std::max_element( m_nbWarnings.begin(), m_nbWarnings.end() ) <= MaxWarningsLogged ) {
+        return;
+    }
+    QString details;
+    for( size_t i = 0 ; i < m_nbWarnings.size() ; ++i ) {
+        if( m_nbWarnings[i] ) {
+            details += QString( "%1%2: %3" ).arg( details.isEmpty() ? "" : "; " )
+                       .arg( PdfeContentsWarning::str( PdfeContentsWarning::Enum( i ) ) )
+                       .arg( m_nbWarnings[i] );
+        }
+    }
+    QLOG_WARN() << QString( "<PdfeContentsStream> %1 warning(s) while loading the contents stream (%2)." )
+                   .arg( nbWarnings ).arg( details ).toAscii().constData();
+}
+size_t PdfeContentsStream::nbWarnings() const
+{
+    size_t nbWarnings = 0;
+    for( size_t i = 0 ; i < m_nbWarnings.size() ; ++i ) {
+        nbWarnings += m_nbWarnings[i];
+    }
+    return nbWarnings;
+}
 
 void PdfeContentsStream::save( PdfCanvas* pcanvas )
 {
@@ -618,15 +697,36 @@ void PdfeContentsStream::save( PdfCanvas* pcanvas )
         pstream->BeginAppend( true );
         pstream->EndAppend();
     }
-    // Get stream contents data.
-    PdfeData data;
-    PdfeDataStream dataStream( data );
-    dataStream << (*this) << std::flush;
-
-    // Set page contents stream.
+    // Set page contents stream: nodes are written into a chunk buffer
+    // which is flushed to the Flate encoder of the PoDoFo stream.
     TVecFilters vecFilters;
     vecFilters.push_back( ePdfFilter_FlateDecode );
-    pstream->Set( data.data(), data.size(), vecFilters );
+    pstream->BeginAppend( vecFilters, true );
+
+    const size_t chunkSize = 65536;
+    std::vector<char> chunk( chunkSize );
+    size_t chunkUsed = 0;
+    Node* pnode = m_pFirstNode;
+    while( pnode ) {
+        size_t nodeSize = nodeDataSize( *pnode );
+        if( chunkUsed + nodeSize > chunk.size() ) {
+            if( chunkUsed ) {
+                pstream->Append( &chunk[0], chunkUsed );
+                chunkUsed = 0;
+            }
+            // Large inline image...
+            if( nodeSize > chunk.size() ) {
+                chunk.resize( nodeSize );
+            }
+        }
+        writeNodeData( *pnode, &chunk[0] + chunkUsed );
+        chunkUsed += nodeSize;
+        pnode = pnode->next();
+    }
+    if( chunkUsed ) {
+        pstream->Append( &chunk[0], chunkUsed );
+    }
+    pstream->EndAppend();
 
     // Save contents resources.
     m_resources.save( pcanvas->GetResources() );
@@ -634,11 +734,70 @@ void PdfeContentsStream::save( PdfCanvas* pcanvas )
 
 PdfeData PdfeContentsStream::data() const
 {
-    PdfeData data;
-    PdfeDataStream dataStream( data );
-    dataStream << (*this) << std::flush;
+    // Pre-sized buffer, nodes directly written inside.
+    PdfeData data( this->dataSize() );
+    if( !data.empty() ) {
+        char* pbuffer = data.data();
+        Node* pnode = m_pFirstNode;
+        while( pnode ) {
+            pbuffer = writeNodeData( *pnode, pbuffer );
+            pnode = pnode->next();
+        }
+    }
     return data;
 }
+size_t PdfeContentsStream::memoryFootprint() const
+{
+    size_t footprint = sizeof( PdfeContentsStream ) + sizeof( PdfeGraphicsState );
+    Node* pnode = m_pFirstNode;
+    while( pnode ) {
+        footprint += pnode->memoryFootprint();
+        pnode = pnode->next();
+    }
+    return footprint;
+}
+size_t PdfeContentsStream::dataSize() const
+{
+    size_t size = 0;
+    Node* pnode = m_pFirstNode;
+    while( pnode ) {
+        size += nodeDataSize( *pnode );
+        pnode = pnode->next();
+    }
+    return size;
+}
+size_t PdfeContentsStream::nodeDataSize( const Node& node )
+{
+    // Same format as operator<<: operands and operator, separated by spaces.
+    if( node.type() == PdfeGOperator::Unknown ) {
+        return 0;
+    }
+    size_t size = std::strlen( node.goperator().str() ) + 1;
+    for( size_t i = 0 ; i < node.m_goperands.size() ; ++i ) {
+        size += node.m_goperands[i].size() + 1;
+    }
+    return size;
+}
+char* PdfeContentsStream::writeNodeData( const Node& node, char* pbuffer )
+{
+    if( node.type() == PdfeGOperator::Unknown ) {
+        return pbuffer;
+    }
+    for( size_t i = 0 ; i < node.m_goperands.size() ; ++i ) {
+        const PdfeData& operand = node.m_goperands[i];
+        if( !operand.empty() ) {
+            std::memcpy( pbuffer, operand.data(), operand.size() );
+            pbuffer += operand.size();
+        }
+        *pbuffer++ = ' ';
+    }
+    const char* pstr = node.goperator().str();
+    size_t length = std::strlen( pstr );
+    std::memcpy( pbuffer, pstr, length );
+    pbuffer += length;
+    *pbuffer++ = '\n';
+    return pbuffer;
+}
 std::ostream& PdfeContentsStream::toTextStream( std::ostream& os ) const
 {
     // Write down nodes description.
@@ -656,6 +815,253 @@ std::string PdfeContentsStream::toText() const
     return ostr.str();
 }
 
+//**********************************************************//
+//             PdfeContentsStream binary format             //
+//**********************************************************//
+namespace {
+/// Binary format magic header and version.
+const char BinaryMagic[] = "PdfeCS";
+const pdf_uint32 BinaryVersion = 2;
+/// Minimal size of a node record (ID, operator, XObject info, links, operands count).
+const size_t BinaryNodeMinSize = 20;
+/// Maximum ratio between the maximum node ID and the number of nodes (IDs
+/// of deleted nodes are not reused): bounds the IDs table of corrupted data.
+const size_t BinaryMaxNodeIDRatio = 4;
+
+/// Append a POD value to binary data.
+template <class T>
+inline void binaryWrite( PdfeData& data, const T& value )
+{
+    const char* pvalue = reinterpret_cast<const char*>( &value );
+    data.insert( data.end(), pvalue, pvalue + sizeof(T) );
+}
+/// Append a block of bytes, prefixed by its length.
+inline void binaryWrite( PdfeData& data, const char* pbytes, size_t length )
+{
+    binaryWrite( data, pdf_uint32( length ) );
+    data.insert( data.end(), pbytes, pbytes + length );
+}
+/// Read a POD value from binary data. Return false if not enough data.
+template <class T>
+inline bool binaryRead( const char*& pdata, const char* pend, T& value )
+{
+    if( pend - pdata < std::ptrdiff_t( sizeof(T) ) ) {
+        return false;
+    }
+    std::memcpy( &value, pdata, sizeof(T) );
+    pdata += sizeof(T);
+    return true;
+}
+/// Read a length-prefixed block of bytes. Return false if not enough data.
+inline bool binaryRead( const char*& pdata, const char* pend,
+                        const char*& pbytes, pdf_uint32& length )
+{
+    if( !binaryRead( pdata, pend, length ) || pend - pdata < std::ptrdiff_t( length ) ) {
+        return false;
+    }
+    pbytes = pdata;
+    pdata += length;
+    return true;
+}
+}
+
+PdfeData PdfeContentsStream::binaryData() const
+{
+    PdfeData data;
+    // Header: magic, version, number of nodes and max ID.
+    data.insert( data.end(), BinaryMagic, BinaryMagic + sizeof(BinaryMagic) - 1 );
+    binaryWrite( data, BinaryVersion );
+    binaryWrite( data, pdf_uint32( m_nbNodes ) );
+    binaryWrite( data, pdf_uint32( m_maxNodeID ) );
+    // Warnings raised by the loading.
+    for( size_t i = 0 ; i < m_nbWarnings.size() ; ++i ) {
+        binaryWrite( data, pdf_uint32( m_nbWarnings[i] ) );
+    }
+
+    // Resources, written as a PDF dictionary.
+    PdfObject resourcesObj( ( PdfDictionary() ) );
+    PdfeResources resources( m_resources );
+    resources.save( &resourcesObj );
+    std::string resourcesStr;
+    resourcesObj.ToString( resourcesStr );
+    binaryWrite( data, resourcesStr.data(), resourcesStr.size() );
+
+    // Nodes: ID, operator, links and operands.
+    Node* pnode = m_pFirstNode;
+    while( pnode ) {
+        pdf_uint32 link1 = NodeIDUndefined();
+        pdf_uint32 link2 = NodeIDUndefined();
+        pdf_uint8 xobjType = 0;
+        pdf_uint8 formFlags = 0;
+
+        PdfeGOperator::Enum type = pnode->type();
+        if( type == PdfeGOperator::Do ) {
+            xobjType = pnode->m_formXObject.type;
+            formFlags = ( pnode->m_formXObject.isLoaded ? 1 : 0 ) |
+                    ( pnode->m_formXObject.isOpening ? 2 : 0 ) |
+                    ( pnode->m_formXObject.isClosing ? 4 : 0 );
+            if( pnode->m_pXObject ) {
+                link1 = pnode->m_pXObject->Reference().ObjectNumber();
+                link2 = pnode->m_pXObject->Reference().GenerationNumber();
+            }
+        }
+        else if( pnode->category() == PdfeGCategory::PathConstruction ) {
+            if( pnode->m_pPaintingNode ) {
+                link1 = pnode->m_pPaintingNode->id();
+            }
+            if( pnode->m_pBeginSubpathNode ) {
+                link2 = pnode->m_pBeginSubpathNode->id();
+            }
+        }
+        else if( pnode->isOpeningNode() || pnode->isClosingNode() ) {
+            // Opening and closing nodes pointers share the same memory.
+            if( pnode->m_pOpeningNode ) {
+                link1 = pnode->m_pOpeningNode->id();
+            }
+        }
+        binaryWrite( data, pdf_uint32( pnode->id() ) );
+        binaryWrite( data, pdf_uint16( type ) );
+        binaryWrite( data, xobjType );
+        binaryWrite( data, formFlags );
+        binaryWrite( data, link1 );
+        binaryWrite( data, link2 );
+        binaryWrite( data, pdf_uint32( pnode->nbOperands() ) );
+        for( size_t i = 0 ; i < pnode->nbOperands() ; ++i ) {
+            const PdfeData& operand = pnode->m_goperands[i];
+            binaryWrite( data, operand.empty() ? static_cast<const char*>( NULL ) : operand.data(),
+                         operand.size() );
+        }
+        pnode = pnode->next();
+    }
+    return data;
+}
+bool PdfeContentsStream::loadBinaryData( const char* pdata, size_t length,
+                                         const PdfVecObjects* pOwner )
+{
+    this->init();
+    const char* pend = pdata + length;
+
+    // Check header.
+    const size_t magicLength = sizeof(BinaryMagic) - 1;
+    pdf_uint32 version, nbNodes, maxNodeID;
+    if( length < magicLength || std::memcmp( pdata, BinaryMagic, magicLength ) ) {
+        return false;
+    }
+    pdata += magicLength;
+    if( !binaryRead( pdata, pend, version ) || version != BinaryVersion ||
+            !binaryRead( pdata, pend, nbNodes ) ||
+            !binaryRead( pdata, pend, maxNodeID ) ||
+            nbNodes > maxNodeID || nbNodes > length / BinaryNodeMinSize ||
+            maxNodeID > BinaryMaxNodeIDRatio * ( size_t( nbNodes ) + 1 ) ) {
+        return false;
+    }
+    // Warnings.
+    for( size_t i = 0 ; i < m_nbWarnings.size() ; ++i ) {
+        pdf_uint32 nbWarnings;
+        if( !binaryRead( pdata, pend, nbWarnings ) ) {
+            this->init();
+            return false;
+        }
+        m_nbWarnings[i] = nbWarnings;
+    }
+    // Resources.
+    const char* pbytes;
+    pdf_uint32 nbytes;
+    if( !binaryRead( pdata, pend, pbytes, nbytes ) ) {
+        return false;
+    }
+    try {
+        PdfVariant resourcesVariant;
+        PdfTokenizer tokenizer( pbytes, nbytes );
+        tokenizer.GetNextVariant( resourcesVariant, NULL );
+        PdfObject resourcesObj( resourcesVariant );
+        m_resources.load( &resourcesObj );
+        m_resources.setOwner( pOwner );
+    }
+    catch( const PdfError& ) {
+        // Corrupted resources: treated as invalid data.
+        this->init();
+        return false;
+    }
+
+    // Nodes, with links stored as IDs for now.
+    std::vector<Node*> pNodesByID( maxNodeID, static_cast<Node*>( NULL ) );
+    std::vector< std::pair<pdf_uint32,pdf_uint32> > links;
+    links.reserve( nbNodes );
+    Node* pNodePrev = NULL;
+    std::vector<PdfeData> goperands;
+    bool valid = true;
+    for( size_t i = 0 ; i < nbNodes && valid ; ++i ) {
+        pdf_uint32 nodeID, link1, link2, nbOperands;
+        pdf_uint16 type;
+        pdf_uint8 xobjType, formFlags;
+        valid = binaryRead( pdata, pend, nodeID ) && nodeID < maxNodeID && !pNodesByID[nodeID] &&
+                binaryRead( pdata, pend, type ) && type < PdfeGOperator::size() &&
+                binaryRead( pdata, pend, xobjType ) &&
+                binaryRead( pdata, pend, formFlags ) &&
+                binaryRead( pdata, pend, link1 ) &&
+                binaryRead( pdata, pend, link2 ) &&
+                binaryRead( pdata, pend, nbOperands );
+        goperands.clear();
+        for( size_t j = 0 ; j < nbOperands && valid ; ++j ) {
+            valid = binaryRead( pdata, pend, pbytes, nbytes );
+            if( valid ) {
+                goperands.push_back( PdfeData( pbytes, pbytes + nbytes ) );
+            }
+        }
+        if( !valid ) {
+            break;
+        }
+        // Append the node to the stream.
+        Node* pnode = new Node( nodeID, PdfeGraphicOperator( PdfeGOperator::Enum( type ) ), goperands );
+        if( pNodePrev ) {
+            pNodePrev->setNext( pnode );
+            pnode->setPrev( pNodePrev );
+        }
+        else {
+            m_pFirstNode = pnode;
+        }
+        m_pLastNode = pNodePrev = pnode;
+        ++m_nbNodes;
+        pNodesByID[nodeID] = pnode;
+        links.push_back( std::make_pair( link1, link2 ) );
+
+        // XObject information.
+        if( pnode->type() == PdfeGOperator::Do ) {
+            pnode->m_formXObject.type = xobjType;
+            pnode->m_formXObject.isLoaded = ( formFlags & 1 );
+            pnode->m_formXObject.isOpening = ( formFlags & 2 );
+            pnode->m_formXObject.isClosing = ( formFlags & 4 );
+            if( link1 != NodeIDUndefined() && pOwner ) {
+                pnode->m_pXObject = pOwner->GetObject( PdfReference( link1, pdf_uint16( link2 ) ) );
+            }
+        }
+    }
+    if( !valid || pdata != pend ) {
+        this->init();
+        return false;
+    }
+    m_maxNodeID = maxNodeID;
+
+    // Restore structural links between nodes.
+    Node* pnode = m_pFirstNode;
+    for( size_t i = 0 ; pnode ; ++i, pnode = pnode->next() ) {
+        Node* pNodeLink1 = links[i].first < maxNodeID ? pNodesByID[ links[i].first ] : NULL;
+        Node* pNodeLink2 = links[i].second < maxNodeID ? pNodesByID[ links[i].second ] : NULL;
+        if( pnode->type() == PdfeGOperator::Do ) {
+            continue;
+        }
+        else if( pnode->category() == PdfeGCategory::PathConstruction ) {
+            pnode->m_pPaintingNode = pNodeLink1;
+            pnode->m_pBeginSubpathNode = pNodeLink2;
+        }
+        else if( pnode->isOpeningNode() || pnode->isClosingNode() ) {
+            pnode->m_pOpeningNode = pNodeLink1;
+        }
+    }
+    return true;
+}
+
 void PdfeContentsStream::copyNodes( const PdfeContentsStream& stream )
 {
     m_pFirstNode = m_pLastNode = NULL;
@@ -1066,6 +1472,14 @@ std::string PdfeContentsStream::Node::toText() const
     this->toTextStream( ostr );
     return ostr.str();
 }
+size_t PdfeContentsStream::Node::memoryFootprint() const
+{
+    size_t footprint = sizeof( Node ) + m_goperands.capacity() * sizeof( PdfeData );
+    for( size_t i = 0 ; i < m_goperands.size() ; ++i ) {
+        footprint += m_goperands[i].capacity();
+    }
+    return footprint;
+}
 std::ostream& operator<<( std::ostream& os, const PdfeContentsStream::Node& node )
 {
     // Check the node is well-defined.
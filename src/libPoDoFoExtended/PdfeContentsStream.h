@@ -14,6 +14,7 @@
 
 #include <limits>
 #include <ostream>
+#include <vector>
 
 #include <QByteArray>
 
@@ -23,15 +24,20 @@
 #include "PdfeResources.h"
 #include "PdfeMisc.h"
 
+class QAtomicInt;
+class QMutex;
+
 namespace PoDoFo {
 class PdfObject;
 class PdfCanvas;
 class PdfVariant;
+class PdfVecObjects;
 }
 
 namespace PoDoFoExtended {
 
 class PdfeGraphicsState;
+class PdfeStreamDecoder;
 
 /// Node ID typedef.
 typedef PoDoFo::pdf_uint32  pdfe_nodeid;
@@ -47,6 +53,29 @@ inline pdfe_nodesubid NodeSubIDUndefined() {
     return std::numeric_limits<pdfe_nodesubid>::max();
 }
 
+namespace PdfeContentsWarning {
+/// Enumeration of the problems detected when loading a contents stream.
+enum Enum {
+    UnmatchedQ = 0,         /// 'Q' with no opening 'q'.
+    BeginSubpath,           /// Subpath not beginning with 'm' or 're'.
+    PaintingNoPath,         /// Path painting with no path defined.
+    UnmatchedET,            /// 'ET' with no opening 'BT'.
+    UnmatchedEI,            /// 'EI' with no opening 'BI'.
+    UnmatchedEX,            /// 'EX' with no opening 'BX'.
+    PSXObject,              /// PostScript XObject.
+    UnknownXObject,         /// XObject of unknown type.
+    XObjectNotFound,        /// XObject not found in the resources.
+    UnknownOperator,        /// Unknown graphics operator.
+    PathNotPainted          /// Path constructed but not painted.
+};
+/// Number of warning kinds.
+inline size_t size() {
+    return 11;
+}
+/// Short description of a warning kind.
+const char* str( PdfeContentsWarning::Enum kind );
+}
+
 //**********************************************************//
 //                     PdfeContentsStream                   //
 //**********************************************************//
@@ -110,10 +139,31 @@ public:
      * only the graphics operator Do appears. Resources of the stream are completed
      * with Forms resources (their names are modified to avoid conflicts).
      * \param fixStream Fix mistakes detected in the stream.
+     * \param pDecoder Optional decoder providing streams decoded in advance.
+     * \param pMutex Optional mutex protecting the PoDoFo document. Only held
+     * while PoDoFo objects are accessed: decoded streams are parsed unlocked.
+     * \param pAbort Optional abort flag, checked each time the mutex is
+     * acquired: a PdfError is raised once it is set (non zero).
      */
     void load( PoDoFo::PdfCanvas *pcanvas,
                bool loadFormsStream,
-               bool fixStream );
+               bool fixStream,
+               PdfeStreamDecoder* pDecoder = NULL,
+               QMutex* pMutex = NULL,
+               const QAtomicInt* pAbort = NULL );
+    /** Number of warnings of a given kind raised by the last load (malformed
+     * stream). Only the first MaxWarningsLogged of each kind are logged, and
+     * a summary is logged once per load if some of them were not. Callers may use these counts to
+     * fall back to a cheaper processing of badly generated streams.
+     */
+    size_t nbWarnings( PdfeContentsWarning::Enum kind ) const {
+        return m_nbWarnings[kind];
+    }
+    /// Total number of warnings raised by the last load.
+    size_t nbWarnings() const;
+    /// Maximum number of warnings logged by kind and by load.
+    static const size_t MaxWarningsLogged = 5;
+
     /** Save the stream into an existing canvas.
      * \param pcanvas Canvas whose contents stream is replaced.
      * Previous existing content is completely erased.
@@ -122,10 +172,19 @@ public:
 
 public:
     /** Get stream data, formatted accordingly to the PDF
-     * reference.
+     * reference. Nodes are directly written into a pre-sized buffer.
      * \return Data object containing the stream.
      */
     PdfeData data() const;
+    /** Size of the stream data, formatted accordingly to the PDF reference.
+     * \return Size in bytes (i.e. size of the data() object).
+     */
+    size_t dataSize() const;
+    /** Approximate memory footprint of the stream: nodes, operands and
+     * initial graphics state (resources objects are owned by PoDoFo).
+     * \return Size in bytes.
+     */
+    size_t memoryFootprint() const;
     /** Write down a text description of the stream in an
      * output stream. Note: should only be use for human reading,
      * not PDF streams generation (use operator<< otherwise).
@@ -140,18 +199,46 @@ public:
      */
     std::string toText() const;
 
+public:
+    /** Compact binary representation of the contents stream: nodes, operators,
+     * operands and structural links (opening/closing, subpath, painting, XObjects
+     * references), plus stream resources. Used by PdfeContentsCache. Integers are
+     * written in host byte order: the representation is not meant to be portable.
+     * \return Data object containing the binary representation.
+     */
+    PdfeData binaryData() const;
+    /** Load the contents stream from a binary representation (c.f. binaryData).
+     * \param pdata Pointer to binary data (e.g. memory-mapped file).
+     * \param length Length of the binary data.
+     * \param pOwner Collection of objects used to resolve XObjects references.
+     * \return True if correctly loaded. Otherwise, data are corrupted or
+     * incompatible, and the stream is left empty.
+     */
+    bool loadBinaryData( const char* pdata, size_t length,
+                         const PoDoFo::PdfVecObjects* pOwner );
+
 private:
     /** Private version of the canvas loading. Can be called recursively, in
      * particular to load form XObjects.
      * \param pNodePrev Node after which is loaded the form stream.
      * \param resSuffix Suffix to add to resources (form loading...).
+     * \param pDecoder Decoder of streams (can be NULL).
+     * \param pMutex Mutex protecting the PoDoFo document (can be NULL).
+     * \param pAbort Abort flag (can be NULL).
      * \return Last node to be inserted.
      */
     Node* load( PoDoFo::PdfCanvas *pcanvas,
                 bool loadFormsStream,
                 bool fixStream,
                 Node* pNodePrev,
-                const std::string& resSuffix );
+                const std::string& resSuffix,
+                PdfeStreamDecoder* pDecoder,
+                QMutex* pMutex,
+                const QAtomicInt* pAbort );
+    /** Raise a PdfError if the loading has been aborted.
+     * \param pAbort Abort flag (can be NULL).
+     */
+    static void checkAbort( const QAtomicInt* pAbort );
 
 public:
     // Simples getters...
@@ -172,9 +259,30 @@ private:
     /** Deep copy of nodes from another contents stream.
      */
     void copyNodes( const PdfeContentsStream& stream );
+    /** Size of the PDF representation of a node (operands and operator).
+     * \param node Node to consider.
+     * \return Size in bytes (0 for unknown nodes, which are not written).
+     */
+    static size_t nodeDataSize( const Node& node );
+    /** Write the PDF representation of a node in a buffer.
+     * \param node Node to write down.
+     * \param pbuffer Buffer, at least of size nodeDataSize( node ).
+     * \return Pointer to the end of the data written.
+     */
+    static char* writeNodeData( const Node& node, char* pbuffer );
     /** Delete contents nodes.
      */
     void deleteNodes();
+    /** Count a warning raised during the loading, and log it if the
+     * maximum number of warnings logged for its kind is not reached.
+     * \param kind Kind of warning.
+     * \param nodeid ID of the node concerned.
+     */
+    void warning( PdfeContentsWarning::Enum kind, pdfe_nodeid nodeid );
+    /** Log a summary of the warnings raised during the loading, if some
+     * of them were not logged (more than MaxWarningsLogged of a kind).
+     */
+    void logWarningsSummary() const;
 
 private:
     /// Pointer to the first node of the stream.
@@ -191,6 +299,8 @@ private:
     PdfeGraphicsState*  m_pInitialGState;
     /// Resources used by the contents stream.
     PdfeResources  m_resources;
+    /// Number of warnings by kind, raised by the last load.
+    std::vector<size_t>  m_nbWarnings;
 };
 
 /** Write a contents stream into a std::ostream accordingly to the PDF
@@ -359,6 +469,10 @@ public:
      * \return String describing the node.
      */
     std::string toText() const;
+    /** Approximate memory footprint of the node (node and operands).
+     * \return Size in bytes.
+     */
+    size_t memoryFootprint() const;
 
 private:
     // Setters... Keep them private for now...
@@ -15,6 +15,7 @@
 #include <QsLog/QsLog.h>
 
 #include <QFont>
+#include <QMutex>
 
 #include FT_BBOX_H
 
@@ -26,6 +27,8 @@ namespace PoDoFoExtended {
 //                          PdfeFont                        //
 //**********************************************************//
 QDir PdfeFont::Standard14FontsDir;
+/// Mutex protecting static data filled on first access (documents loaded concurrently).
+static QMutex StaticDataMutex;
 
 const char* PdfeFont::Standard14FontNames[][10] =
 {
@@ -107,7 +110,7 @@ void PdfeFont::init()
     // Common elements shared by fonts.
     m_ftLibrary = NULL;
     m_ftFace = NULL;
-    m_ftFaceData.clear();
+    m_ftFaceData.reset();
     m_ftCharmapsIdx.resize( 3, -1 );
 
     m_pEncoding = NULL;
@@ -115,6 +118,9 @@ void PdfeFont::init()
 
     m_unicodeCMap.init();
     m_spaceCharacters.clear();
+
+    m_statistics = PdfeFont::defaultStatistics();
+    m_statisticsComputed = false;
 }
 PdfeFont::~PdfeFont()
 {
@@ -311,48 +317,76 @@ double PdfeFont::spaceHeight() const
 // Default implementation.
 PdfeFont::Statistics PdfeFont::statistics( bool defaultValue ) const
 {
-    PdfeFont::Statistics stats;
-
     // Default values computed from standard 14 fonts.
     if( defaultValue ) {
-        stats.meanAdvance = 0.5;
-        stats.meanBBox = PdfRect( 0.0, 0.0, 0.45, 0.57 );
+        return PdfeFont::defaultStatistics();
     }
-    else {
-        // TODO: case of Type 0 fonts.
-        // Compute mean values.
-        PdfeVector advance;
-        double left = 0.0;
-        double bottom = 0.0;
-        double width = 0.0;
-        double height = 0.0;
-        size_t nbChars = 0;
-
-        for( pdfe_cid c = 0 ; c <= 255 ; ++c ) {
-            // Consider the character if GID not null and not a space char.
-            pdfe_gid gid = this->fromCIDToGID( c );
-            if( gid && ( this->isSpace( c ) == PdfeFontSpace::None ) ) {
-                PdfRect bbox = this->bbox( c, false );
-                if( bbox.GetWidth() > 0 && bbox.GetHeight() > 0 ) {
-                    advance = advance + this->advance( c, false );
-
-                    left += bbox.GetLeft();
-                    bottom += bbox.GetBottom();
-                    width += bbox.GetWidth();
-                    height += bbox.GetHeight();
-
-                    nbChars++;
-                }
+    // Compute statistics only once.
+    QMutexLocker locker( &m_statisticsMutex );
+    if( !m_statisticsComputed ) {
+        std::vector<pdfe_cid> cids;
+        this->statisticsCIDs( cids );
+        m_statistics = this->computeStatistics( cids );
+        m_statisticsComputed = true;
+    }
+    return m_statistics;
+}
+void PdfeFont::statisticsCIDs( std::vector<pdfe_cid>& cids ) const
+{
+    // Simple fonts: single byte characters.
+    cids.resize( 256 );
+    for( pdfe_cid c = 0 ; c <= 255 ; ++c ) {
+        cids[c] = c;
+    }
+}
+PdfeFont::Statistics PdfeFont::computeStatistics( const std::vector<pdfe_cid>& cids ) const
+{
+    // Compute mean values.
+    PdfeVector advance;
+    double left = 0.0;
+    double bottom = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+    size_t nbChars = 0;
+
+    for( size_t i = 0 ; i < cids.size() ; ++i ) {
+        // Consider the character if GID not null and not a space char.
+        pdfe_cid c = cids[i];
+        pdfe_gid gid = this->fromCIDToGID( c );
+        if( gid && ( this->isSpace( c ) == PdfeFontSpace::None ) ) {
+            PdfRect bbox = this->bbox( c, false );
+            if( bbox.GetWidth() > 0 && bbox.GetHeight() > 0 ) {
+                advance = advance + this->advance( c, false );
+
+                left += bbox.GetLeft();
+                bottom += bbox.GetBottom();
+                width += bbox.GetWidth();
+                height += bbox.GetHeight();
+
+                nbChars++;
             }
         }
-        stats.meanAdvance = advance.norm2() / nbChars;
-        stats.meanBBox.SetLeft( left / nbChars );
-        stats.meanBBox.SetBottom( bottom / nbChars );
-        stats.meanBBox.SetWidth( width / nbChars );
-        stats.meanBBox.SetHeight( height / nbChars );
-//        stats.meanBBox = this->fontBBox();
-//        stats.meanAdvance = stats.meanBBox.GetWidth();
     }
+    // No character found: keep default values.
+    if( !nbChars ) {
+        return PdfeFont::defaultStatistics();
+    }
+    PdfeFont::Statistics stats;
+    stats.meanAdvance = advance.norm2() / nbChars;
+    stats.meanBBox.SetLeft( left / nbChars );
+    stats.meanBBox.SetBottom( bottom / nbChars );
+    stats.meanBBox.SetWidth( width / nbChars );
+    stats.meanBBox.SetHeight( height / nbChars );
+    stats.nbCharacters = nbChars;
+    return stats;
+}
+PdfeFont::Statistics PdfeFont::defaultStatistics()
+{
+    // Default values computed from standard 14 fonts.
+    PdfeFont::Statistics stats;
+    stats.meanAdvance = 0.5;
+    stats.meanBBox = PdfRect( 0.0, 0.0, 0.45, 0.57 );
+    stats.nbCharacters = 0;
     return stats;
 }
 
@@ -443,32 +477,28 @@ void PdfeFont::initFTFace( const PdfeFontDescriptor& fontDescriptor )
 
     // Embedded font program.
     if( fontDescriptor.fontEmbedded().fontFile() ) {
-        // Copy font program in a buffer.
-        char* pBuffer;
-        long length;
-        fontDescriptor.fontEmbedded().copyFontProgram( &pBuffer, &length );
-        if( !pBuffer ) {
+        // Shared font program: decoded once, no copy.
+        m_ftFaceData = fontDescriptor.fontEmbedded().fontProgram();
+        if( !m_ftFaceData ) {
             // No font program found...
             m_ftFace = NULL;
-            m_ftFaceData.clear();
+            this->initFTFaceCharmaps();
             return;
         }
-
-        // Copy data into the member buffer.
-        m_ftFaceData.clear();
-        m_ftFaceData.append( pBuffer, length );
-        free( pBuffer );
     }
     // Standard font.
     else if( stdFont14 != PdfeFont14Standard::None ) {
-        m_ftFaceData = PdfeFont::standard14FontData( stdFont14 );
+        // QByteArray COW: the static data is not copied.
+        m_ftFaceData.reset( new QByteArray( PdfeFont::standard14FontData( stdFont14 ) ) );
     }
     // Font program not embedded in the PDF: try to load on the host system.
     else {
         // TODO.
         // See: http://lists.trolltech.com/qt-interest/2008-03/thread00445-0.html
         m_ftFace = NULL;
-        m_ftFaceData.clear();
+        m_ftFaceData.reset();
+        this->initFTFaceCharmaps();
+        return;
 
 //#ifdef Q_WS_X11
 //        std::string sfontname = fontDescriptor.fontName( false ).GetName();
@@ -484,17 +514,17 @@ void PdfeFont::initFTFace( const PdfeFontDescriptor& fontDescriptor )
 //                 << qfont2.key();
 //#endif
     }
-    // Load FreeType face from data buffer.
+    // Load FreeType face from the shared data buffer (FreeType does not copy it).
     int error;
-    unsigned char* pData = reinterpret_cast<unsigned char*>( const_cast<char*>( m_ftFaceData.constData() ) );
+    const FT_Byte* pData = reinterpret_cast<const FT_Byte*>( m_ftFaceData->constData() );
     error = FT_New_Memory_Face( m_ftLibrary,
                                 pData,
-                                m_ftFaceData.size(), 0,
+                                m_ftFaceData->size(), 0,
                                 &m_ftFace );
     if( error ) {
         // Can not load: return...
         m_ftFace = NULL;
-        m_ftFaceData.clear();
+        m_ftFaceData.reset();
         this->initFTFaceCharmaps();
         return;
     }
@@ -505,7 +535,7 @@ void PdfeFont::initFTFace( QString filename )
 {
     // Load FreeType face from data buffer.
     int error;
-    m_ftFaceData.clear();
+    m_ftFaceData.reset();
     error = FT_New_Face( m_ftLibrary,
                          filename.toLocal8Bit().constData(),
                          0,
@@ -834,6 +864,7 @@ QString PdfeFont::standard14FontPath( PdfeFont14Standard::Enum stdFontType )
 QByteArray PdfeFont::standard14FontData( PdfeFont14Standard::Enum stdFontType )
 {
     // Static data vector.
+    QMutexLocker locker( &StaticDataMutex );
     static std::vector<QByteArray> stdFontsData( 14, QByteArray() );
 
     // Data already loaded...
@@ -854,6 +885,7 @@ QByteArray PdfeFont::standard14FontData( PdfeFont14Standard::Enum stdFontType )
 const std::vector<QChar>& PdfeFont::spaceCharacters()
 {
     // Static variable containing space elements.
+    QMutexLocker locker( &StaticDataMutex );
     static std::vector<QChar> spaceChars;
     // Insert characters in the vector if empty (should happen once).
     if( !spaceChars.size() ) {
@@ -24,6 +24,7 @@
 #include FT_FREETYPE_H
 
 #include <QByteArray>
+#include <QMutex>
 #include <QString>
 #include <QImage>
 #include <QDir>
@@ -233,14 +234,34 @@ public:
         double meanAdvance;
         /// Mean bounding box (width, bottom and top computed).
         PoDoFo::PdfRect meanBBox;
+        /// Number of characters used in the computation (0 for default values).
+        size_t nbCharacters;
     };
 
-    /** Compute some font statistics.
+    /** Compute some font statistics. Statistics are only computed once, and then
+     * stored in the font object.
      * \param defaultValue Use some predefined default values (for Type 0/1 and TrueType fonts).
      * \return PdfeFont::Statistics object containing data.
      */
     virtual Statistics statistics( bool defaultValue = false ) const = 0;
 
+protected:
+    /** Get the list of characters used to compute font statistics.
+     * Default implementation: CIDs from 0 to 255 (simple fonts).
+     * \param cids Vector where CIDs are stored.
+     */
+    virtual void statisticsCIDs( std::vector<pdfe_cid>& cids ) const;
+    /** Compute font statistics on a list of characters. Only characters with
+     * a glyph, a non-empty bounding box and which are not spaces are considered.
+     * \param cids Characters to consider.
+     * \return Statistics. Default values if no character can be used.
+     */
+    Statistics computeStatistics( const std::vector<pdfe_cid>& cids ) const;
+    /** Default font statistics, computed from standard 14 fonts.
+     * \return Statistics object.
+     */
+    static Statistics defaultStatistics();
+
 public:
     /** Get a character name from its CID.
      * Default implementation first try using the font encoding and then the unicode code.
@@ -433,8 +454,8 @@ private:
     FT_Library  m_ftLibrary;
     /// FreeType Face object (represent a font).
     FT_Face  m_ftFace;
-    /// FreeType Face data.
-    QByteArray  m_ftFaceData;
+    /// FreeType Face data (shared font program, must live as long as the face).
+    PdfeFontProgramPtr  m_ftFaceData;
     /// Index of the charmaps (1,0), (3,0) and (3,1) in FT face.
     /// -1 if it does exist in FreeType face.
     std::vector<int>  m_ftCharmapsIdx;
@@ -449,6 +470,13 @@ private:
     /// Vector of space characters (pair of CID and space type).
     std::vector< std::pair<pdfe_cid,PdfeFontSpace::Enum> >  m_spaceCharacters;
 
+    /// Font statistics (computed once, when first needed).
+    mutable Statistics  m_statistics;
+    /// Have font statistics been computed?
+    mutable bool  m_statisticsComputed;
+    /// Mutex protecting the lazy computation of statistics (fonts are shared between threads).
+    mutable QMutex  m_statisticsMutex;
+
 protected:
     // Protected Getters.
     /// Get font face object.
@@ -14,13 +14,37 @@
 
 #include <QsLog/QsLog.h>
 
+#include <boost/weak_ptr.hpp>
+#include <map>
+
 #include <QRegExp>
+#include <QMutex>
 #include <QDebug>
 
 using namespace PoDoFo;
 
 namespace PoDoFoExtended {
 
+/** PoDoFo output stream writing directly into a QByteArray.
+ * Used to decode font programs without any intermediate buffer.
+ */
+class PdfeByteArrayOutputStream : public PdfOutputStream
+{
+public:
+    PdfeByteArrayOutputStream( QByteArray* pArray ) :
+        m_pArray( pArray ) { }
+
+    virtual pdf_long Write( const char* pBuffer, pdf_long lLen ) {
+        m_pArray->append( pBuffer, lLen );
+        return lLen;
+    }
+    virtual void Close() { }
+
+private:
+    /// Byte array where data is written.
+    QByteArray*  m_pArray;
+};
+
 //**********************************************************//
 //                     PdfeFontEmbedded                     //
 //**********************************************************//
@@ -58,19 +82,97 @@ void PdfeFontEmbedded::setFontFiles( PoDoFo::PdfObject* fontFile,
     m_fontFile2 = fontFile2;
     m_fontFile3 = fontFile3;
 }
-void PdfeFontEmbedded::copyFontProgram( char** pBuffer, long* pLength ) const
+namespace {
+/// Key of a font program: document objects and reference of the FontFile.
+typedef std::pair< const PdfVecObjects*, PdfReference >  FontProgramKey;
+/// Cache of decoded font programs: only keep weak references, so that the
+/// memory is freed once the last font (and FreeType face) using it is deleted.
+typedef std::map< FontProgramKey, boost::weak_ptr<const QByteArray> >  FontProgramsCache;
+
+FontProgramsCache& fontProgramsCache()
+{
+    static FontProgramsCache fontPrograms;
+    return fontPrograms;
+}
+QMutex& fontProgramsMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+}
+
+PdfeFontProgramPtr PdfeFontEmbedded::fontProgram() const
 {
     // Get font file.
     PoDoFo::PdfObject* fontFile = this->fontFile();
+    if( !fontFile || !fontFile->HasStream() ) {
+        return PdfeFontProgramPtr();
+    }
+    // Objects without owner (or reference) can not be shared.
+    bool cached = fontFile->GetOwner() && fontFile->Reference().IsIndirect();
+    FontProgramKey key( fontFile->GetOwner(), fontFile->Reference() );
+
+    FontProgramsCache& fontPrograms = fontProgramsCache();
+    if( cached ) {
+        // Font program already decoded and still used.
+        QMutexLocker locker( &fontProgramsMutex() );
+        FontProgramsCache::iterator it = fontPrograms.find( key );
+        if( it != fontPrograms.end() ) {
+            PdfeFontProgramPtr pProgram = it->second.lock();
+            if( pProgram ) {
+                return pProgram;
+            }
+        }
+    }
 
-    // Uncompress and copy into a buffer.
-    if( fontFile ) {
-        PdfStream* stream = fontFile->GetStream();
-        stream->GetFilteredCopy( pBuffer, pLength );
+    // Uncompress directly into a new buffer, using LengthX keys as size hint.
+    // Done outside the lock: other fonts are not blocked during decoding.
+    QByteArray* pBuffer = new QByteArray();
+    PdfeFontProgramPtr pProgram( pBuffer );
+
+    const PdfDictionary& fontFileDict = fontFile->GetDictionary();
+    pdf_long lengthHint = fontFileDict.GetKeyAsLong( "Length1", 0L ) +
+            fontFileDict.GetKeyAsLong( "Length2", 0L ) +
+            fontFileDict.GetKeyAsLong( "Length3", 0L );
+    if( lengthHint > 0 ) {
+        pBuffer->reserve( lengthHint );
     }
-    else {
-        *pBuffer = NULL;
-        *pLength = -1;
+    PdfeByteArrayOutputStream stream( pBuffer );
+    fontFile->GetStream()->GetFilteredCopy( &stream );
+    if( !cached ) {
+        return pProgram;
+    }
+
+    QMutexLocker locker( &fontProgramsMutex() );
+    // Decoded concurrently by another font: keep the first one.
+    FontProgramsCache::iterator it = fontPrograms.find( key );
+    if( it != fontPrograms.end() ) {
+        PdfeFontProgramPtr pOther = it->second.lock();
+        if( pOther ) {
+            return pOther;
+        }
+    }
+    // Remove expired entries.
+    for( it = fontPrograms.begin() ; it != fontPrograms.end() ; ) {
+        if( it->second.expired() ) {
+            fontPrograms.erase( it++ );
+        }
+        else {
+            ++it;
+        }
+    }
+    fontPrograms[ key ] = pProgram;
+    return pProgram;
+}
+void PdfeFontEmbedded::releaseFontPrograms( const PoDoFo::PdfVecObjects* pDocObjects )
+{
+    // Entries of the document are contiguous in the map.
+    QMutexLocker locker( &fontProgramsMutex() );
+    FontProgramsCache& fontPrograms = fontProgramsCache();
+    FontProgramsCache::iterator it;
+    it = fontPrograms.lower_bound( FontProgramKey( pDocObjects, PdfReference( 0, 0 ) ) );
+    while( it != fontPrograms.end() && it->first.first == pDocObjects ) {
+        fontPrograms.erase( it++ );
     }
 }
 
@@ -17,14 +17,22 @@
 #include "podofo/base/PdfString.h"
 #include "podofo/base/PdfRect.h"
 
+#include <boost/shared_ptr.hpp>
+
+#include <QByteArray>
+
 namespace PoDoFo {
 class PdfObject;
+class PdfVecObjects;
 class PdfName;
 class PdfString;
 }
 
 namespace PoDoFoExtended {
 
+/// Shared (and reference counted) buffer containing a decoded font program.
+typedef boost::shared_ptr<const QByteArray>  PdfeFontProgramPtr;
+
 /** Simple class that gathers information on an embedded font.
  */
 class PdfeFontEmbedded
@@ -54,11 +62,19 @@ public:
                        PoDoFo::PdfObject* fontFile2,
                        PoDoFo::PdfObject* fontFile3 );
 
-    /** Get a copy of the font program, stored in a buffer.
-     * \param pBuffer Pointer of the buffer which will contain the font program. Owned by the user.
-     * \param pLength Pointer to the length of the buffer.
+    /** Get the decoded font program. The buffer is shared between every caller
+     * using the same FontFile object (same document and reference): the stream
+     * is only decoded once, as long as a reference to the buffer is kept
+     * somewhere (e.g. by a FreeType face).
+     * \return Shared pointer to the font program. NULL if no font file.
+     */
+    PdfeFontProgramPtr fontProgram() const;
+
+    /** Release the cached font programs of a document. Has to be called
+     * before the document is freed, as its address may be reused.
+     * \param pDocObjects Objects vector of the document.
      */
-    void copyFontProgram( char** pBuffer, long* pLength ) const;
+    static void releaseFontPrograms( const PoDoFo::PdfVecObjects* pDocObjects );
 
 protected:
     /// FontFile object no1.
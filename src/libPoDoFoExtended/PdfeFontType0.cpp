@@ -146,6 +146,29 @@ pdfe_gid PdfeFontType0::fromCIDToGID( pdfe_cid c ) const
 {
     return m_fontCID->fromCIDToGID( c );
 }
+void PdfeFontType0::statisticsCIDs( std::vector<pdfe_cid>& cids ) const
+{
+    // CIDs used in the font are the ones described in the widths array
+    // (subset fonts usually only declare the characters used in the document).
+    const std::vector<pdfe_cid>& firstCIDs = m_fontCID->firstCIDs();
+    const std::vector<pdfe_cid>& lastCIDs = m_fontCID->lastCIDs();
+    size_t nbCIDs = 0;
+    for( size_t i = 0 ; i < firstCIDs.size() ; ++i ) {
+        nbCIDs += lastCIDs[i] - firstCIDs[i] + 1;
+    }
+    // Regular sampling if too many characters (rounded up: at most MaxStatisticsCIDs).
+    size_t step = std::max( ( nbCIDs + MaxStatisticsCIDs - 1 ) / MaxStatisticsCIDs, size_t( 1 ) );
+    size_t idx = 0;
+    cids.clear();
+    cids.reserve( std::min( nbCIDs, MaxStatisticsCIDs ) );
+    for( size_t i = 0 ; i < firstCIDs.size() && cids.size() < MaxStatisticsCIDs ; ++i ) {
+        for( size_t c = firstCIDs[i] ; c <= lastCIDs[i] && cids.size() < MaxStatisticsCIDs ; ++c, ++idx ) {
+            if( idx % step == 0 ) {
+                cids.push_back( static_cast<pdfe_cid>( c ) );
+            }
+        }
+    }
+}
 
 //**********************************************************//
 //                        PdfeFontCID                       //
@@ -110,6 +110,17 @@ public:
      */
     virtual pdfe_gid fromCIDToGID( pdfe_cid c ) const;
 
+protected:
+    /** Get the list of characters used to compute font statistics.
+     * Sample CIDs defined in the widths array of the descendant font.
+     * \param cids Vector where CIDs are stored.
+     */
+    virtual void statisticsCIDs( std::vector<pdfe_cid>& cids ) const;
+
+private:
+    /// Maximum number of CIDs sampled for statistics.
+    static const size_t MaxStatisticsCIDs = 512;
+
 private:
     // Members.
     /// The PostScript name of the font.
@@ -254,7 +254,7 @@ pdfe_gid PdfeFontType3::fromCIDToGID(pdfe_cid c) const
 //                      PdfeGlyphType3                      //
 //**********************************************************//
 PdfeGlyphType3::PdfeGlyphType3() :
-    PdfeCanvasAnalysis(), PdfCanvas(),
+    PdfeContentsAnalysis(), PdfCanvas(),
     m_name(), m_pStream( NULL ), m_pResources( NULL ),
     m_isBBoxComputed( false ), m_bboxD1( 0,0,0,0 ), m_cbox( 0,0,0,0 )
 
@@ -264,7 +264,7 @@ PdfeGlyphType3::PdfeGlyphType3() :
 PdfeGlyphType3::PdfeGlyphType3( const PdfName& glyphName,
                                 PdfObject* glyphStream,
                                 PdfObject* fontResources ) :
-    PdfeCanvasAnalysis(), PdfCanvas(),
+    PdfeContentsAnalysis(), PdfCanvas(),
     m_name( glyphName ), m_pStream( glyphStream ), m_pResources( fontResources ),
     m_isBBoxComputed( false ), m_bboxD1( 0,0,0,0 ), m_cbox( 0,0,0,0 )
 {
@@ -289,14 +289,14 @@ void PdfeGlyphType3::computeBBox()
     m_bboxD1 = PdfRect( 0, 0, 0, 0 );
     m_cbox = PdfRect( 0, 0, 0, 0 );
 
-    // Analyse contents stream of the glyph.
-    this->analyseContents( this, PdfeGraphicsState(), PdfeResources( m_pResources ) );
+    // Analyse contents stream of the glyph (streaming mode, no need to keep it).
+    this->analyseContents( this, PdfeGraphicsState(), false );
 }
 
 //**********************************************//
-//         PdfeCanvasAnalysis interface         //
+//        PdfeContentsAnalysis interface        //
 //**********************************************//
-void PdfeGlyphType3::fPathPainting( const PdfeStreamStateOld&,
+void PdfeGlyphType3::fPathPainting( const PdfeStreamState&,
                                     const PdfePath& )
 {
     // TODO: implement the computation of cbox.
@@ -306,27 +306,23 @@ void PdfeGlyphType3::fPathPainting( const PdfeStreamStateOld&,
 //               std::ostream_iterator<std::string>( std::cout, " " ) );
 //    std::cout << std::endl;
 }
-void PdfeGlyphType3::fType3Fonts( const PdfeStreamStateOld& streamState )
+void PdfeGlyphType3::fType3Fonts( const PdfeStreamState& streamState )
 {
     // Update d1 bounding box if possible.
-    if( streamState.gOperator.type() == PdfeGOperator::d1 ) {
-        double left, right, bottom, top;
-        size_t nbvars = streamState.gOperands.size();
+    const PdfeContentsStream::Node* pnode = streamState.pNode;
+    if( pnode->type() == PdfeGOperator::d1 ) {
+        size_t nbvars = pnode->nbOperands();
 
         // Read bbox coordinates.
-        this->readValue( streamState.gOperands[nbvars-4], left );
-        this->readValue( streamState.gOperands[nbvars-3], bottom );
-        this->readValue( streamState.gOperands[nbvars-2], right );
-        this->readValue( streamState.gOperands[nbvars-1], top );
+        double left = pnode->operand<double>( nbvars-4 );
+        double bottom = pnode->operand<double>( nbvars-3 );
+        double right = pnode->operand<double>( nbvars-2 );
+        double top = pnode->operand<double>( nbvars-1 );
 
         m_bboxD1 = PdfRect( left, bottom, right-left, top-bottom );
     }
 }
 
-void PdfeGlyphType3::fUnknown( const PdfeStreamStateOld& streamState )
-{
-}
-
 //**********************************************//
 //              PdfCanvas interface             //
 //**********************************************//
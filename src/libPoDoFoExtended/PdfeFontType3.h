@@ -13,7 +13,7 @@
 #define PDFEFONTTYPE3_H
 
 #include "PdfeFont.h"
-#include "PdfeCanvasAnalysis.h"
+#include "PdfeContentsAnalysis.h"
 
 #include "podofo/base/PdfCanvas.h"
 
@@ -150,9 +150,9 @@ private:
 //                      PdfeGlyphType3                      //
 //**********************************************************//
 /** Class used to represent a glyph from a Type 3 font.
- * Inherit from the interface PdfeCanvasAnalysis and the class PdfCanvas.
+ * Inherit from the interface PdfeContentsAnalysis and the class PdfCanvas.
  */
-class PdfeGlyphType3 : public PdfeCanvasAnalysis, public PoDoFo::PdfCanvas
+class PdfeGlyphType3 : public PdfeContentsAnalysis, public PoDoFo::PdfCanvas
 {
 public:
     /** Default constructor.
@@ -178,31 +178,10 @@ protected:
     void computeBBox();
 
 protected:
-    // Reimplement PdfeCanvasAnalysis interface.
-    virtual void fGeneralGState( const PdfeStreamStateOld& streamState ) { }
-    virtual void fSpecialGState( const PdfeStreamStateOld& streamState ) { }
-    virtual void fPathConstruction( const PdfeStreamStateOld& streamState,
-                                    const PdfePath& currentPath ) { }
-    virtual void fPathPainting( const PdfeStreamStateOld& streamState,
+    // Reimplement PdfeContentsAnalysis interface.
+    virtual void fPathPainting( const PdfeStreamState& streamState,
                                 const PdfePath& currentPath );
-    virtual void fClippingPath( const PdfeStreamStateOld& streamState,
-                                const PdfePath& currentPath ) { }
-    virtual void fTextObjects( const PdfeStreamStateOld& streamState ) { }
-    virtual void fTextState( const PdfeStreamStateOld& streamState ) { }
-    virtual void fTextPositioning( const PdfeStreamStateOld& streamState ) { }
-    virtual PdfeVector fTextShowing( const PdfeStreamStateOld& streamState ) { return PdfeVector(); }
-    virtual void fType3Fonts( const PdfeStreamStateOld& streamState );
-    virtual void fColor( const PdfeStreamStateOld& streamState ) { }
-    virtual void fShadingPatterns( const PdfeStreamStateOld& streamState ) { }
-    virtual void fInlineImages( const PdfeStreamStateOld& streamState ) { }
-    virtual void fXObjects( const PdfeStreamStateOld& streamState ) { }
-    virtual void fMarkedContents( const PdfeStreamStateOld& streamState ) { }
-    virtual void fCompatibility( const PdfeStreamStateOld& streamState ) { }
-    virtual void fUnknown( const PdfeStreamStateOld& streamState );
-    virtual void fFormBegin( const PdfeStreamStateOld& streamState,
-                             PoDoFo::PdfXObject* form ) { }
-    virtual void fFormEnd( const PdfeStreamStateOld& streamState,
-                           PoDoFo::PdfXObject* form ) { }
+    virtual void fType3Fonts( const PdfeStreamState& streamState );
 
 public:
     // Reimplement PdfCanvas interface.
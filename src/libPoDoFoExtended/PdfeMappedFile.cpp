@@ -0,0 +1,97 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+
+#include "PdfeMappedFile.h"
+
+#include <podofo/podofo.h>
+
+using namespace PoDoFo;
+
+namespace PoDoFoExtended {
+
+PdfeMappedFile::PdfeMappedFile( const QString& filename ) :
+    m_file( filename ),
+    m_pdata( NULL ),
+    m_size( 0 ),
+    m_pStreamBuf( NULL ),
+    m_pStream( NULL )
+{
+    if( !m_file.open( QIODevice::ReadOnly ) ) {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, filename.toLocal8Bit().constData() );
+    }
+    m_size = m_file.size();
+    if( m_size ) {
+        m_pdata = reinterpret_cast<const char*>( m_file.map( 0, m_file.size() ) );
+        if( !m_pdata ) {
+            m_file.close();
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle,
+                                     m_file.errorString().toLocal8Bit().constData() );
+        }
+    }
+    m_pStreamBuf = new StreamBuf( m_pdata, m_size );
+    m_pStream = new std::istream( m_pStreamBuf );
+}
+PdfeMappedFile::~PdfeMappedFile()
+{
+    delete m_pStream;
+    delete m_pStreamBuf;
+    if( m_pdata ) {
+        m_file.unmap( reinterpret_cast<uchar*>( const_cast<char*>( m_pdata ) ) );
+    }
+    m_file.close();
+}
+
+PdfRefCountedInputDevice PdfeMappedFile::device()
+{
+    // The device does not own the stream.
+    return PdfRefCountedInputDevice( new PdfInputDevice( m_pStream ) );
+}
+
+//**********************************************************//
+//                 PdfeMappedFile::StreamBuf                //
+//**********************************************************//
+PdfeMappedFile::StreamBuf::StreamBuf( const char* pdata, size_t size )
+{
+    // Read-only buffer: never written through the get area.
+    char* pbuffer = const_cast<char*>( pdata );
+    this->setg( pbuffer, pbuffer, pbuffer + size );
+}
+PdfeMappedFile::StreamBuf::pos_type PdfeMappedFile::StreamBuf::seekoff( off_type off,
+                                                                        std::ios_base::seekdir dir,
+                                                                        std::ios_base::openmode which )
+{
+    if( !( which & std::ios_base::in ) ) {
+        return pos_type( off_type( -1 ) );
+    }
+    char* pnew;
+    if( dir == std::ios_base::beg ) {
+        pnew = this->eback() + off;
+    }
+    else if( dir == std::ios_base::cur ) {
+        pnew = this->gptr() + off;
+    }
+    else {
+        pnew = this->egptr() + off;
+    }
+    if( pnew < this->eback() || pnew > this->egptr() ) {
+        return pos_type( off_type( -1 ) );
+    }
+    this->setg( this->eback(), pnew, this->egptr() );
+    return pos_type( off_type( pnew - this->eback() ) );
+}
+PdfeMappedFile::StreamBuf::pos_type PdfeMappedFile::StreamBuf::seekpos( pos_type pos,
+                                                                        std::ios_base::openmode which )
+{
+    return this->seekoff( off_type( pos ), std::ios_base::beg, which );
+}
+
+}
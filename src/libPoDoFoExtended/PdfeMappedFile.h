@@ -0,0 +1,93 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+
+#ifndef PDFEMAPPEDFILE_H
+#define PDFEMAPPEDFILE_H
+
+#include <istream>
+#include <streambuf>
+
+#include <QFile>
+#include <QString>
+
+#include <podofo/base/PdfRefCountedInputDevice.h>
+
+namespace PoDoFoExtended {
+
+//**********************************************************//
+//                      PdfeMappedFile                      //
+//**********************************************************//
+/** Read-only memory-mapped file, exposed as a PoDoFo input device.
+ * Combined with PoDoFo load-on-demand parsing, objects are only read
+ * (from mapped pages) when accessed, such that opening a large document
+ * neither copies the file nor parses every object. The mapped file must
+ * outlive the PoDoFo document which uses it.
+ */
+class PdfeMappedFile
+{
+public:
+    /** Map a file. Raise a PoDoFo error if the file can not be
+     * opened or mapped.
+     * \param filename Path of the file.
+     */
+    PdfeMappedFile( const QString& filename );
+    /** Destructor: unmap and close the file.
+     */
+    ~PdfeMappedFile();
+
+    /** Create a PoDoFo input device reading the mapped data.
+     * Every device shares the same underlying stream.
+     * \return Reference counted input device.
+     */
+    PoDoFo::PdfRefCountedInputDevice device();
+
+    /// Mapped data.
+    const char* data() const    {   return m_pdata;     }
+    /// Size of the mapped data.
+    size_t size() const         {   return m_size;      }
+
+private:
+    /** Stream buffer on the mapped data (read-only, seekable).
+     */
+    class StreamBuf : public std::streambuf
+    {
+    public:
+        StreamBuf( const char* pdata, size_t size );
+    protected:
+        virtual pos_type seekoff( off_type off,
+                                  std::ios_base::seekdir dir,
+                                  std::ios_base::openmode which );
+        virtual pos_type seekpos( pos_type pos,
+                                  std::ios_base::openmode which );
+    };
+
+private:
+    // No copy constructor and operator= allowed.
+    PdfeMappedFile( const PdfeMappedFile& rhs );
+    PdfeMappedFile& operator=( const PdfeMappedFile& rhs );
+
+private:
+    /// Mapped file.
+    QFile  m_file;
+    /// Pointer to mapped data.
+    const char*  m_pdata;
+    /// Size of mapped data.
+    size_t  m_size;
+    /// Stream buffer on mapped data.
+    StreamBuf*  m_pStreamBuf;
+    /// Input stream used by PoDoFo devices.
+    std::istream*  m_pStream;
+};
+
+}
+
+#endif // PDFEMAPPEDFILE_H
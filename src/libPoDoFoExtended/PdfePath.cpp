@@ -478,7 +478,7 @@ PdfeContentsStream::Node* PdfePath::load( PdfeContentsStream::Node* pnode ,
 
     PdfeContentsStream::Node* pNodePrev = pnode;
     // Path construction nodes.
-    while( pnode->category() == PdfeGCategory::PathConstruction ) {
+    while( pnode && pnode->category() == PdfeGCategory::PathConstruction ) {
         if( pnode->type() == PdfeGOperator::m ) {
             // Begin a new subpath.
             PdfeVector point( pnode->operand<double>( 0 ),
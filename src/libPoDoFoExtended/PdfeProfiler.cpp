@@ -0,0 +1,371 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#include "PdfeProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <new>
+
+#include <QMutexLocker>
+#include <QThread>
+
+#if defined(_MSC_VER)
+#define PDFE_THREAD_LOCAL __declspec( thread )
+#else
+#define PDFE_THREAD_LOCAL __thread
+#endif
+
+namespace {
+/// Allocations of the current thread (c.f. global operators new).
+PDFE_THREAD_LOCAL qint64  t_nbAllocations = 0;
+PDFE_THREAD_LOCAL qint64  t_nbBytesAllocated = 0;
+/// Innermost active scope of the current thread.
+PDFE_THREAD_LOCAL PoDoFoExtended::PdfeProfilerScope*  t_pCurrentScope = NULL;
+}
+
+#ifdef PDFE_PROFILE_ALLOCATIONS
+//**********************************************************//
+//                  Global allocation hooks                 //
+//**********************************************************//
+// Only definition of the global operators in the project.
+namespace {
+/// Counted allocation (NULL on failure).
+void* countedAlloc( size_t size )
+{
+    ++t_nbAllocations;
+    t_nbBytesAllocated += size;
+    return std::malloc( size ? size : 1 );
+}
+/// Counted allocation (std::bad_alloc on failure).
+void* countedAllocOrThrow( size_t size )
+{
+    void* ptr = countedAlloc( size );
+    if( !ptr ) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+}
+
+void* operator new( size_t size ) throw( std::bad_alloc )
+{
+    return countedAllocOrThrow( size );
+}
+void* operator new[]( size_t size ) throw( std::bad_alloc )
+{
+    return countedAllocOrThrow( size );
+}
+void* operator new( size_t size, const std::nothrow_t& ) throw()
+{
+    return countedAlloc( size );
+}
+void* operator new[]( size_t size, const std::nothrow_t& ) throw()
+{
+    return countedAlloc( size );
+}
+void operator delete( void* ptr ) throw()
+{
+    std::free( ptr );
+}
+void operator delete[]( void* ptr ) throw()
+{
+    std::free( ptr );
+}
+void operator delete( void* ptr, const std::nothrow_t& ) throw()
+{
+    std::free( ptr );
+}
+void operator delete[]( void* ptr, const std::nothrow_t& ) throw()
+{
+    std::free( ptr );
+}
+#endif
+
+namespace PoDoFoExtended {
+
+//**********************************************************//
+//                   PdfeProfiler::Histogram                //
+//**********************************************************//
+PdfeProfiler::Histogram::Histogram() :
+    count( 0 ), sum( 0.0 ),
+    min( std::numeric_limits<double>::max() ),
+    max( -std::numeric_limits<double>::max() )
+{
+    std::fill( buckets, buckets + NbBuckets, size_t( 0 ) );
+}
+void PdfeProfiler::Histogram::add( double value )
+{
+    ++count;
+    sum += value;
+    min = std::min( min, value );
+    max = std::max( max, value );
+    // Bucket: position of the highest bit.
+    size_t idx = 0;
+    if( value >= 1.0 ) {
+        int exponent;
+        std::frexp( value, &exponent );
+        idx = std::min( size_t( exponent ), NbBuckets - 1 );
+    }
+    ++buckets[idx];
+}
+
+//**********************************************************//
+//                        PdfeProfiler                      //
+//**********************************************************//
+PdfeProfiler::PdfeProfiler() :
+    m_enabled( false ),
+    m_maxSpans( 1 << 20 )
+{
+    m_timer.start();
+}
+PdfeProfiler& PdfeProfiler::instance()
+{
+    static PdfeProfiler profiler;
+    return profiler;
+}
+
+void PdfeProfiler::setEnabled( bool enabled )
+{
+    QMutexLocker locker( &m_mutex );
+    m_enabled = enabled;
+}
+void PdfeProfiler::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    m_spans.clear();
+    m_threads.clear();
+    m_spansStats.clear();
+    m_spansAllocs.clear();
+    m_counters.clear();
+    m_histograms.clear();
+    m_timer.restart();
+}
+
+void PdfeProfiler::addSpan( const char* name, qint64 start, qint64 duration )
+{
+    this->addSpan( name, start, duration, Allocations() );
+}
+void PdfeProfiler::addSpan( const char* name, qint64 start, qint64 duration,
+                            const Allocations& allocs )
+{
+    QMutexLocker locker( &m_mutex );
+    m_spansStats[ name ].add( duration * 1e-3 );
+    Allocations& spanAllocs = m_spansAllocs[ name ];
+    spanAllocs.count += allocs.count;
+    spanAllocs.bytes += allocs.bytes;
+    if( m_spans.size() < m_maxSpans ) {
+        Span span;
+        span.name = name;
+        span.start = start;
+        span.duration = duration;
+        span.thread = this->threadIndex();
+        span.allocs = allocs;
+        m_spans.push_back( span );
+    }
+}
+void PdfeProfiler::addCounter( const char* name, qint64 value )
+{
+    QMutexLocker locker( &m_mutex );
+    m_counters[ name ] += value;
+}
+void PdfeProfiler::addValue( const char* name, double value )
+{
+    QMutexLocker locker( &m_mutex );
+    m_histograms[ name ].add( value );
+}
+bool PdfeProfiler::allocationsTracked()
+{
+#ifdef PDFE_PROFILE_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+PdfeProfiler::Allocations PdfeProfiler::threadAllocations()
+{
+    Allocations allocs;
+    allocs.count = t_nbAllocations;
+    allocs.bytes = t_nbBytesAllocated;
+    return allocs;
+}
+size_t PdfeProfiler::threadIndex()
+{
+    Qt::HANDLE thread = QThread::currentThreadId();
+    std::vector<Qt::HANDLE>::iterator it;
+    it = std::find( m_threads.begin(), m_threads.end(), thread );
+    if( it != m_threads.end() ) {
+        return it - m_threads.begin();
+    }
+    m_threads.push_back( thread );
+    return m_threads.size() - 1;
+}
+
+namespace {
+/// Write a histogram as a JSON object.
+void writeHistogramJSON( std::ostream& out, const PdfeProfiler::Histogram& histogram )
+{
+    out << "{ \"count\": " << histogram.count
+        << ", \"sum\": " << histogram.sum
+        << ", \"mean\": " << histogram.mean()
+        << ", \"min\": " << ( histogram.count ? histogram.min : 0.0 )
+        << ", \"max\": " << ( histogram.count ? histogram.max : 0.0 )
+        << ", \"buckets\": [";
+    // Non-empty buckets only: [upper bound, count].
+    bool first = true;
+    for( size_t i = 0 ; i < PdfeProfiler::Histogram::NbBuckets ; ++i ) {
+        if( histogram.buckets[i] ) {
+            out << ( first ? " " : ", " ) << "[" << std::ldexp( 1.0, int( i ) )
+                << ", " << histogram.buckets[i] << "]";
+            first = false;
+        }
+    }
+    out << " ] }";
+}
+}
+
+void PdfeProfiler::writeJSON( std::ostream& out, const std::string& label ) const
+{
+    QMutexLocker locker( &m_mutex );
+
+    std::string labelEsc;
+    for( size_t i = 0 ; i < label.size() ; ++i ) {
+        if( label[i] == '"' || label[i] == '\\' ) {
+            labelEsc.push_back( '\\' );
+        }
+        labelEsc.push_back( label[i] );
+    }
+    out << std::setprecision( 9 );
+    out << "{\n  \"label\": \"" << labelEsc << "\",\n";
+    out << "  \"elapsed_s\": " << m_timer.nsecsElapsed() * 1e-9 << ",\n";
+
+    // Spans: durations in microseconds.
+    out << "  \"spans_us\": {";
+    std::map<std::string, Histogram>::const_iterator it;
+    for( it = m_spansStats.begin() ; it != m_spansStats.end() ; ++it ) {
+        out << ( it == m_spansStats.begin() ? "\n" : ",\n" )
+            << "    \"" << it->first << "\": ";
+        writeHistogramJSON( out, it->second );
+    }
+    out << "\n  },\n";
+
+    // Allocations attributed to spans (self).
+    out << "  \"allocations_tracked\": " << ( allocationsTracked() ? "true" : "false" ) << ",\n";
+    out << "  \"allocations\": {";
+    std::map<std::string, Allocations>::const_iterator ita;
+    for( ita = m_spansAllocs.begin() ; ita != m_spansAllocs.end() ; ++ita ) {
+        out << ( ita == m_spansAllocs.begin() ? "\n" : ",\n" )
+            << "    \"" << ita->first << "\": { \"count\": " << ita->second.count
+            << ", \"bytes\": " << ita->second.bytes << " }";
+    }
+    out << "\n  },\n";
+
+    out << "  \"counters\": {";
+    std::map<std::string, qint64>::const_iterator itc;
+    for( itc = m_counters.begin() ; itc != m_counters.end() ; ++itc ) {
+        out << ( itc == m_counters.begin() ? "\n" : ",\n" )
+            << "    \"" << itc->first << "\": " << itc->second;
+    }
+    out << "\n  },\n";
+
+    out << "  \"histograms\": {";
+    for( it = m_histograms.begin() ; it != m_histograms.end() ; ++it ) {
+        out << ( it == m_histograms.begin() ? "\n" : ",\n" )
+            << "    \"" << it->first << "\": ";
+        writeHistogramJSON( out, it->second );
+    }
+    out << "\n  }\n}\n";
+}
+void PdfeProfiler::writeTrace( std::ostream& out ) const
+{
+    QMutexLocker locker( &m_mutex );
+
+    // Complete events ("X"), timestamps in microseconds.
+    out << std::fixed << std::setprecision( 3 );
+    out << "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for( size_t i = 0 ; i < m_spans.size() ; ++i ) {
+        const Span& span = m_spans[i];
+        out << ( i ? ",\n" : "\n" )
+            << "  { \"name\": \"" << span.name << "\", \"ph\": \"X\", \"pid\": 1"
+            << ", \"tid\": " << span.thread
+            << ", \"ts\": " << span.start * 1e-3
+            << ", \"dur\": " << span.duration * 1e-3;
+        if( allocationsTracked() ) {
+            out << ", \"args\": { \"allocations\": " << span.allocs.count
+                << ", \"bytes\": " << span.allocs.bytes << " }";
+        }
+        out << " }";
+    }
+    // Counters final values, at the end of the trace.
+    std::map<std::string, qint64>::const_iterator it;
+    for( it = m_counters.begin() ; it != m_counters.end() ; ++it ) {
+        out << ( m_spans.empty() && it == m_counters.begin() ? "\n" : ",\n" )
+            << "  { \"name\": \"" << it->first << "\", \"ph\": \"C\", \"pid\": 1, \"tid\": 0"
+            << ", \"ts\": " << m_timer.nsecsElapsed() * 1e-3
+            << ", \"args\": { \"value\": " << it->second << " } }";
+    }
+    out << "\n] }\n";
+}
+bool PdfeProfiler::writeJSON( const QString& filename, const std::string& label ) const
+{
+    std::ofstream ofile( filename.toLocal8Bit().constData(), std::ios_base::out | std::ios_base::trunc );
+    if( !ofile ) {
+        return false;
+    }
+    this->writeJSON( ofile, label );
+    return true;
+}
+bool PdfeProfiler::writeTrace( const QString& filename ) const
+{
+    std::ofstream ofile( filename.toLocal8Bit().constData(), std::ios_base::out | std::ios_base::trunc );
+    if( !ofile ) {
+        return false;
+    }
+    this->writeTrace( ofile );
+    return true;
+}
+
+//**********************************************************//
+//                     PdfeProfilerScope                    //
+//**********************************************************//
+void PdfeProfilerScope::begin()
+{
+    m_pParent = t_pCurrentScope;
+    t_pCurrentScope = this;
+    m_allocsStart = PdfeProfiler::threadAllocations();
+    m_start = PdfeProfiler::instance().now();
+}
+void PdfeProfilerScope::end()
+{
+    PdfeProfiler& profiler = PdfeProfiler::instance();
+    qint64 duration = profiler.now() - m_start;
+    PdfeProfiler::Allocations allocsEnd = PdfeProfiler::threadAllocations();
+
+    // Self allocations: children excluded.
+    PdfeProfiler::Allocations allocs;
+    allocs.count = allocsEnd.count - m_allocsStart.count - m_allocsChildren.count;
+    allocs.bytes = allocsEnd.bytes - m_allocsStart.bytes - m_allocsChildren.bytes;
+    profiler.addSpan( m_name, m_start, duration, allocs );
+
+    // Profiler own allocations (addSpan) not attributed to the parent.
+    t_pCurrentScope = m_pParent;
+    if( m_pParent ) {
+        allocsEnd = PdfeProfiler::threadAllocations();
+        m_pParent->m_allocsChildren.count += allocsEnd.count - m_allocsStart.count;
+        m_pParent->m_allocsChildren.bytes += allocsEnd.bytes - m_allocsStart.bytes;
+    }
+}
+
+}
@@ -0,0 +1,264 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+#ifndef PDFEPROFILER_H
+#define PDFEPROFILER_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+
+namespace PoDoFoExtended {
+
+//**********************************************************//
+//                        PdfeProfiler                      //
+//**********************************************************//
+/** Lightweight instrumentation of the library: scoped spans (phases
+ * timing), monotonic counters and histograms of values.
+ * The profiler is disabled by default: instrumentation points then only
+ * test a boolean. Recording is thread-safe (mutex taken when enabled).
+ * Data can be exported as a JSON summary or as a Chrome trace-event file
+ * (chrome://tracing, Perfetto).
+ *
+ * Names of spans, counters and histograms must be string literals:
+ * only pointers are stored while recording.
+ * Instrumentation can be removed at compile time by defining
+ * PDFE_NO_PROFILING (c.f. PDFE_PROFILE_* macros).
+ *
+ * Allocation accounting: if built with PDFE_PROFILE_ALLOCATIONS, global
+ * operators new/delete count heap allocations per thread, and each span
+ * is attributed the allocations made while it is the innermost active
+ * span of its thread (children spans excluded).
+ */
+class PdfeProfiler
+{
+public:
+    /** Histogram of values: basic statistics and power-of-two buckets
+     * (bucket i contains values in [2^(i-1), 2^i), bucket 0 values < 1).
+     */
+    struct Histogram
+    {
+        /// Number of buckets.
+        static const size_t NbBuckets = 48;
+
+        size_t  count;
+        double  sum;
+        double  min;
+        double  max;
+        size_t  buckets[NbBuckets];
+
+        Histogram();
+        /// Add a value.
+        void add( double value );
+        /// Mean value.
+        double mean() const     {   return count ? sum / count : 0.0;   }
+    };
+
+    /** Heap allocations counters.
+     */
+    struct Allocations
+    {
+        /// Number of allocations.
+        qint64  count;
+        /// Number of bytes allocated.
+        qint64  bytes;
+
+        Allocations() : count( 0 ), bytes( 0 ) { }
+    };
+
+public:
+    /// Global profiler.
+    static PdfeProfiler& instance();
+
+    /// Is the profiler enabled?
+    bool isEnabled() const      {   return m_enabled;   }
+    /// Enable or disable the profiler.
+    void setEnabled( bool enabled );
+    /// Clear recorded data (e.g. between two documents).
+    void clear();
+
+    /// Current time (nanoseconds since the profiler creation).
+    qint64 now() const          {   return m_timer.nsecsElapsed();  }
+    /** Record a span. Durations are also added to a histogram
+     * (microseconds) of the same name.
+     * \param name Name of the span (literal).
+     * \param start Start time (c.f. now()).
+     * \param duration Duration, in nanoseconds.
+     */
+    void addSpan( const char* name, qint64 start, qint64 duration );
+    /** Record a span and the allocations attributed to it.
+     * \param name Name of the span (literal).
+     * \param start Start time (c.f. now()).
+     * \param duration Duration, in nanoseconds.
+     * \param allocs Allocations made by the span (children excluded).
+     */
+    void addSpan( const char* name, qint64 start, qint64 duration,
+                  const Allocations& allocs );
+    /** Increment a counter.
+     * \param name Name of the counter (literal).
+     * \param value Increment.
+     */
+    void addCounter( const char* name, qint64 value = 1 );
+    /** Add a value to a histogram.
+     * \param name Name of the histogram (literal).
+     * \param value Value to add.
+     */
+    void addValue( const char* name, double value );
+
+    /// Are allocations counted (built with PDFE_PROFILE_ALLOCATIONS)?
+    static bool allocationsTracked();
+    /// Allocations made by the current thread since its creation.
+    static Allocations threadAllocations();
+
+    /** Write a JSON summary: spans statistics, allocations, counters and histograms.
+     * \param out Output stream.
+     * \param label Label of the run (document name, ...).
+     */
+    void writeJSON( std::ostream& out, const std::string& label ) const;
+    /** Write spans in the Chrome trace-event format.
+     * \param out Output stream.
+     */
+    void writeTrace( std::ostream& out ) const;
+    /// Write JSON summary to a file. Return false if it can not be opened.
+    bool writeJSON( const QString& filename, const std::string& label ) const;
+    /// Write Chrome trace to a file. Return false if it can not be opened.
+    bool writeTrace( const QString& filename ) const;
+
+    /// Maximum number of spans kept for the trace (statistics are always updated).
+    size_t maxSpans() const                 {   return m_maxSpans;  }
+    /// Set the maximum number of spans kept for the trace.
+    void setMaxSpans( size_t maxSpans )     {   m_maxSpans = maxSpans;  }
+
+private:
+    PdfeProfiler();
+    PdfeProfiler( const PdfeProfiler& );
+    PdfeProfiler& operator=( const PdfeProfiler& );
+
+    /// Span recorded for the trace.
+    struct Span
+    {
+        const char*  name;
+        qint64  start;
+        qint64  duration;
+        /// Thread index (order of first appearance).
+        size_t  thread;
+        /// Allocations attributed to the span.
+        Allocations  allocs;
+    };
+    /// Index of the current thread.
+    size_t threadIndex();
+
+private:
+    /// Enabled? Read without lock by instrumentation points.
+    volatile bool  m_enabled;
+    /// Mutex protecting the data.
+    mutable QMutex  m_mutex;
+    /// Time reference.
+    QElapsedTimer  m_timer;
+
+    /// Spans (trace).
+    std::vector<Span>  m_spans;
+    /// Maximum number of spans.
+    size_t  m_maxSpans;
+    /// Threads identifiers.
+    std::vector<Qt::HANDLE>  m_threads;
+    /// Spans statistics (durations in microseconds).
+    std::map<std::string, Histogram>  m_spansStats;
+    /// Allocations attributed to spans, by name.
+    std::map<std::string, Allocations>  m_spansAllocs;
+    /// Counters.
+    std::map<std::string, qint64>  m_counters;
+    /// Histograms.
+    std::map<std::string, Histogram>  m_histograms;
+};
+
+//**********************************************************//
+//                     PdfeProfilerScope                    //
+//**********************************************************//
+/** Scoped span: records the time spent (and allocations made) between
+ * construction and destruction, if the profiler is enabled at construction.
+ */
+class PdfeProfilerScope
+{
+public:
+    explicit PdfeProfilerScope( const char* name ) :
+        m_name( name ), m_start( -1 ), m_pParent( NULL )
+    {
+        if( PdfeProfiler::instance().isEnabled() ) {
+            this->begin();
+        }
+    }
+    ~PdfeProfilerScope()
+    {
+        if( m_start >= 0 ) {
+            this->end();
+        }
+    }
+
+private:
+    PdfeProfilerScope( const PdfeProfilerScope& );
+    PdfeProfilerScope& operator=( const PdfeProfilerScope& );
+
+    /// Start recording: time, allocations and parent scope.
+    void begin();
+    /// End recording and add the span to the profiler.
+    void end();
+
+private:
+    /// Name of the span.
+    const char*  m_name;
+    /// Start time (-1 if disabled).
+    qint64  m_start;
+    /// Thread allocations at start.
+    PdfeProfiler::Allocations  m_allocsStart;
+    /// Allocations of children scopes.
+    PdfeProfiler::Allocations  m_allocsChildren;
+    /// Parent scope in the current thread.
+    PdfeProfilerScope*  m_pParent;
+};
+
+}
+
+//**********************************************************//
+//                    Instrumentation macros                //
+//**********************************************************//
+#ifndef PDFE_NO_PROFILING
+#define PDFE_PROFILE_CONCAT_( a, b )    a##b
+#define PDFE_PROFILE_CONCAT( a, b )     PDFE_PROFILE_CONCAT_( a, b )
+/// Scoped span until the end of the current block.
+#define PDFE_PROFILE_SCOPE( name ) \
+    PoDoFoExtended::PdfeProfilerScope PDFE_PROFILE_CONCAT( pdfeProfilerScope, __LINE__ )( name )
+/// Increment a counter.
+#define PDFE_PROFILE_COUNTER( name, value ) \
+    do { \
+        if( PoDoFoExtended::PdfeProfiler::instance().isEnabled() ) { \
+            PoDoFoExtended::PdfeProfiler::instance().addCounter( name, value ); \
+        } \
+    } while( 0 )
+/// Add a value to a histogram.
+#define PDFE_PROFILE_VALUE( name, value ) \
+    do { \
+        if( PoDoFoExtended::PdfeProfiler::instance().isEnabled() ) { \
+            PoDoFoExtended::PdfeProfiler::instance().addValue( name, value ); \
+        } \
+    } while( 0 )
+#else
+#define PDFE_PROFILE_SCOPE( name )
+#define PDFE_PROFILE_COUNTER( name, value )     do { } while( 0 )
+#define PDFE_PROFILE_VALUE( name, value )       do { } while( 0 )
+#endif
+
+#endif // PDFEPROFILER_H
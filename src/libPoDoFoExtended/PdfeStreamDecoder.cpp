@@ -0,0 +1,214 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+
+#include "PdfeStreamDecoder.h"
+#include "PdfeUtils.h"
+
+#include <memory>
+#include <set>
+#include <boost/shared_ptr.hpp>
+
+#include <QtConcurrentRun>
+#include <QsLog/QsLog.h>
+#include <podofo/podofo.h>
+
+using namespace PoDoFo;
+
+namespace PoDoFoExtended {
+
+PdfeStreamDecoder::PdfeStreamDecoder() :
+    m_nbBytes( 0 )
+{
+}
+PdfeStreamDecoder::~PdfeStreamDecoder()
+{
+    this->clear();
+}
+
+void PdfeStreamDecoder::prefetch( PdfCanvas* pcanvas )
+{
+    std::vector<const PdfObject*> pObjects = contentsObjects( pcanvas );
+    for( size_t i = 0 ; i < pObjects.size() ; ++i ) {
+        this->prefetch( pObjects[i] );
+    }
+}
+void PdfeStreamDecoder::prefetch( const PdfObject* pobject )
+{
+    if( !pobject || !pobject->HasStream() ) {
+        return;
+    }
+    QMutexLocker locker( &m_mutex );
+    if( m_streams.count( pobject->Reference() ) ) {
+        return;
+    }
+    // Copy raw data, filters and decoding parameters in the calling thread.
+    PdfeData rawData;
+    TVecFilters filters;
+    PdfDictionary parms;
+    try {
+        char* pBuffer;
+        pdf_long length;
+        pobject->GetStream()->GetCopy( &pBuffer, &length );
+        boost::shared_ptr<char> spBuffer( pBuffer, free_ptr_fctor<char>() );
+        rawData = PdfeData( pBuffer, length );
+
+        filters = PdfFilterFactory::CreateFilterList( pobject );
+        const PdfObject* pParms = pobject->GetIndirectKey( "DecodeParms" );
+        if( pParms ) {
+            parms.AddKey( "DecodeParms", *pParms );
+        }
+    }
+    catch( const PdfError& ) {
+        // Synchronous decoding will raise the error properly.
+        return;
+    }
+    m_nbBytes.fetchAndAddOrdered( int( rawData.size() ) );
+    m_streams[ pobject->Reference() ] = QtConcurrent::run( &PdfeStreamDecoder::decode,
+                                                           rawData, filters, parms, &m_nbBytes );
+}
+
+bool PdfeStreamDecoder::take( const PdfObject* pobject, PdfeData& data )
+{
+    if( !pobject ) {
+        return false;
+    }
+    QFuture<Result> future;
+    {
+        QMutexLocker locker( &m_mutex );
+        std::map< PdfReference, QFuture<Result> >::iterator it;
+        it = m_streams.find( pobject->Reference() );
+        if( it == m_streams.end() ) {
+            return false;
+        }
+        future = it->second;
+        m_streams.erase( it );
+    }
+    // Wait for the job outside the lock.
+    Result result = this->release( future );
+    if( result.isValid ) {
+        data = result.data;
+    }
+    return result.isValid;
+}
+void PdfeStreamDecoder::discard( PdfCanvas* pcanvas )
+{
+    std::vector<const PdfObject*> pObjects = contentsObjects( pcanvas );
+    QMutexLocker locker( &m_mutex );
+    for( size_t i = 0 ; i < pObjects.size() ; ++i ) {
+        std::map< PdfReference, QFuture<Result> >::iterator it;
+        it = m_streams.find( pObjects[i]->Reference() );
+        if( it != m_streams.end() ) {
+            this->release( it->second );
+            m_streams.erase( it );
+        }
+    }
+}
+void PdfeStreamDecoder::retain( const std::vector<PdfCanvas*>& pcanvases )
+{
+    std::set<PdfReference> references;
+    for( size_t i = 0 ; i < pcanvases.size() ; ++i ) {
+        std::vector<const PdfObject*> pObjects = contentsObjects( pcanvases[i] );
+        for( size_t j = 0 ; j < pObjects.size() ; ++j ) {
+            references.insert( pObjects[j]->Reference() );
+        }
+    }
+    QMutexLocker locker( &m_mutex );
+    std::map< PdfReference, QFuture<Result> >::iterator it;
+    for( it = m_streams.begin() ; it != m_streams.end() ; ) {
+        if( !references.count( it->first ) ) {
+            this->release( it->second );
+            m_streams.erase( it++ );
+        }
+        else {
+            ++it;
+        }
+    }
+}
+void PdfeStreamDecoder::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    std::map< PdfReference, QFuture<Result> >::iterator it;
+    for( it = m_streams.begin() ; it != m_streams.end() ; ++it ) {
+        this->release( it->second );
+    }
+    m_streams.clear();
+}
+size_t PdfeStreamDecoder::size() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_streams.size();
+}
+
+PdfeStreamDecoder::Result PdfeStreamDecoder::release( QFuture<Result>& future )
+{
+    Result result = future.result();
+    m_nbBytes.fetchAndAddOrdered( -int( result.isValid ? result.data.size() : 0 ) );
+    return result;
+}
+PdfeStreamDecoder::Result PdfeStreamDecoder::decode( PdfeData rawData,
+                                                     TVecFilters filters,
+                                                     PdfDictionary parms,
+                                                     QAtomicInt* pnbBytes )
+{
+    Result result;
+    if( filters.empty() ) {
+        result.data = rawData;
+        result.isValid = true;
+        return result;
+    }
+    // Same decoding as PdfStream::GetFilteredCopy, without PoDoFo objects.
+    try {
+        PdfRefCountedBuffer buffer;
+        PdfBufferOutputStream stream( &buffer );
+        std::auto_ptr<PdfOutputStream> pDecodeStream(
+                    PdfFilterFactory::CreateDecodeStream( filters, &stream, &parms ) );
+        pDecodeStream->Write( rawData.data(), rawData.size() );
+        pDecodeStream->Close();
+
+        result.data = PdfeData( buffer.GetBuffer(), stream.GetLength() );
+        result.isValid = true;
+    }
+    catch( const PdfError& error ) {
+        QLOG_WARN() << QString( "<PdfeStreamDecoder> Error while decoding a contents stream (%1)." )
+                       .arg( error.what() ).toAscii().constData();
+        result.isValid = false;
+    }
+    // Accounted memory: from raw data to decoded data.
+    pnbBytes->fetchAndAddOrdered( int( result.isValid ? result.data.size() : 0 ) - int( rawData.size() ) );
+    return result;
+}
+
+std::vector<const PdfObject*> PdfeStreamDecoder::contentsObjects( PdfCanvas* pcanvas )
+{
+    std::vector<const PdfObject*> pObjects;
+    PdfObject* pContents = pcanvas ? pcanvas->GetContents() : NULL;
+    if( !pContents ) {
+        return pObjects;
+    }
+    if( pContents->IsArray() ) {
+        const PdfArray& contents = pContents->GetArray();
+        for( size_t i = 0 ; i < contents.size() ; ++i ) {
+            if( contents[i].IsReference() ) {
+                const PdfObject* pObject = pContents->GetOwner()->GetObject( contents[i].GetReference() );
+                if( pObject ) {
+                    pObjects.push_back( pObject );
+                }
+            }
+        }
+    }
+    else if( pContents->HasStream() ) {
+        pObjects.push_back( pContents );
+    }
+    return pObjects;
+}
+
+}
@@ -0,0 +1,145 @@
+/***************************************************************************
+ * Copyright (C) Paul Balança - All Rights Reserved                        *
+ *                                                                         *
+ * NOTICE:  All information contained herein is, and remains               *
+ * the property of Paul Balança. Dissemination of this information or      *
+ * reproduction of this material is strictly forbidden unless prior        *
+ * written permission is obtained from Paul Balança.                       *
+ *                                                                         *
+ * Written by Paul Balança <paul.balanca@gmail.com>, 2012                  *
+ ***************************************************************************/
+
+
+#ifndef PDFESTREAMDECODER_H
+#define PDFESTREAMDECODER_H
+
+#include <map>
+#include <vector>
+
+#include <QMutex>
+#include <QFuture>
+#include <QAtomicInt>
+
+#include <podofo/base/PdfReference.h>
+#include <podofo/base/PdfFilter.h>
+#include <podofo/base/PdfDictionary.h>
+
+#include "PdfeData.h"
+
+namespace PoDoFo {
+class PdfCanvas;
+class PdfObject;
+}
+
+namespace PoDoFoExtended {
+
+//**********************************************************//
+//                     PdfeStreamDecoder                    //
+//**********************************************************//
+/** Decode contents streams in advance, on the Qt global thread pool.
+ * Raw data and filters of the streams are copied in the calling thread,
+ * such that workers never access PoDoFo objects. Decoded buffers are then
+ * handed to PdfeStreamTokenizer, which falls back to a synchronous
+ * decoding for streams not prefetched (or whose decoding failed).
+ *
+ * The memory held (raw data of pending jobs, decoded data of finished
+ * ones) is accounted, such that the owner can bound it: entries never
+ * taken have to be discarded explicitly (c.f. retain and discard).
+ */
+class PdfeStreamDecoder
+{
+public:
+    /** Create an empty decoder.
+     */
+    PdfeStreamDecoder();
+    /** Destructor: wait for pending decoding jobs.
+     */
+    ~PdfeStreamDecoder();
+
+    /** Schedule the decoding of the contents streams of a canvas
+     * (every part of the /Contents array). Streams already scheduled
+     * are ignored.
+     * \param pcanvas Canvas (page, form,...).
+     */
+    void prefetch( PoDoFo::PdfCanvas* pcanvas );
+    /** Schedule the decoding of a stream object.
+     * \param pobject Stream object.
+     */
+    void prefetch( const PoDoFo::PdfObject* pobject );
+
+    /** Take the decoded data of a stream object. Block if the decoding
+     * is still pending. The entry is removed from the decoder.
+     * \param pobject Stream object.
+     * \param data Data object where to store the decoded stream.
+     * \return True if the stream was scheduled and correctly decoded.
+     */
+    bool take( const PoDoFo::PdfObject* pobject, PdfeData& data );
+    /** Discard the decoded streams of a canvas, e.g. when its
+     * contents are modified.
+     * \param pcanvas Canvas (page, form,...).
+     */
+    void discard( PoDoFo::PdfCanvas* pcanvas );
+    /** Discard the decoded streams which do not belong to a set of
+     * canvases, e.g. pages out of the prefetching window.
+     * \param pcanvases Canvases whose streams are kept.
+     */
+    void retain( const std::vector<PoDoFo::PdfCanvas*>& pcanvases );
+    /** Discard every decoded stream (wait for pending jobs).
+     */
+    void clear();
+
+    /// Number of streams scheduled or decoded, not yet taken.
+    size_t size() const;
+    /// Memory held by streams scheduled or decoded, in bytes.
+    size_t nbBytes() const      {   return size_t( int( m_nbBytes ) );  }
+
+private:
+    /// Result of a decoding job.
+    struct Result {
+        /// Decoded data.
+        PdfeData  data;
+        /// Correctly decoded?
+        bool  isValid;
+
+        Result() : isValid( false ) { }
+    };
+    /** Decoding job, run by a worker. The memory accounted is updated
+     * from the raw size to the decoded size (0 if invalid).
+     * \param rawData Raw stream data.
+     * \param filters Filters to apply.
+     * \param parms Dictionary containing the /DecodeParms entry.
+     * \param pnbBytes Memory accounted by the decoder.
+     * \return Decoding result.
+     */
+    static Result decode( PdfeData rawData,
+                          PoDoFo::TVecFilters filters,
+                          PoDoFo::PdfDictionary parms,
+                          QAtomicInt* pnbBytes );
+    /** Wait for a job and remove its result from the memory accounted.
+     * \param future Decoding job.
+     * \return Decoding result.
+     */
+    Result release( QFuture<Result>& future );
+    /** Get the contents stream objects of a canvas.
+     * \param pcanvas Canvas (page, form,...).
+     * \return Vector of stream objects.
+     */
+    static std::vector<const PoDoFo::PdfObject*> contentsObjects( PoDoFo::PdfCanvas* pcanvas );
+
+private:
+    // No copy constructor and operator= allowed.
+    PdfeStreamDecoder( const PdfeStreamDecoder& rhs );
+    PdfeStreamDecoder& operator=( const PdfeStreamDecoder& rhs );
+
+private:
+    /// Decoding jobs, indexed by stream references.
+    std::map< PoDoFo::PdfReference, QFuture<Result> >  m_streams;
+    /// Mutex protecting the jobs map.
+    mutable QMutex  m_mutex;
+    /// Memory held by jobs (updated by workers).
+    QAtomicInt  m_nbBytes;
+};
+
+}
+
+#endif // PDFESTREAMDECODER_H
@@ -10,6 +10,7 @@
  ***************************************************************************/
 
 #include "PdfeStreamTokenizer.h"
+#include "PdfeStreamDecoder.h"
 
 #include "podofo/base/PdfCanvas.h"
 #include "podofo/base/PdfInputDevice.h"
@@ -31,8 +32,8 @@ using namespace PoDoFo;
 
 namespace PoDoFoExtended {
 
-PdfeStreamTokenizer::PdfeStreamTokenizer( PdfCanvas* pCanvas )
-    : PdfTokenizer(), m_readingInlineImgData( false )
+PdfeStreamTokenizer::PdfeStreamTokenizer( PdfCanvas* pCanvas, PdfeStreamDecoder* pDecoder )
+    : PdfTokenizer(), m_pDecoder( pDecoder ), m_readingInlineImgData( false )
 {
     if( !pCanvas )
     {
@@ -50,16 +51,16 @@ PdfeStreamTokenizer::PdfeStreamTokenizer( PdfCanvas* pCanvas )
                 PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "/Contents array contained non-references" );
             }
 
-            m_lstContents.push_back( pContents->GetOwner()->GetObject( (*it).GetReference() ) );
+            m_lstContents.push_back( DecodeContentsStream( pContents->GetOwner()->GetObject( (*it).GetReference() ) ) );
         }
     }
     else if ( pContents && pContents->HasStream() )
     {
-        m_lstContents.push_back( pContents );
+        m_lstContents.push_back( DecodeContentsStream( pContents ) );
     }
     else if ( pContents && pContents->IsDictionary() )
     {
-        m_lstContents.push_back( pContents );
+        m_lstContents.push_back( DecodeContentsStream( pContents ) );
         PdfError::LogMessage(eLogSeverity_Information,
                   "PdfContentsTokenizer: found canvas-dictionary without stream => empty page");
         // OC 18.09.2010 BugFix: Found an empty page in a PDF document:
@@ -82,22 +83,27 @@ PdfeStreamTokenizer::PdfeStreamTokenizer( PdfCanvas* pCanvas )
 
     if( m_lstContents.size() )
     {
-        SetCurrentContentsStream( m_lstContents.front() );
+        m_device = m_lstContents.front();
         m_lstContents.pop_front();
     }
 }
 
-void PdfeStreamTokenizer::SetCurrentContentsStream( PdfObject* pObject )
+PdfRefCountedInputDevice PdfeStreamTokenizer::DecodeContentsStream( PdfObject* pObject )
 {
     PODOFO_RAISE_LOGIC_IF( pObject == NULL, "Content stream object == NULL!" );
 
+    // Stream decoded in advance?
+    PdfeData data;
+    if( m_pDecoder && m_pDecoder->take( pObject, data ) ) {
+        return PdfRefCountedInputDevice( data.data(), data.size() );
+    }
     PdfStream* pStream = pObject->GetStream();
 
     PdfRefCountedBuffer buffer;
     PdfBufferOutputStream stream( &buffer );
     pStream->GetFilteredCopy( &stream );
 
-    m_device = PdfRefCountedInputDevice( buffer.GetBuffer(), buffer.GetSize() );
+    return PdfRefCountedInputDevice( buffer.GetBuffer(), buffer.GetSize() );
 }
 
 bool PdfeStreamTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
@@ -107,7 +113,7 @@ bool PdfeStreamTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* p
         if( !m_lstContents.size() )
             return false;
 
-        SetCurrentContentsStream( m_lstContents.front() );
+        m_device = m_lstContents.front();
         m_lstContents.pop_front();
         result = PdfTokenizer::GetNextToken(pszToken, peType);
     }
@@ -133,7 +139,7 @@ bool PdfeStreamTokenizer::ReadNext( PoDoFo::EPdfContentsType& type, PdfeGraphicO
     {
         if ( m_lstContents.size() ) {
             // We ran out of tokens in this stream. Switch to the next stream and try again.
-            SetCurrentContentsStream( m_lstContents.front() );
+            m_device = m_lstContents.front();
             m_lstContents.pop_front();
             return ReadNext( type, op, variant );
         }
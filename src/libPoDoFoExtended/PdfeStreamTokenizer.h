@@ -17,6 +17,8 @@
 
 namespace PoDoFoExtended {
 
+class PdfeStreamDecoder;
+
 /** This class is a parser for content streams in PDF documents.
  * Reimplementation of the class PdfContentsTokenizer with slight modifications
  * in the ReadNext function.
@@ -29,14 +31,17 @@ public:
      *  \param lLen length of the buffer.
      */
     PdfeStreamTokenizer( const char* pBuffer, long lLen )
-        : PoDoFo::PdfTokenizer( pBuffer, lLen ), m_readingInlineImgData(false)
+        : PoDoFo::PdfTokenizer( pBuffer, lLen ), m_pDecoder(NULL), m_readingInlineImgData(false)
     {
     }
 
     /** Construct a PdfeStreamTokenizer from a PdfCanvas (i.e. PdfPage or a PdfXObject).
+     *  Every contents stream is decoded at construction: the tokenizer does not
+     *  access PoDoFo objects afterwards (parsing can run without the document lock).
      *  \param pCanvas an object that hold a PDF contents stream
+     *  \param pDecoder optional decoder providing streams decoded in advance.
      */
-    PdfeStreamTokenizer( PoDoFo::PdfCanvas* pCanvas );
+    PdfeStreamTokenizer( PoDoFo::PdfCanvas* pCanvas, PdfeStreamDecoder* pDecoder = NULL );
 
     virtual ~PdfeStreamTokenizer() { }
 
@@ -92,18 +97,21 @@ public:
     void ReadName(std::string& variant );
 
  private:
-    /** Set another objects stream as the current stream for parsing.
-     *  \param pObject use the stream of this object for parsing.
+    /** Decode the stream of a contents object.
+     *  \param pObject contents object.
+     *  \return Input device on the decoded data.
      */
-    void SetCurrentContentsStream( PoDoFo::PdfObject* pObject );
+    PoDoFo::PdfRefCountedInputDevice DecodeContentsStream( PoDoFo::PdfObject* pObject );
 
     /** Read inline image in the current stream.
      */
     bool ReadInlineImgData( PoDoFo::EPdfContentsType& type, std::string& variant );
 
  private:
-    /// A list containing pointers to all contents objects.
-    std::list<PoDoFo::PdfObject*>  m_lstContents;
+    /// A list containing the decoded data of the next contents objects.
+    std::list<PoDoFo::PdfRefCountedInputDevice>  m_lstContents;
+    /// Decoder of streams (can be NULL).
+    PdfeStreamDecoder*  m_pDecoder;
 
     /// At stage of reading inline image data?
     bool m_readingInlineImgData;
@@ -25,15 +25,18 @@
 #include "PdfeGraphicsState.h"
 #include "PdfeGraphicsOperators.h"
 #include "PdfeMisc.h"
-#include "PdfeSemaphore.h"
 #include "PdfeResources.h"
 #include "PdfeStreamTokenizer.h"
+#include "PdfeStreamDecoder.h"
 #include "PdfeCanvasAnalysis.h"
 #include "PdfeUtils.h"
 #include "PdfeContentsStream.h"
 #include "PdfeContentsAnalysis.h"
+#include "PdfeContentsCache.h"
+#include "PdfeMappedFile.h"
 #include "PdfeGElement.h"
 #include "PdfePath.h"
 #include "PdfeTextElement.h"
+#include "PdfeProfiler.h"
 
 #endif // PODOFOEXTENDED_H
@@ -25,14 +25,18 @@ SOURCES += \
     PdfeGraphicsState.cpp \
     PdfeResources.cpp \
     PdfeStreamTokenizer.cpp \
+    PdfeStreamDecoder.cpp \
     PdfeCanvasAnalysis.cpp \
     PdfeUtils.cpp \
     PdfeContentsStream.cpp \
     PdfeContentsAnalysis.cpp \
+    PdfeContentsCache.cpp \
+    PdfeMappedFile.cpp \
     PdfeGElement.cpp \
     PdfePath.cpp \
     PdfeTextElement.cpp \
-    PdfeData.cpp
+    PdfeData.cpp \
+    PdfeProfiler.cpp
 
 HEADERS += \
     PdfeTypes.h \
@@ -47,15 +51,18 @@ HEADERS += \
     PdfeGraphicsState.h \
     PdfeGraphicsOperators.h \
     PdfeMisc.h \
-    PdfeSemaphore.h \
     PdfeResources.h \
     PdfeStreamTokenizer.h \
+    PdfeStreamDecoder.h \
     PdfeCanvasAnalysis.h \
     PdfeUtils.h \
     PdfeContentsStream.h \
     PdfeContentsAnalysis.h \
+    PdfeContentsCache.h \
+    PdfeMappedFile.h \
     PdfeGElement.h \
     PdfePath.h \
     PdfeTextElement.h \
     PdfeData.h \
+    PdfeProfiler.h \
     PoDoFoExtended.h